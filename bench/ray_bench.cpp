@@ -0,0 +1,328 @@
+// Microbenchmark of the ray/shape intersection kernels. Every shape is run
+// over random rays of three kinds (mostly hits, mostly misses and grazing
+// rays) through each path the renderer can take:
+//
+//   intersections  virtual GeometricShape::intersections (returns a vector)
+//   closestHit     virtual GeometricShape::closestHit
+//   directo        closestHit of the concrete class, resolved at compile time
+//   paquete        intersectPacket over packets of RayPacket::SIZE rays
+//   float          closestHit of the single precision kernels (PrimitiveStore)
+//   float paquete  their packet version
+//
+// and reports nanoseconds and heap allocations per intersection.
+
+#include "ray.hpp"
+#include "ray_packet.hpp"
+#include "geometry/sphere.hpp"
+#include "geometry/plane.hpp"
+#include "geometry/triangle.hpp"
+#include "geometry/primitive_store.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Heap allocations since the start of the program. The benchmark is single
+// threaded, so a plain counter is enough.
+static size_t allocations = 0;
+
+void* operator new(size_t size) {
+    ++allocations;
+    if (void* p = malloc(size ? size : 1)) {
+        return p;
+    }
+    throw bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+    free(p);
+}
+
+namespace {
+
+const double INF = numeric_limits<double>::infinity();
+
+// Rays with origin and target drawn by the case generators
+struct BenchCase {
+    string name;
+    vector<Ray> rays;
+};
+
+// Keeps the results alive so the compiler cannot drop the calls
+volatile double sink = 0.0;
+
+struct Measure {
+    double nsPerRay;
+    double allocationsPerRay;
+    double hitRate;
+};
+
+// Runs pass(rays) until at least minSeconds have gone by
+Measure measure(const vector<Ray>& rays, double minSeconds, const function<size_t(const vector<Ray>&)>& pass) {
+    pass(rays); // Warm up
+    size_t hits = 0, passes = 0;
+    size_t allocationsBefore = allocations;
+    auto start = chrono::steady_clock::now();
+    chrono::duration<double> elapsed(0);
+    do {
+        hits += pass(rays);
+        ++passes;
+        elapsed = chrono::steady_clock::now() - start;
+    } while (elapsed.count() < minSeconds);
+
+    const double calls = static_cast<double>(passes) * rays.size();
+    return { elapsed.count() * 1e9 / calls, (allocations - allocationsBefore) / calls, hits / calls };
+}
+
+template <typename Shape>
+void runShape(const string& shapeName, const Shape& shape, const vector<BenchCase>& cases, double minSeconds) {
+    const GeometricShape& base = shape;
+    PrimitiveStore store;
+    const PrimitiveStore::Ref ref = store.add(shape, 0);
+
+    for (const BenchCase& c : cases) {
+        struct Path {
+            const char* name;
+            function<size_t(const vector<Ray>&)> pass;
+        };
+        const Path paths[] = {
+            { "intersections", [&](const vector<Ray>& rays) {
+                size_t hits = 0;
+                for (const Ray& ray : rays) {
+                    vector<Point> points = base.intersections(ray);
+                    hits += !points.empty();
+                }
+                return hits;
+            } },
+            { "closestHit", [&](const vector<Ray>& rays) {
+                size_t hits = 0;
+                HitRecord hit{};
+                for (const Ray& ray : rays) {
+                    hits += base.closestHit(ray, 0.0, INF, hit);
+                }
+                sink = sink + hit.t;
+                return hits;
+            } },
+            { "directo", [&](const vector<Ray>& rays) {
+                size_t hits = 0;
+                HitRecord hit{};
+                for (const Ray& ray : rays) {
+                    hits += shape.Shape::closestHit(ray, 0.0, INF, hit);
+                }
+                sink = sink + hit.t;
+                return hits;
+            } },
+            { "paquete", [&](const vector<Ray>& rays) {
+                size_t hits = 0;
+                RayPacket packet;
+                for (size_t first = 0; first < rays.size(); first += RayPacket::SIZE) {
+                    packet.active = 0;
+                    for (int lane = 0; lane < RayPacket::SIZE && first + lane < rays.size(); ++lane) {
+                        packet.set(lane, rays[first + lane], INF);
+                    }
+                    shape.Shape::intersectPacket(packet, packet.active, 0.0, 0);
+                    for (int lane = 0; lane < RayPacket::SIZE; ++lane) {
+                        hits += (packet.active >> lane & 1) && packet.hit(lane);
+                    }
+                }
+                return hits;
+            } },
+            { "float", [&](const vector<Ray>& rays) {
+                size_t hits = 0;
+                HitRecord hit{};
+                for (const Ray& ray : rays) {
+                    const FloatRay floatRay(ray.o.x(), ray.o.y(), ray.o.z(), ray.d.x(), ray.d.y(), ray.d.z());
+                    hits += store.closestHit(ref, ray, floatRay, 0.0, INF, hit);
+                }
+                sink = sink + hit.t;
+                return hits;
+            } },
+            { "float paquete", [&](const vector<Ray>& rays) {
+                size_t hits = 0;
+                RayPacket packet;
+                for (size_t first = 0; first < rays.size(); first += RayPacket::SIZE) {
+                    packet.active = 0;
+                    for (int lane = 0; lane < RayPacket::SIZE && first + lane < rays.size(); ++lane) {
+                        packet.set(lane, rays[first + lane], INF);
+                    }
+                    FloatRayPacket floatRays(packet);
+                    store.intersectPacket(ref, floatRays, packet, packet.active, 0.0);
+                    floatRays.merge(packet);
+                    for (int lane = 0; lane < RayPacket::SIZE; ++lane) {
+                        hits += (packet.active >> lane & 1) && packet.hit(lane);
+                    }
+                }
+                return hits;
+            } },
+        };
+
+        for (const Path& path : paths) {
+            Measure m = measure(c.rays, minSeconds, path.pass);
+            printf("%-9s %-10s %-14s %10.2f %12.3f %10.3f\n", shapeName.c_str(), c.name.c_str(), path.name,
+                   m.nsPerRay, m.allocationsPerRay, m.hitRate);
+        }
+    }
+}
+
+// Rays from random points of the sphere of radius 10 around the origin
+// towards targets drawn by target()
+vector<Ray> raysTowards(mt19937_64& rng, size_t count, const function<Vector3d()>& target) {
+    normal_distribution<double> gauss;
+    vector<Ray> rays;
+    rays.reserve(count);
+    while (rays.size() < count) {
+        Vector3d origin(gauss(rng), gauss(rng), gauss(rng));
+        origin = 10.0 * origin.normalized();
+        Vector3d d = (target() - origin).normalized();
+        rays.emplace_back(Point(origin), Direction(d));
+    }
+    return rays;
+}
+
+// Random unit vector perpendicular to direction
+Vector3d perpendicular(mt19937_64& rng, const Vector3d& direction) {
+    normal_distribution<double> gauss;
+    Vector3d v(gauss(rng), gauss(rng), gauss(rng));
+    return (v - v.dot(direction) * direction).normalized();
+}
+
+vector<BenchCase> sphereCases(mt19937_64& rng, size_t count) {
+    // Unit sphere at the origin: targets inside the disc of radius 0.5,
+    // outside radius 1.5 and within 1e-6 of the silhouette
+    uniform_real_distribution<double> u(0.0, 1.0);
+    normal_distribution<double> gauss;
+    auto shell = [&](double rMin, double rMax) -> Vector3d {
+        Vector3d v(gauss(rng), gauss(rng), gauss(rng));
+        return v.normalized() * (rMin + (rMax - rMin) * u(rng));
+    };
+
+    vector<BenchCase> cases;
+    cases.push_back({ "aciertos", raysTowards(rng, count, [&]() { return shell(0.0, 0.5); }) });
+    cases.push_back({ "fallos", raysTowards(rng, count, [&]() { return shell(1.5, 5.0); }) });
+
+    // Grazing: rays towards the silhouette seen from their origin (the
+    // tangent point at distance 1/D along the axis), scaled by 1 +- 1e-6
+    vector<Ray> grazing;
+    while (grazing.size() < count) {
+        Vector3d origin = shell(10.0, 10.0);
+        Vector3d axis = origin.normalized();
+        Vector3d side = perpendicular(rng, axis);
+        double distance = origin.norm();
+        double r = 1.0 + 1e-6 * (2.0 * u(rng) - 1.0);
+        Vector3d silhouette = r * (axis / distance + side * sqrt(1.0 - 1.0 / (distance * distance)));
+        grazing.emplace_back(Point(origin), Direction((silhouette - origin).normalized()));
+    }
+    cases.push_back({ "rasantes", grazing });
+    return cases;
+}
+
+vector<BenchCase> planeCases(mt19937_64& rng, size_t count) {
+    // Plane z = 0: rays from above going down, going up, and almost parallel
+    uniform_real_distribution<double> u(-1.0, 1.0);
+    auto rays = [&](const function<Vector3d()>& direction) {
+        vector<Ray> result;
+        while (result.size() < count) {
+            Point origin(10.0 * u(rng), 10.0 * u(rng), 1.0 + u(rng) * 0.5);
+            result.emplace_back(origin, Direction(direction().normalized()));
+        }
+        return result;
+    };
+
+    vector<BenchCase> cases;
+    cases.push_back({ "aciertos", rays([&]() { return Vector3d(u(rng), u(rng), -1.0); }) });
+    cases.push_back({ "fallos", rays([&]() { return Vector3d(u(rng), u(rng), 1.0); }) });
+    cases.push_back({ "rasantes", rays([&]() { return Vector3d(u(rng), u(rng), 1e-7 * u(rng)); }) });
+    return cases;
+}
+
+vector<BenchCase> triangleCases(mt19937_64& rng, size_t count) {
+    // Triangle (0,0,0) (1,0,0) (0,1,0): targets inside, outside, and on its
+    // edges up to 1e-9
+    uniform_real_distribution<double> u(0.0, 1.0);
+    auto inside = [&]() {
+        double a = u(rng), b = u(rng);
+        if (a + b > 1.0) {
+            a = 1.0 - a;
+            b = 1.0 - b;
+        }
+        return Vector3d(a, b, 0.0);
+    };
+
+    vector<BenchCase> cases;
+    cases.push_back({ "aciertos", raysTowards(rng, count, inside) });
+    cases.push_back({ "fallos", raysTowards(rng, count, [&]() {
+        return Vector3d(1.5 + 3.0 * u(rng), 1.5 + 3.0 * u(rng), 0.0);
+    }) });
+    cases.push_back({ "rasantes", raysTowards(rng, count, [&]() {
+        // A point of one of the three edges, nudged across it
+        double s = u(rng), e = 1e-9 * (2.0 * u(rng) - 1.0);
+        switch (static_cast<int>(3.0 * u(rng))) {
+            case 0: return Vector3d(s, e, 0.0);
+            case 1: return Vector3d(e, s, 0.0);
+            default: return Vector3d(s + e, 1.0 - s + e, 0.0);
+        }
+    }) });
+    return cases;
+}
+
+void printUsage(const char* program) {
+    cout << "Uso: " << program << " [--rays n] [--time segundos] [--seed n]" << endl;
+    cout << "     --rays: rayos por caso (4096 por defecto)" << endl;
+    cout << "     --time: tiempo minimo de medida por caso y camino (0.2 s por defecto)" << endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t count = 4096;
+    double minSeconds = 0.2;
+    uint64_t seed = 1;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--rays" && i + 1 < argc) {
+            count = stoul(argv[++i]);
+        } else if (arg == "--time" && i + 1 < argc) {
+            minSeconds = stod(argv[++i]);
+        } else if (arg == "--seed" && i + 1 < argc) {
+            seed = stoull(argv[++i]);
+        } else {
+            printUsage(argv[0]);
+            return arg == "-h" || arg == "--help" ? 0 : 1;
+        }
+    }
+
+    mt19937_64 rng(seed);
+    Sphere sphere(Point(0, 0, 0), 1.0);
+    Plane plane(Direction(0, 0, 1), Point(0, 0, 0));
+    Triangle triangle(Point(0, 0, 0), Point(1, 0, 0), Point(0, 1, 0));
+
+    printf("%-9s %-10s %-14s %10s %12s %10s\n", "forma", "caso", "camino", "ns/rayo", "allocs/rayo", "aciertos");
+    runShape("esfera", sphere, sphereCases(rng, count), minSeconds);
+    runShape("plano", plane, planeCases(rng, count), minSeconds);
+    runShape("triangulo", triangle, triangleCases(rng, count), minSeconds);
+    return 0;
+}
@@ -0,0 +1,86 @@
+#ifndef BOUNDING_BOX_HPP
+#define BOUNDING_BOX_HPP
+
+#include "geometry.hpp"
+#include <algorithm>
+#include <limits>
+
+// Axis aligned bounding box. Small and called from the traversal inner
+// loops, so it is implemented inline.
+class BoundingBox {
+    public:
+        Vector3d min;
+        Vector3d max;
+
+        // Empty box (expanding it with anything yields that thing)
+        BoundingBox()
+            : min(Vector3d::Constant(std::numeric_limits<double>::infinity())),
+              max(Vector3d::Constant(-std::numeric_limits<double>::infinity())) {}
+        BoundingBox(const Vector3d& min_, const Vector3d& max_) : min(min_), max(max_) {}
+
+        static BoundingBox infinite() {
+            const double inf = std::numeric_limits<double>::infinity();
+            return BoundingBox(Vector3d::Constant(-inf), Vector3d::Constant(inf));
+        }
+
+        // Bounds of a disc given its center, unit normal and radius
+        static BoundingBox disc(const Vector3d& center, const Vector3d& normal, double radius) {
+            Vector3d e = radius * (Vector3d::Ones() - normal.cwiseProduct(normal)).cwiseMax(0.0).cwiseSqrt();
+            return BoundingBox(center - e, center + e);
+        }
+
+        bool empty() const { return min.x() > max.x() || min.y() > max.y() || min.z() > max.z(); }
+
+        void expand(const Vector3d& p) {
+            min = min.cwiseMin(p);
+            max = max.cwiseMax(p);
+        }
+
+        void expand(const BoundingBox& other) {
+            min = min.cwiseMin(other.min);
+            max = max.cwiseMax(other.max);
+        }
+
+        // Box between a (t = 0) and b (t = 1). A point moving linearly from
+        // inside a to inside b stays inside the interpolated box.
+        static BoundingBox lerp(const BoundingBox& a, const BoundingBox& b, double t) {
+            return BoundingBox(a.min + t * (b.min - a.min), a.max + t * (b.max - a.max));
+        }
+
+        bool contains(const BoundingBox& other) const {
+            return (other.min.array() >= min.array()).all() && (other.max.array() <= max.array()).all();
+        }
+
+        Vector3d centroid() const { return 0.5 * (min + max); }
+
+        Vector3d extent() const { return max - min; }
+
+        double surfaceArea() const {
+            if (empty()) {
+                return 0.0;
+            }
+            Vector3d e = extent();
+            return 2.0 * (e.x() * e.y() + e.y() * e.z() + e.z() * e.x());
+        }
+
+        // Slab test. invDir holds 1/d per axis; on a hit tEntry is the entry distance.
+        bool intersect(const Vector3d& origin, const Vector3d& invDir, double tMin, double tMax, double& tEntry) const {
+            for (int axis = 0; axis < 3; ++axis) {
+                double t0 = (min[axis] - origin[axis]) * invDir[axis];
+                double t1 = (max[axis] - origin[axis]) * invDir[axis];
+                if (t0 > t1) {
+                    std::swap(t0, t1);
+                }
+                // Written so that NaN (0 * inf) never shrinks the interval
+                tMin = t0 > tMin ? t0 : tMin;
+                tMax = t1 < tMax ? t1 : tMax;
+                if (tMin > tMax) {
+                    return false;
+                }
+            }
+            tEntry = tMin;
+            return true;
+        }
+};
+
+#endif // BOUNDING_BOX_HPP
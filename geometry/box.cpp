@@ -0,0 +1,146 @@
+#include "box.hpp"
+#include "../ray.hpp"
+#include "../ray_packet.hpp"
+#include <cmath>
+#include <iostream>
+#include <limits>
+
+using namespace std;
+
+namespace {
+
+const double INF = numeric_limits<double>::infinity();
+
+// Slab test on a ray already in the frame of the box. Gives the entry and
+// exit distances and the axis (0, 1, 2) of the slab that bounds each one.
+inline void slabs(const Vector3d& half, const double o[3], const double d[3],
+                  double& tNear, int& nearAxis, double& tFar, int& farAxis) {
+    tNear = -INF; tFar = INF;
+    nearAxis = 0; farAxis = 0;
+    for (int axis = 0; axis < 3; ++axis) {
+        double inv = 1.0 / d[axis];
+        double t0 = (-half[axis] - o[axis]) * inv;
+        double t1 = (half[axis] - o[axis]) * inv;
+        double lo = t0 < t1 ? t0 : t1;
+        double hi = t0 < t1 ? t1 : t0;
+        // Written so that NaN (0 * inf) never shrinks the interval
+        nearAxis = lo > tNear ? axis : nearAxis;
+        tNear = lo > tNear ? lo : tNear;
+        farAxis = hi < tFar ? axis : farAxis;
+        tFar = hi < tFar ? hi : tFar;
+    }
+}
+
+// Closest distance in [tMin, tMax] (infinity if none) and the outward local
+// normal there: the entry face, or the exit face for rays starting inside
+inline double boxDistance(const Vector3d& half, const double o[3], const double d[3],
+                          double tMin, double tMax, double n[3]) {
+    double tNear, tFar;
+    int nearAxis, farAxis;
+    slabs(half, o, d, tNear, nearAxis, tFar, farAxis);
+
+    bool entering = tNear >= tMin;
+    double t = entering ? tNear : tFar;
+    int axis = entering ? nearAxis : farAxis;
+    double sign = copysign(1.0, d[axis]) * (entering ? -1.0 : 1.0);
+    n[0] = axis == 0 ? sign : 0.0;
+    n[1] = axis == 1 ? sign : 0.0;
+    n[2] = axis == 2 ? sign : 0.0;
+
+    bool valid = tNear <= tFar && t >= tMin && t <= tMax;
+    return valid ? t : INF;
+}
+
+} // namespace
+
+Box::Box(const Point& min, const Point& max)
+    : Box(Point((min.coords + max.coords) * 0.5), Direction(1, 0, 0), Direction(0, 1, 0),
+          (max.coords - min.coords) * 0.5) {}
+
+Box::Box(const Point& center, const Direction& u, const Direction& v, const Vector3d& halfSize) : half(halfSize) {
+    if (half.minCoeff() <= 0) {
+        throw invalid_argument("La caja debe tener un tamano positivo en cada eje.");
+    }
+    if (!(u.norm() > 0) || !(u.cross(v).norm() > 1e-9 * u.norm() * v.norm())) {
+        throw invalid_argument("Los ejes de la caja deben ser no nulos y no paralelos.");
+    }
+    Direction uu = u.normalized();
+    Direction vv = (v - uu * uu.dot(v)).normalized();
+    frame = LocalFrame(center, uu, vv, uu.cross(vv));
+}
+
+std::vector<Point> Box::intersections(const Ray& ray) const {
+    double o[3], d[3];
+    frame.pointToLocal(ray.o.x(), ray.o.y(), ray.o.z(), o[0], o[1], o[2]);
+    frame.directionToLocal(ray.d.x(), ray.d.y(), ray.d.z(), d[0], d[1], d[2]);
+
+    double tNear, tFar;
+    int nearAxis, farAxis;
+    slabs(half, o, d, tNear, nearAxis, tFar, farAxis);
+
+    vector<Point> intersectionPoints;
+    if (tNear > tFar) {
+        return intersectionPoints;
+    }
+    if (tNear >= 0) {
+        intersectionPoints.push_back(ray.o + ray.d * tNear);
+    }
+    if (tFar >= 0 && tFar != tNear) {
+        intersectionPoints.push_back(ray.o + ray.d * tFar);
+    }
+    return intersectionPoints;
+}
+
+bool Box::closestHit(const Ray& ray, double tMin, double tMax, HitRecord& hit) const {
+    double o[3], d[3], n[3];
+    frame.pointToLocal(ray.o.x(), ray.o.y(), ray.o.z(), o[0], o[1], o[2]);
+    frame.directionToLocal(ray.d.x(), ray.d.y(), ray.d.z(), d[0], d[1], d[2]);
+
+    double t = boxDistance(half, o, d, tMin, tMax, n);
+    if (t == INF) {
+        return false;
+    }
+
+    double nx, ny, nz;
+    frame.directionToWorld(n[0], n[1], n[2], nx, ny, nz);
+    hit.t = t;
+    hit.point = ray.o + ray.d * t;
+    hit.normal = Direction(nx, ny, nz);
+    return true;
+}
+
+void Box::intersectPacket(RayPacket& packet, uint32_t mask, double tMin, int shapeIndex) const {
+    for (int i = 0; i < RayPacket::SIZE; ++i) {
+        double o[3], d[3], n[3];
+        frame.pointToLocal(packet.ox[i], packet.oy[i], packet.oz[i], o[0], o[1], o[2]);
+        frame.directionToLocal(packet.dx[i], packet.dy[i], packet.dz[i], d[0], d[1], d[2]);
+        double t = boxDistance(half, o, d, tMin, packet.t[i], n);
+
+        double nx, ny, nz;
+        frame.directionToWorld(n[0], n[1], n[2], nx, ny, nz);
+        bool valid = ((mask >> i) & 1u) && t != INF;
+        packet.t[i] = valid ? t : packet.t[i];
+        packet.nx[i] = valid ? nx : packet.nx[i];
+        packet.ny[i] = valid ? ny : packet.ny[i];
+        packet.nz[i] = valid ? nz : packet.nz[i];
+        packet.shape[i] = valid ? shapeIndex : packet.shape[i];
+    }
+}
+
+BoundingBox Box::bounds() const {
+    // Projection of the three half axes on every world axis
+    Vector3d e(fabs(frame.ux) * half.x() + fabs(frame.vx) * half.y() + fabs(frame.wx) * half.z(),
+               fabs(frame.uy) * half.x() + fabs(frame.vy) * half.y() + fabs(frame.wy) * half.z(),
+               fabs(frame.uz) * half.x() + fabs(frame.vz) * half.y() + fabs(frame.wz) * half.z());
+    Vector3d c = frame.origin().coords;
+    return BoundingBox(c - e, c + e);
+}
+
+void Box::print() const {
+    if (axisAligned()) {
+        cout << "Box: min=" << Point(frame.origin().coords - half) << ", max=" << Point(frame.origin().coords + half) << endl;
+    } else {
+        cout << "Box: center=" << frame.origin() << ", u=" << frame.u() << ", v=" << frame.v()
+             << ", half=" << Point(half) << endl;
+    }
+}
@@ -0,0 +1,37 @@
+#ifndef BOX_HPP
+#define BOX_HPP
+
+#include "geometry.hpp"
+#include "geometric_shape.hpp"
+#include "local_frame.hpp"
+
+// Box given by its center, three orthonormal axes and the half size along
+// each of them. An axis aligned box is the case of the world axes; both are
+// intersected with the same slab test, done in the frame of the box.
+class Box : public GeometricShape {
+    public:
+        LocalFrame frame; // Origin at the center
+        Vector3d half;    // Half size along u, v, w
+
+        // Axis aligned box between two opposite corners
+        Box(const Point& min, const Point& max);
+
+        // Oriented box. v is made orthogonal to u, and w = u x v
+        Box(const Point& center, const Direction& u, const Direction& v, const Vector3d& halfSize);
+
+        std::vector<Point> intersections(const Ray& ray) const override;
+
+        // Closest intersection in [tMin, tMax]
+        bool closestHit(const Ray& ray, double tMin, double tMax, HitRecord& hit) const override;
+
+        // Lane by lane version over a ray packet
+        void intersectPacket(RayPacket& packet, uint32_t mask, double tMin, int shapeIndex) const override;
+
+        BoundingBox bounds() const override;
+
+        bool axisAligned() const { return frame.ux == 1 && frame.vy == 1 && frame.wz == 1; }
+
+        void print() const override;
+};
+
+#endif // BOX_HPP
@@ -0,0 +1,501 @@
+#include "bvh.hpp"
+#include <algorithm>
+#include <limits>
+
+using namespace std;
+
+namespace {
+
+// Number of bins per axis used to evaluate the surface area heuristic
+const int SAH_BINS = 16;
+
+// Relative cost of traversing a node against intersecting a primitive
+const double TRAVERSAL_COST = 1.0;
+
+// Growth of the area of a node, since its subtree was built, at which the
+// incremental updates rebuild the subtree
+const double REBUILD_GROWTH = 2.0;
+
+struct Bin {
+    BoundingBox box;
+    int count = 0;
+};
+
+} // namespace
+
+void BVH::build(const vector<BoundingBox>& primBounds, int maxLeafSize) {
+    nodes.clear();
+    closeBoxes.clear();
+    parents.clear();
+    heights.clear();
+    builtArea.clear();
+    leafOf.clear();
+    unusedNodes = 0;
+    leafSize = max(1, maxLeafSize);
+    primIndices.resize(primBounds.size());
+    if (primBounds.empty()) {
+        return;
+    }
+
+    vector<Vector3d> centroids(primBounds.size());
+    for (size_t i = 0; i < primBounds.size(); ++i) {
+        primIndices[i] = static_cast<int>(i);
+        centroids[i] = primBounds[i].centroid();
+    }
+
+    nodes.reserve(2 * primBounds.size());
+    nodes.push_back({ BoundingBox(), 0, static_cast<int>(primBounds.size()) });
+    subdivide(0, primBounds, centroids, max(1, maxLeafSize), 1);
+    nodes.shrink_to_fit();
+}
+
+void BVH::build(const vector<BoundingBox>& openBounds, const vector<BoundingBox>& closeBounds, int maxLeafSize) {
+    vector<BoundingBox> swept(openBounds);
+    for (size_t i = 0; i < swept.size(); ++i) {
+        swept[i].expand(closeBounds[i]);
+    }
+    build(swept, maxLeafSize);
+    if (nodes.empty()) {
+        return;
+    }
+
+    // Children always come after their parent, so a backwards pass refits
+    // every node from finished children
+    closeBoxes.resize(nodes.size());
+    for (int i = static_cast<int>(nodes.size()) - 1; i >= 0; --i) {
+        BVHNode& node = nodes[i];
+        BoundingBox open, close;
+        if (node.isLeaf()) {
+            for (int j = node.leftFirst; j < node.leftFirst + node.count; ++j) {
+                open.expand(openBounds[primIndices[j]]);
+                close.expand(closeBounds[primIndices[j]]);
+            }
+        } else {
+            for (int child = node.leftFirst; child < node.leftFirst + 2; ++child) {
+                open.expand(nodes[child].box);
+                close.expand(closeBoxes[child]);
+            }
+        }
+        node.box = open;
+        closeBoxes[i] = close;
+    }
+}
+
+void BVH::subdivide(int nodeIndex, const vector<BoundingBox>& primBounds,
+                    const vector<Vector3d>& centroids, int maxLeafSize, int depth) {
+    BVHNode& node = nodes[nodeIndex];
+    const int first = node.leftFirst;
+    const int count = node.count;
+
+    BoundingBox centroidBox;
+    node.box = BoundingBox();
+    for (int i = first; i < first + count; ++i) {
+        node.box.expand(primBounds[primIndices[i]]);
+        centroidBox.expand(centroids[primIndices[i]]);
+    }
+
+    if (count <= 1 || depth >= MAX_DEPTH) {
+        return;
+    }
+
+    // Find the best split plane among the bin boundaries of every axis
+    int bestAxis = -1, bestSplit = 0;
+    double bestCost = numeric_limits<double>::infinity();
+    for (int axis = 0; axis < 3; ++axis) {
+        double lo = centroidBox.min[axis], hi = centroidBox.max[axis];
+        if (hi <= lo) {
+            continue;
+        }
+
+        Bin bins[SAH_BINS];
+        double scale = SAH_BINS / (hi - lo);
+        for (int i = first; i < first + count; ++i) {
+            int prim = primIndices[i];
+            int b = min(SAH_BINS - 1, static_cast<int>((centroids[prim][axis] - lo) * scale));
+            bins[b].count++;
+            bins[b].box.expand(primBounds[prim]);
+        }
+
+        // Sweep from both sides accumulating areas and counts
+        double leftArea[SAH_BINS - 1], rightArea[SAH_BINS - 1];
+        int leftCount[SAH_BINS - 1], rightCount[SAH_BINS - 1];
+        BoundingBox leftBox, rightBox;
+        int leftSum = 0, rightSum = 0;
+        for (int b = 0; b < SAH_BINS - 1; ++b) {
+            leftSum += bins[b].count;
+            leftBox.expand(bins[b].box);
+            leftCount[b] = leftSum;
+            leftArea[b] = leftBox.surfaceArea();
+
+            rightSum += bins[SAH_BINS - 1 - b].count;
+            rightBox.expand(bins[SAH_BINS - 1 - b].box);
+            rightCount[SAH_BINS - 2 - b] = rightSum;
+            rightArea[SAH_BINS - 2 - b] = rightBox.surfaceArea();
+        }
+
+        for (int b = 0; b < SAH_BINS - 1; ++b) {
+            if (leftCount[b] == 0 || rightCount[b] == 0) {
+                continue;
+            }
+            double cost = leftCount[b] * leftArea[b] + rightCount[b] * rightArea[b];
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestAxis = axis;
+                bestSplit = b;
+            }
+        }
+    }
+
+    // All centroids coincide: no split can separate them
+    if (bestAxis < 0) {
+        return;
+    }
+
+    // Keep the leaf if splitting is not expected to pay off
+    double area = node.box.surfaceArea();
+    double splitCost = TRAVERSAL_COST + (area > 0 ? bestCost / area : 0);
+    if (count <= maxLeafSize && splitCost >= count) {
+        return;
+    }
+
+    double lo = centroidBox.min[bestAxis];
+    double scale = SAH_BINS / (centroidBox.max[bestAxis] - lo);
+    int* begin = primIndices.data() + first;
+    int* middle = partition(begin, begin + count, [&](int prim) {
+        int b = min(SAH_BINS - 1, static_cast<int>((centroids[prim][bestAxis] - lo) * scale));
+        return b <= bestSplit;
+    });
+    int leftCount = static_cast<int>(middle - begin);
+    if (leftCount == 0 || leftCount == count) {
+        return;
+    }
+
+    int leftChild = static_cast<int>(nodes.size());
+    nodes.push_back({ BoundingBox(), first, leftCount });
+    nodes.push_back({ BoundingBox(), first + leftCount, count - leftCount });
+
+    // push_back may have reallocated, do not use the node reference from here on
+    nodes[nodeIndex].leftFirst = leftChild;
+    nodes[nodeIndex].count = 0;
+
+    subdivide(leftChild, primBounds, centroids, maxLeafSize, depth + 1);
+    subdivide(leftChild + 1, primBounds, centroids, maxLeafSize, depth + 1);
+}
+
+void BVH::insert(int prim, const vector<BoundingBox>& primBounds) {
+    prepareUpdates();
+    if (prim >= static_cast<int>(leafOf.size())) {
+        leafOf.resize(prim + 1, -1);
+    }
+
+    const BoundingBox& box = primBounds[prim];
+    primIndices.push_back(prim);
+    const BVHNode leaf = { box, static_cast<int>(primIndices.size()) - 1, 1 };
+    if (nodes.empty()) {
+        nodes.push_back(leaf);
+        parents.push_back(-1);
+        heights.push_back(1);
+        builtArea.push_back(box.surfaceArea());
+        leafOf[prim] = 0;
+        return;
+    }
+
+    // Walk down while entering a child is cheaper than pairing with the
+    // current node: the areas every ancestor gains plus the new node's
+    int sibling = 0;
+    double inherited = 0.0;
+    while (!nodes[sibling].isLeaf()) {
+        const BVHNode& node = nodes[sibling];
+        BoundingBox merged = node.box;
+        merged.expand(box);
+        const double area = merged.surfaceArea();
+        const double pairCost = area + inherited;
+        inherited += area - node.box.surfaceArea();
+
+        int bestChild = -1;
+        double bestCost = numeric_limits<double>::infinity();
+        for (int child = node.leftFirst; child < node.leftFirst + 2; ++child) {
+            BoundingBox withChild = nodes[child].box;
+            withChild.expand(box);
+            double cost = inherited + withChild.surfaceArea();
+            if (!nodes[child].isLeaf()) {
+                cost -= nodes[child].box.surfaceArea();
+            }
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestChild = child;
+            }
+        }
+        if (pairCost <= bestCost) {
+            break;
+        }
+        sibling = bestChild;
+    }
+
+    // The sibling moves to a new pair of children next to the new leaf,
+    // and its slot becomes their parent
+    const int pair = static_cast<int>(nodes.size());
+    nodes.push_back(nodes[sibling]);
+    nodes.push_back(leaf);
+    parents.push_back(sibling);
+    parents.push_back(sibling);
+    heights.push_back(heights[sibling]);
+    heights.push_back(1);
+    builtArea.push_back(builtArea[sibling]);
+    builtArea.push_back(box.surfaceArea());
+    adopt(pair);
+    leafOf[prim] = pair + 1;
+
+    nodes[sibling].leftFirst = pair;
+    nodes[sibling].count = 0;
+    nodes[sibling].box.expand(box);
+    builtArea[sibling] = nodes[sibling].box.surfaceArea();
+    refitFrom(sibling, primBounds);
+
+    // The traversal stacks hold MAX_DEPTH levels
+    if (heights[0] > MAX_DEPTH) {
+        rebuildAll(primBounds);
+    }
+}
+
+void BVH::remove(int prim, const vector<BoundingBox>& primBounds) {
+    prepareUpdates();
+    if (prim < 0 || prim >= static_cast<int>(leafOf.size()) || leafOf[prim] < 0) {
+        return;
+    }
+
+    const int leaf = leafOf[prim];
+    leafOf[prim] = -1;
+    BVHNode& node = nodes[leaf];
+    int* begin = primIndices.data() + node.leftFirst;
+    swap(*find(begin, begin + node.count, prim), begin[node.count - 1]);
+    if (--node.count > 0) {
+        refitFrom(leaf, primBounds);
+        return;
+    }
+
+    const int parent = parents[leaf];
+    if (parent < 0) {
+        // It was the last primitive
+        nodes.clear();
+        primIndices.clear();
+        parents.clear();
+        heights.clear();
+        builtArea.clear();
+        unusedNodes = 0;
+        return;
+    }
+
+    // The sibling takes the place of the parent; the pair is left unused
+    const int sibling = leaf == nodes[parent].leftFirst ? leaf + 1 : leaf - 1;
+    nodes[parent] = nodes[sibling];
+    heights[parent] = heights[sibling];
+    builtArea[parent] = builtArea[sibling];
+    adopt(parent);
+    parents[leaf] = parents[sibling] = -1;
+    unusedNodes += 2;
+    if (parents[parent] >= 0) {
+        refitFrom(parents[parent], primBounds);
+    }
+
+    if (unusedNodes > static_cast<int>(nodes.size()) - unusedNodes) {
+        rebuildAll(primBounds);
+    }
+}
+
+void BVH::refit(int prim, const vector<BoundingBox>& primBounds) {
+    prepareUpdates();
+    if (prim < 0 || prim >= static_cast<int>(leafOf.size()) || leafOf[prim] < 0) {
+        return;
+    }
+
+    // Away from its siblings the primitive would only stretch its ancestors
+    const int leaf = leafOf[prim];
+    if (parents[leaf] >= 0 && !nodes[parents[leaf]].box.contains(primBounds[prim])) {
+        remove(prim, primBounds);
+        insert(prim, primBounds);
+        return;
+    }
+    refitFrom(leaf, primBounds);
+}
+
+void BVH::renumber(int from, int to) {
+    prepareUpdates();
+    if (from < 0 || from >= static_cast<int>(leafOf.size()) || leafOf[from] < 0) {
+        return;
+    }
+    if (to >= static_cast<int>(leafOf.size())) {
+        leafOf.resize(to + 1, -1);
+    }
+
+    const BVHNode& node = nodes[leafOf[from]];
+    int* begin = primIndices.data() + node.leftFirst;
+    *find(begin, begin + node.count, from) = to;
+    leafOf[to] = leafOf[from];
+    leafOf[from] = -1;
+}
+
+void BVH::prepareUpdates() {
+    if (parents.size() == nodes.size()) {
+        return;
+    }
+
+    const size_t count = nodes.size();
+    parents.assign(count, -1);
+    heights.assign(count, 0);
+    builtArea.assign(count, 0.0);
+    int maxPrim = -1;
+    for (int prim : primIndices) {
+        maxPrim = max(maxPrim, prim);
+    }
+    leafOf.assign(maxPrim + 1, -1);
+    unusedNodes = 0;
+    if (!nodes.empty()) {
+        indexSubtree(0);
+    }
+}
+
+void BVH::indexSubtree(int node) {
+    // Preorder, so the reverse order has every child before its parent
+    vector<int> order;
+    vector<int> stack = { node };
+    while (!stack.empty()) {
+        int current = stack.back();
+        stack.pop_back();
+        order.push_back(current);
+        builtArea[current] = nodes[current].box.surfaceArea();
+        adopt(current);
+        if (!nodes[current].isLeaf()) {
+            stack.push_back(nodes[current].leftFirst);
+            stack.push_back(nodes[current].leftFirst + 1);
+        }
+    }
+    for (auto it = order.rbegin(); it != order.rend(); ++it) {
+        const BVHNode& current = nodes[*it];
+        heights[*it] = current.isLeaf() ? 1 : 1 + max(heights[current.leftFirst], heights[current.leftFirst + 1]);
+    }
+}
+
+void BVH::adopt(int node) {
+    const BVHNode& current = nodes[node];
+    if (current.isLeaf()) {
+        for (int i = current.leftFirst; i < current.leftFirst + current.count; ++i) {
+            leafOf[primIndices[i]] = node;
+        }
+    } else {
+        parents[current.leftFirst] = node;
+        parents[current.leftFirst + 1] = node;
+    }
+}
+
+int BVH::depthOf(int node) const {
+    int depth = 1;
+    for (int current = parents[node]; current >= 0; current = parents[current]) {
+        ++depth;
+    }
+    return depth;
+}
+
+void BVH::refitFrom(int node, const vector<BoundingBox>& primBounds) {
+    int grown = -1;
+    for (int current = node; current >= 0; current = parents[current]) {
+        BVHNode& n = nodes[current];
+        BoundingBox box;
+        int height = 1;
+        if (n.isLeaf()) {
+            for (int i = n.leftFirst; i < n.leftFirst + n.count; ++i) {
+                box.expand(primBounds[primIndices[i]]);
+            }
+        } else {
+            box = nodes[n.leftFirst].box;
+            box.expand(nodes[n.leftFirst + 1].box);
+            height = 1 + max(heights[n.leftFirst], heights[n.leftFirst + 1]);
+        }
+
+        // Nothing changes further up once a node is left as it was
+        const bool unchanged = current != node && box.min == n.box.min && box.max == n.box.max
+                               && height == heights[current];
+        n.box = box;
+        heights[current] = height;
+        if (unchanged) {
+            break;
+        }
+        if (box.surfaceArea() > REBUILD_GROWTH * builtArea[current]) {
+            grown = current;
+        }
+    }
+
+    if (grown >= 0) {
+        rebuildSubtree(grown, primBounds);
+    }
+}
+
+void BVH::rebuildSubtree(int node, const vector<BoundingBox>& primBounds) {
+    if (nodes[node].isLeaf()) {
+        builtArea[node] = nodes[node].box.surfaceArea();
+        return;
+    }
+
+    // Primitives of the subtree, whose nodes (but its root) become unused
+    vector<int> prims;
+    vector<int> stack = { nodes[node].leftFirst, nodes[node].leftFirst + 1 };
+    while (!stack.empty()) {
+        int current = stack.back();
+        stack.pop_back();
+        parents[current] = -1;
+        ++unusedNodes;
+        const BVHNode& n = nodes[current];
+        if (n.isLeaf()) {
+            prims.insert(prims.end(), primIndices.begin() + n.leftFirst, primIndices.begin() + n.leftFirst + n.count);
+        } else {
+            stack.push_back(n.leftFirst);
+            stack.push_back(n.leftFirst + 1);
+        }
+    }
+
+    // Centroids are looked up by primitive, but only these are read
+    vector<Vector3d> centroids(primBounds.size());
+    for (int prim : prims) {
+        centroids[prim] = primBounds[prim].centroid();
+    }
+
+    const int first = static_cast<int>(primIndices.size());
+    primIndices.insert(primIndices.end(), prims.begin(), prims.end());
+    nodes[node].leftFirst = first;
+    nodes[node].count = static_cast<int>(prims.size());
+    subdivide(node, primBounds, centroids, leafSize, depthOf(node));
+
+    parents.resize(nodes.size(), -1);
+    heights.resize(nodes.size(), 0);
+    builtArea.resize(nodes.size(), 0.0);
+    indexSubtree(node);
+    if (parents[node] >= 0) {
+        refitFrom(parents[node], primBounds);
+    }
+}
+
+void BVH::rebuildAll(const vector<BoundingBox>& primBounds) {
+    vector<int> prims;
+    for (int prim = 0; prim < static_cast<int>(leafOf.size()); ++prim) {
+        if (leafOf[prim] >= 0) {
+            prims.push_back(prim);
+        }
+    }
+
+    nodes.clear();
+    parents.clear();
+    heights.clear();
+    builtArea.clear();
+    primIndices = prims;
+    if (!prims.empty()) {
+        vector<Vector3d> centroids(primBounds.size());
+        for (int prim : prims) {
+            centroids[prim] = primBounds[prim].centroid();
+        }
+        nodes.reserve(2 * prims.size());
+        nodes.push_back({ BoundingBox(), 0, static_cast<int>(prims.size()) });
+        subdivide(0, primBounds, centroids, leafSize, 1);
+        nodes.shrink_to_fit();
+    }
+    prepareUpdates();
+}
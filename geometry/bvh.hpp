@@ -0,0 +1,348 @@
+#ifndef BVH_HPP
+#define BVH_HPP
+
+#include "bounding_box.hpp"
+#include "trace_counters.hpp"
+#include "../ray.hpp"
+#include "../ray_packet.hpp"
+#include <vector>
+
+// Node of a flattened BVH. Children are always allocated in pairs, so an
+// interior node only stores the index of its left child.
+struct BVHNode {
+    BoundingBox box;
+    int leftFirst; // Left child (interior node) or first entry in primIndices (leaf)
+    int count;     // Number of primitives in the leaf, 0 for interior nodes
+
+    bool isLeaf() const { return count > 0; }
+};
+
+// Bounding volume hierarchy over an arbitrary set of primitives, built with
+// a binned surface area heuristic. The BVH only knows the primitive bounds;
+// intersecting the primitives themselves is left to the caller.
+class BVH {
+    public:
+        // Depth limit of the hierarchy, which bounds the traversal stack
+        static const int MAX_DEPTH = 64;
+
+        std::vector<BVHNode> nodes;
+        std::vector<int> primIndices;
+
+        // Bounds of every node at shutter close, only for hierarchies over
+        // moving primitives (empty otherwise). nodes[i].box then holds the
+        // bounds at shutter open, and the traversals test the interpolation
+        // of both at the time of the ray (BoundingBox::lerp).
+        std::vector<BoundingBox> closeBoxes;
+
+        BVH() = default;
+
+        // Builds the hierarchy over primBounds (primitive i has bounds primBounds[i])
+        void build(const std::vector<BoundingBox>& primBounds, int maxLeafSize = 4);
+
+        // Builds the hierarchy over primitives with bounds openBounds[i] at
+        // shutter open and closeBounds[i] at shutter close. Nodes are split
+        // on the bounds of the whole motion, then refit to each end.
+        void build(const std::vector<BoundingBox>& openBounds, const std::vector<BoundingBox>& closeBounds,
+                   int maxLeafSize = 4);
+
+        // Incremental updates, for scenes that change a little at a time.
+        // primBounds holds the current bounds of every primitive, as in build
+        // (those not in the tree are ignored). Each update costs about the
+        // depth of the tree:
+        //  - insert walks down to the node that grows the least as the
+        //    sibling of the new leaf, and pairs them under a new node;
+        //  - remove lets the sibling of an emptied leaf take its parent's place;
+        //  - refit recomputes the boxes from the leaf of prim up to the root,
+        //    or reinserts prim if it has left the box of its parent.
+        // A subtree whose box grows past twice its area when it was built is
+        // rebuilt on its own with the SAH, and the whole tree once the nodes
+        // left unused by the updates outnumber the live ones.
+        // Only for hierarchies without motion (closeBoxes empty).
+        void insert(int prim, const std::vector<BoundingBox>& primBounds);
+        void remove(int prim, const std::vector<BoundingBox>& primBounds);
+        void refit(int prim, const std::vector<BoundingBox>& primBounds);
+
+        // Primitive from is renamed to (which must not be in the tree)
+        void renumber(int from, int to);
+
+        bool empty() const { return nodes.empty(); }
+
+        bool moving() const { return !closeBoxes.empty(); }
+
+        BoundingBox bounds() const {
+            if (nodes.empty()) {
+                return BoundingBox();
+            }
+            BoundingBox box = nodes[0].box;
+            if (moving()) {
+                box.expand(closeBoxes[0]);
+            }
+            return box;
+        }
+
+        // Closest hit traversal. hitPrimitive(int prim, double& tMax) must test
+        // the primitive in [tMin, tMax], shrink tMax and return true on a hit.
+        template <typename HitPrimitive>
+        bool traverse(const Ray& ray, double tMin, double& tMax, HitPrimitive&& hitPrimitive) const;
+
+        // Any hit traversal for occlusion queries: stops at the first
+        // primitive for which occludes(int prim) returns true. The interval
+        // never shrinks, so nodes are not ordered by distance.
+        template <typename Occludes>
+        bool traverseAny(const Ray& ray, double tMin, double tMax, Occludes&& occludes) const;
+
+        // Packet traversal: a node is entered when any lane of mask hits it.
+        // hitPrimitive(int prim, RayPacket::Mask lanes) tests the primitive
+        // against those lanes, updating their hits in the packet.
+        template <typename HitPrimitive>
+        void traversePacket(RayPacket& packet, RayPacket::Mask mask, double tMin, HitPrimitive&& hitPrimitive) const;
+
+    private:
+        // Box of a node at the time of the query
+        struct StaticBoxes {
+            const std::vector<BVHNode>& nodes;
+            const BoundingBox& operator()(int node) const { return nodes[node].box; }
+        };
+        struct MovingBoxes {
+            const BVH& bvh;
+            double time;
+            BoundingBox operator()(int node) const {
+                return BoundingBox::lerp(bvh.nodes[node].box, bvh.closeBoxes[node], time);
+            }
+        };
+
+        template <typename NodeBox, typename HitPrimitive>
+        bool traverseWith(const Ray& ray, double tMin, double& tMax, const NodeBox& box, HitPrimitive&& hitPrimitive) const;
+
+        template <typename NodeBox, typename Occludes>
+        bool traverseAnyWith(const Ray& ray, double tMin, double tMax, const NodeBox& box, Occludes&& occludes) const;
+
+        template <typename NodeBox, typename HitPrimitive>
+        void traversePacketWith(RayPacket& packet, RayPacket::Mask mask, double tMin, const NodeBox& box,
+                                HitPrimitive&& hitPrimitive) const;
+
+        void subdivide(int nodeIndex, const std::vector<BoundingBox>& primBounds,
+                       const std::vector<Vector3d>& centroids, int maxLeafSize, int depth);
+
+        // Largest leaf of the builds, for the rebuilds of the updates
+        int leafSize = 1;
+
+        // State of the incremental updates, set up by the first one
+        std::vector<int> parents;      // -1 for the root and unused nodes
+        std::vector<int> heights;      // Levels of the subtree (1 for a leaf)
+        std::vector<double> builtArea; // Area of the node when its subtree was built
+        std::vector<int> leafOf;       // Primitive -> leaf holding it, -1 outside the tree
+        int unusedNodes = 0;
+
+        void prepareUpdates();
+
+        // Parents, heights, built areas and leaves of the subtree below node
+        void indexSubtree(int node);
+
+        // Points the children (or primitives) of node back to it after a move
+        void adopt(int node);
+
+        int depthOf(int node) const;
+
+        // Boxes and heights from node up to the root, then rebuilds the
+        // highest subtree that grew too much on the way
+        void refitFrom(int node, const std::vector<BoundingBox>& primBounds);
+
+        // SAH build of the primitives below node in its place
+        void rebuildSubtree(int node, const std::vector<BoundingBox>& primBounds);
+
+        // SAH build of every primitive in the tree, dropping the unused nodes
+        void rebuildAll(const std::vector<BoundingBox>& primBounds);
+};
+
+template <typename HitPrimitive>
+bool BVH::traverse(const Ray& ray, double tMin, double& tMax, HitPrimitive&& hitPrimitive) const {
+    if (moving()) {
+        return traverseWith(ray, tMin, tMax, MovingBoxes{ *this, ray.time }, hitPrimitive);
+    }
+    return traverseWith(ray, tMin, tMax, StaticBoxes{ nodes }, hitPrimitive);
+}
+
+template <typename NodeBox, typename HitPrimitive>
+bool BVH::traverseWith(const Ray& ray, double tMin, double& tMax, const NodeBox& box, HitPrimitive&& hitPrimitive) const {
+    if (nodes.empty()) {
+        return false;
+    }
+
+    const Vector3d& origin = ray.o.coords;
+    const Vector3d invDir = ray.d.d.cwiseInverse();
+    bool hit = false;
+    INFGR_COUNT(TraceCounters& counters = TraceCounters::local());
+
+    struct Entry { int node; double t; };
+    Entry stack[MAX_DEPTH];
+    int stackSize = 0;
+    int current = 0;
+    double tEntry;
+    if (!box(0).intersect(origin, invDir, tMin, tMax, tEntry)) {
+        return false;
+    }
+
+    while (true) {
+        const BVHNode& node = nodes[current];
+        INFGR_COUNT(counters.nodesVisited++);
+        if (node.isLeaf()) {
+            for (int i = node.leftFirst; i < node.leftFirst + node.count; ++i) {
+                if (hitPrimitive(primIndices[i], tMax)) {
+                    hit = true;
+                }
+            }
+        } else {
+            // Visit the nearest child first and postpone the other one
+            int left = node.leftFirst, right = node.leftFirst + 1;
+            double tLeft, tRight;
+            bool hitLeft = box(left).intersect(origin, invDir, tMin, tMax, tLeft);
+            bool hitRight = box(right).intersect(origin, invDir, tMin, tMax, tRight);
+            if (hitLeft && hitRight) {
+                if (tRight < tLeft) {
+                    std::swap(left, right);
+                }
+                stack[stackSize++] = { right, std::max(tLeft, tRight) };
+                current = left;
+                continue;
+            }
+            if (hitLeft || hitRight) {
+                current = hitLeft ? left : right;
+                continue;
+            }
+        }
+
+        // Pop the next node that can still be closer than the current hit
+        current = -1;
+        while (stackSize > 0) {
+            const Entry& entry = stack[--stackSize];
+            if (entry.t <= tMax) {
+                current = entry.node;
+                break;
+            }
+        }
+        if (current < 0) {
+            break;
+        }
+    }
+
+    return hit;
+}
+
+template <typename Occludes>
+bool BVH::traverseAny(const Ray& ray, double tMin, double tMax, Occludes&& occludes) const {
+    if (moving()) {
+        return traverseAnyWith(ray, tMin, tMax, MovingBoxes{ *this, ray.time }, occludes);
+    }
+    return traverseAnyWith(ray, tMin, tMax, StaticBoxes{ nodes }, occludes);
+}
+
+template <typename NodeBox, typename Occludes>
+bool BVH::traverseAnyWith(const Ray& ray, double tMin, double tMax, const NodeBox& box, Occludes&& occludes) const {
+    if (nodes.empty()) {
+        return false;
+    }
+
+    const Vector3d& origin = ray.o.coords;
+    const Vector3d invDir = ray.d.d.cwiseInverse();
+    INFGR_COUNT(TraceCounters& counters = TraceCounters::local());
+
+    int stack[MAX_DEPTH];
+    int stackSize = 0;
+    int current = 0;
+    double tEntry;
+    if (!box(0).intersect(origin, invDir, tMin, tMax, tEntry)) {
+        return false;
+    }
+
+    while (true) {
+        const BVHNode& node = nodes[current];
+        INFGR_COUNT(counters.nodesVisited++);
+        if (node.isLeaf()) {
+            for (int i = node.leftFirst; i < node.leftFirst + node.count; ++i) {
+                if (occludes(primIndices[i])) {
+                    return true;
+                }
+            }
+        } else {
+            int left = node.leftFirst, right = node.leftFirst + 1;
+            bool hitLeft = box(left).intersect(origin, invDir, tMin, tMax, tEntry);
+            bool hitRight = box(right).intersect(origin, invDir, tMin, tMax, tEntry);
+            if (hitLeft && hitRight) {
+                stack[stackSize++] = right;
+                current = left;
+                continue;
+            }
+            if (hitLeft || hitRight) {
+                current = hitLeft ? left : right;
+                continue;
+            }
+        }
+
+        if (stackSize == 0) {
+            return false;
+        }
+        current = stack[--stackSize];
+    }
+}
+
+template <typename HitPrimitive>
+void BVH::traversePacket(RayPacket& packet, RayPacket::Mask mask, double tMin, HitPrimitive&& hitPrimitive) const {
+    if (moving()) {
+        traversePacketWith(packet, mask, tMin, MovingBoxes{ *this, packet.time }, hitPrimitive);
+    } else {
+        traversePacketWith(packet, mask, tMin, StaticBoxes{ nodes }, hitPrimitive);
+    }
+}
+
+template <typename NodeBox, typename HitPrimitive>
+void BVH::traversePacketWith(RayPacket& packet, RayPacket::Mask mask, double tMin, const NodeBox& box,
+                             HitPrimitive&& hitPrimitive) const {
+    if (nodes.empty() || !mask) {
+        return;
+    }
+
+    struct Entry { int node; RayPacket::Mask mask; };
+    Entry stack[MAX_DEPTH + 1];
+    int stackSize = 0;
+    INFGR_COUNT(TraceCounters& counters = TraceCounters::local());
+
+    double leadEntry;
+    mask = packet.intersectBox(box(0), tMin, mask, leadEntry);
+    if (!mask) {
+        return;
+    }
+    stack[stackSize++] = { 0, mask };
+
+    while (stackSize > 0) {
+        Entry entry = stack[--stackSize];
+        const BVHNode& node = nodes[entry.node];
+        INFGR_COUNT(counters.nodesVisited++);
+
+        if (node.isLeaf()) {
+            for (int i = node.leftFirst; i < node.leftFirst + node.count; ++i) {
+                hitPrimitive(primIndices[i], entry.mask);
+            }
+            continue;
+        }
+
+        // Children are tested only against the lanes that reached the parent,
+        // and the nearest one (for the first active lane) is visited first
+        double entryLeft, entryRight;
+        RayPacket::Mask maskLeft = packet.intersectBox(box(node.leftFirst), tMin, entry.mask, entryLeft);
+        RayPacket::Mask maskRight = packet.intersectBox(box(node.leftFirst + 1), tMin, entry.mask, entryRight);
+        Entry left = { node.leftFirst, maskLeft };
+        Entry right = { node.leftFirst + 1, maskRight };
+        if (maskLeft && maskRight && entryRight < entryLeft) {
+            std::swap(left, right);
+        }
+        if (right.mask) {
+            stack[stackSize++] = right;
+        }
+        if (left.mask) {
+            stack[stackSize++] = left;
+        }
+    }
+}
+
+#endif // BVH_HPP
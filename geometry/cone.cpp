@@ -0,0 +1,153 @@
+#include "cone.hpp"
+#include "../ray.hpp"
+#include "../ray_packet.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+
+using namespace std;
+
+namespace {
+
+const double INF = numeric_limits<double>::infinity();
+
+} // namespace
+
+Cone::Cone(const Point& base_, const Point& top_, double baseRadius_, double topRadius_)
+    : base(base_), top(top_), baseRadius(baseRadius_), topRadius(topRadius_) {
+    height = (top - base).norm();
+    if (!(height > 0)) {
+        throw invalid_argument("El eje del cono debe tener longitud positiva.");
+    }
+    if (baseRadius < 0 || topRadius < 0) {
+        throw invalid_argument("Los radios del cono no pueden ser negativos.");
+    }
+    if (baseRadius == 0 && topRadius == 0) {
+        throw invalid_argument("El cono debe tener algun radio positivo.");
+    }
+    frame = LocalFrame::around(base, (top - base) / height);
+    slope = (topRadius - baseRadius) / height;
+}
+
+void Cone::candidates(const double o[3], const double d[3], double t[4]) const {
+    // Side: (ox + t dx)^2 + (oy + t dy)^2 = (r(oz) + slope dz t)^2. Its second
+    // nappe lies beyond the apex, outside [0, height], so the z test drops it
+    const double r = baseRadius + slope * o[2];
+    const double sd = slope * d[2];
+    const double a = d[0] * d[0] + d[1] * d[1] - sd * sd;
+    const double halfB = o[0] * d[0] + o[1] * d[1] - r * sd;
+    const double c = o[0] * o[0] + o[1] * o[1] - r * r;
+    const double discriminant = halfB * halfB - a * c;
+
+    // Roots without cancellation; a = 0 (ray parallel to the side) leaves the
+    // single root c / q. Degenerate cases give inf or NaN and fail the tests.
+    const double q = -(halfB + copysign(sqrt(discriminant > 0 ? discriminant : 0.0), halfB));
+    const double s0 = q / a, s1 = c / q;
+    const double z0 = o[2] + s0 * d[2], z1 = o[2] + s1 * d[2];
+    t[0] = discriminant >= 0 && z0 >= 0 && z0 <= height ? s0 : INF;
+    t[1] = discriminant >= 0 && z1 >= 0 && z1 <= height ? s1 : INF;
+
+    // Caps
+    const double inv = 1.0 / d[2];
+    const double c0 = -o[2] * inv, c1 = (height - o[2]) * inv;
+    const double x0 = o[0] + c0 * d[0], y0 = o[1] + c0 * d[1];
+    const double x1 = o[0] + c1 * d[0], y1 = o[1] + c1 * d[1];
+    t[2] = x0 * x0 + y0 * y0 <= baseRadius * baseRadius ? c0 : INF;
+    t[3] = x1 * x1 + y1 * y1 <= topRadius * topRadius ? c1 : INF;
+}
+
+void Cone::localNormal(const double p[3], int part, double n[3]) const {
+    const double sx = p[0], sy = p[1], sz = -slope * (baseRadius + slope * p[2]);
+    const double inv = 1.0 / sqrt(sx * sx + sy * sy + sz * sz);
+    const bool side = part < 2;
+    n[0] = side ? sx * inv : 0.0;
+    n[1] = side ? sy * inv : 0.0;
+    n[2] = side ? sz * inv : (part == 2 ? -1.0 : 1.0);
+}
+
+std::vector<Point> Cone::intersections(const Ray& ray) const {
+    double o[3], d[3], t[4];
+    frame.pointToLocal(ray.o.x(), ray.o.y(), ray.o.z(), o[0], o[1], o[2]);
+    frame.directionToLocal(ray.d.x(), ray.d.y(), ray.d.z(), d[0], d[1], d[2]);
+    candidates(o, d, t);
+
+    // A ray through the rim meets the side and a cap at the same t
+    sort(t, t + 4);
+    vector<Point> intersectionPoints;
+    for (int k = 0; k < 4; ++k) {
+        if (t[k] >= 0 && t[k] != INF && (k == 0 || t[k] != t[k - 1])) {
+            intersectionPoints.push_back(ray.o + ray.d * t[k]);
+        }
+    }
+    return intersectionPoints;
+}
+
+bool Cone::closestHit(const Ray& ray, double tMin, double tMax, HitRecord& hit) const {
+    double o[3], d[3], t[4];
+    frame.pointToLocal(ray.o.x(), ray.o.y(), ray.o.z(), o[0], o[1], o[2]);
+    frame.directionToLocal(ray.d.x(), ray.d.y(), ray.d.z(), d[0], d[1], d[2]);
+    candidates(o, d, t);
+
+    double best = INF;
+    int part = 0;
+    for (int k = 0; k < 4; ++k) {
+        bool closer = t[k] >= tMin && t[k] <= tMax && t[k] < best;
+        part = closer ? k : part;
+        best = closer ? t[k] : best;
+    }
+    if (best == INF) {
+        return false;
+    }
+
+    double p[3] = { o[0] + best * d[0], o[1] + best * d[1], o[2] + best * d[2] };
+    double n[3], nx, ny, nz;
+    localNormal(p, part, n);
+    frame.directionToWorld(n[0], n[1], n[2], nx, ny, nz);
+    hit.t = best;
+    hit.point = ray.o + ray.d * best;
+    hit.normal = Direction(nx, ny, nz);
+    return true;
+}
+
+void Cone::intersectPacket(RayPacket& packet, uint32_t mask, double tMin, int shapeIndex) const {
+    for (int i = 0; i < RayPacket::SIZE; ++i) {
+        double o[3], d[3], t[4];
+        frame.pointToLocal(packet.ox[i], packet.oy[i], packet.oz[i], o[0], o[1], o[2]);
+        frame.directionToLocal(packet.dx[i], packet.dy[i], packet.dz[i], d[0], d[1], d[2]);
+        candidates(o, d, t);
+
+        double best = INF;
+        int part = 0;
+        for (int k = 0; k < 4; ++k) {
+            bool closer = t[k] >= tMin && t[k] <= packet.t[i] && t[k] < best;
+            part = closer ? k : part;
+            best = closer ? t[k] : best;
+        }
+
+        double p[3] = { o[0] + best * d[0], o[1] + best * d[1], o[2] + best * d[2] };
+        double n[3], nx, ny, nz;
+        localNormal(p, part, n);
+        frame.directionToWorld(n[0], n[1], n[2], nx, ny, nz);
+
+        bool valid = ((mask >> i) & 1u) && best != INF;
+        packet.t[i] = valid ? best : packet.t[i];
+        packet.nx[i] = valid ? nx : packet.nx[i];
+        packet.ny[i] = valid ? ny : packet.ny[i];
+        packet.nz[i] = valid ? nz : packet.nz[i];
+        packet.shape[i] = valid ? shapeIndex : packet.shape[i];
+    }
+}
+
+BoundingBox Cone::bounds() const {
+    // The side is the convex hull of the two caps
+    Vector3d axis = frame.w().d;
+    BoundingBox box = BoundingBox::disc(base.coords, axis, baseRadius);
+    box.expand(BoundingBox::disc(top.coords, axis, topRadius));
+    return box;
+}
+
+void Cone::print() const {
+    cout << "Cone: base=" << base << ", top=" << top << ", baseRadius=" << baseRadius
+         << ", topRadius=" << topRadius << endl;
+}
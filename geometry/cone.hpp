@@ -0,0 +1,44 @@
+#ifndef CONE_HPP
+#define CONE_HPP
+
+#include "geometry.hpp"
+#include "geometric_shape.hpp"
+#include "local_frame.hpp"
+
+// Closed cone frustum between the centers of two caps: radius baseRadius at
+// base and topRadius at top, either of them (not both) may be 0. A cylinder
+// is the case of equal radii. Intersected in a frame with w along the axis,
+// where the side is x^2 + y^2 = r(z)^2 with r linear in z.
+class Cone : public GeometricShape {
+    public:
+        Point base, top;
+        double baseRadius, topRadius;
+
+        Cone(const Point& base_, const Point& top_, double baseRadius_, double topRadius_);
+
+        std::vector<Point> intersections(const Ray& ray) const override;
+
+        // Closest intersection in [tMin, tMax]
+        bool closestHit(const Ray& ray, double tMin, double tMax, HitRecord& hit) const override;
+
+        // Lane by lane version over a ray packet
+        void intersectPacket(RayPacket& packet, uint32_t mask, double tMin, int shapeIndex) const override;
+
+        BoundingBox bounds() const override;
+
+        void print() const override;
+
+    protected:
+        LocalFrame frame; // Origin at base, w towards top
+        double height;
+        double slope;     // dr/dz
+
+        // Distances to the side (two roots) and to the base and top caps,
+        // infinity where the ray misses that part
+        void candidates(const double o[3], const double d[3], double t[4]) const;
+
+        // Outward local normal at local point p of part (0, 1: side, 2: base, 3: top)
+        void localNormal(const double p[3], int part, double n[3]) const;
+};
+
+#endif // CONE_HPP
@@ -0,0 +1,22 @@
+#include "cylinder.hpp"
+#include <iostream>
+
+using namespace std;
+
+namespace {
+
+double checkedRadius(double radius) {
+    if (radius <= 0) {
+        throw invalid_argument("El radio del cilindro debe ser positivo.");
+    }
+    return radius;
+}
+
+} // namespace
+
+Cylinder::Cylinder(const Point& base_, const Point& top_, double radius)
+    : Cone(base_, top_, checkedRadius(radius), radius) {}
+
+void Cylinder::print() const {
+    cout << "Cylinder: base=" << base << ", top=" << top << ", radius=" << radius() << endl;
+}
@@ -0,0 +1,16 @@
+#ifndef CYLINDER_HPP
+#define CYLINDER_HPP
+
+#include "cone.hpp"
+
+// Closed cylinder between the centers of its two caps
+class Cylinder : public Cone {
+    public:
+        Cylinder(const Point& base_, const Point& top_, double radius);
+
+        double radius() const { return baseRadius; }
+
+        void print() const override;
+};
+
+#endif // CYLINDER_HPP
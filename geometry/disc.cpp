@@ -0,0 +1,82 @@
+#include "disc.hpp"
+#include "../ray.hpp"
+#include "../ray_packet.hpp"
+#include <cmath>
+#include <iostream>
+
+using namespace std;
+
+Disc::Disc(const Point& center_, const Direction& normal_, double radius_)
+    : center(center_), normal(normal_), radius(radius_) {
+    if (radius <= 0) {
+        throw invalid_argument("El radio del disco debe ser positivo.");
+    }
+    if (!(normal.norm() > 0)) {
+        throw invalid_argument("La normal del disco no puede ser nula.");
+    }
+    normal = normal.normalized();
+}
+
+std::vector<Point> Disc::intersections(const Ray& ray) const {
+    vector<Point> intersectionPoints;
+    HitRecord hit;
+    if (closestHit(ray, 0.0, INFINITY, hit)) {
+        intersectionPoints.push_back(hit.point);
+    }
+    return intersectionPoints;
+}
+
+bool Disc::closestHit(const Ray& ray, double tMin, double tMax, HitRecord& hit) const {
+    double denom = ray.d.dot(normal);
+    if (fabs(denom) <= 1e-12) {
+        return false; // Ray is parallel to the disc
+    }
+
+    double t = (center - ray.o).dot(normal) / denom;
+    if (t < tMin || t > tMax) {
+        return false;
+    }
+
+    Point p = ray.o + ray.d * t;
+    Direction r = p - center;
+    if (r.dot(r) > radius * radius) {
+        return false;
+    }
+
+    hit.t = t;
+    hit.point = p;
+    hit.normal = normal;
+    return true;
+}
+
+void Disc::intersectPacket(RayPacket& packet, uint32_t mask, double tMin, int shapeIndex) const {
+    const double nx = normal.x(), ny = normal.y(), nz = normal.z();
+    const double cx = center.x(), cy = center.y(), cz = center.z();
+    const double r2 = radius * radius;
+
+    for (int i = 0; i < RayPacket::SIZE; ++i) {
+        double ocx = cx - packet.ox[i], ocy = cy - packet.oy[i], ocz = cz - packet.oz[i];
+        double denom = packet.dx[i] * nx + packet.dy[i] * ny + packet.dz[i] * nz;
+        bool parallel = fabs(denom) <= 1e-12;
+        double t = (ocx * nx + ocy * ny + ocz * nz) / (parallel ? 1.0 : denom);
+
+        // Hit point relative to the center
+        double rx = t * packet.dx[i] - ocx, ry = t * packet.dy[i] - ocy, rz = t * packet.dz[i] - ocz;
+
+        bool valid = ((mask >> i) & 1u) && !parallel && rx * rx + ry * ry + rz * rz <= r2
+                     && t >= tMin && t <= packet.t[i];
+        packet.t[i] = valid ? t : packet.t[i];
+        packet.nx[i] = valid ? nx : packet.nx[i];
+        packet.ny[i] = valid ? ny : packet.ny[i];
+        packet.nz[i] = valid ? nz : packet.nz[i];
+        packet.shape[i] = valid ? shapeIndex : packet.shape[i];
+    }
+}
+
+BoundingBox Disc::bounds() const {
+    return BoundingBox::disc(center.coords, normal.d, radius);
+}
+
+void Disc::print() const {
+    cout << "Disc: center=" << center << ", normal=" << normal << ", radius=" << radius << endl;
+}
@@ -0,0 +1,30 @@
+#ifndef DISC_HPP
+#define DISC_HPP
+
+#include "geometry.hpp"
+#include "geometric_shape.hpp"
+
+// Flat disc: the points of the plane through center with the given normal
+// that lie within radius of the center
+class Disc : public GeometricShape {
+    public:
+        Point center;
+        Direction normal; // Unit
+        double radius;
+
+        Disc(const Point& center_, const Direction& normal_, double radius_);
+
+        std::vector<Point> intersections(const Ray& ray) const override;
+
+        // Closest intersection in [tMin, tMax]
+        bool closestHit(const Ray& ray, double tMin, double tMax, HitRecord& hit) const override;
+
+        // Lane by lane version over a ray packet, written to be vectorised
+        void intersectPacket(RayPacket& packet, uint32_t mask, double tMin, int shapeIndex) const override;
+
+        BoundingBox bounds() const override;
+
+        void print() const override;
+};
+
+#endif // DISC_HPP
@@ -0,0 +1,567 @@
+#ifndef FLOAT_KERNELS_HPP
+#define FLOAT_KERNELS_HPP
+
+#include "../ray_packet.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+// Single precision intersection kernels for the analytic shapes, written so
+// their rounding errors are bounded instead of hidden behind an epsilon
+// (after pbrt, 3rd edition, section 3.9):
+//
+//   - spheres solve the quadratic in a form without cancellation and
+//     reproject the hit point onto the surface
+//   - triangles use the watertight test of Woop, Benthin and Wald (2013),
+//     so rays through a shared edge or vertex never slip between triangles
+//   - every hit reports how far its point may be from the true surface
+//     along the normal, and secondary rays start that far away from it
+//
+// A ray leaving the surface by more than that bound can not find it again,
+// whatever its direction, which removes self intersection acne without
+// tuning. Floats halve the size of every lane; the triangle test of a
+// coherent packet runs on all of its lanes at once, but the spheres and the
+// incoherent packets still test lane by lane.
+
+// Bound of the relative error of n chained float operations (Higham's gamma_n)
+constexpr float floatGamma(int n) {
+    return n * (std::numeric_limits<float>::epsilon() * 0.5f) /
+           (1 - n * (std::numeric_limits<float>::epsilon() * 0.5f));
+}
+
+struct FloatSphere {
+    float cx, cy, cz, radius;
+    float invRadius;
+};
+
+struct FloatTriangle {
+    float v[3][3];      // Vertices, v[vertex][axis]
+    float nx, ny, nz;   // Unit normal
+};
+
+struct FloatPlane {
+    float nx, ny, nz;   // Unit normal
+    float distance;     // Of the plane to the origin along the normal
+};
+
+// Ray in floats with the per ray set up of the watertight triangle test: the
+// axis where the direction is largest becomes z, and the shear (sx, sy, sz)
+// maps the direction to (0, 0, 1)
+struct FloatRay {
+    float o[3], d[3];
+    int kx, ky, kz;
+    float sx, sy, sz;
+
+    FloatRay() = default;
+    FloatRay(double ox, double oy, double oz, double dx, double dy, double dz);
+};
+
+struct FloatHit {
+    float t;
+    float px, py, pz;   // Hit point
+    float nx, ny, nz;   // Unit normal
+    float offset;       // Bound of the error of the hit point along the normal
+};
+
+// Float copy of the rays of a packet, in the same layout, with closest hits
+// of their own, so that the triangle test can run on every lane at once.
+// The scene merges the hits back at the end.
+struct FloatRayPacket {
+    alignas(32) float ox[RayPacket::SIZE];
+    alignas(32) float oy[RayPacket::SIZE];
+    alignas(32) float oz[RayPacket::SIZE];
+    alignas(32) float dx[RayPacket::SIZE];
+    alignas(32) float dy[RayPacket::SIZE];
+    alignas(32) float dz[RayPacket::SIZE];
+
+    // Set up of the watertight triangle test of every lane (see FloatRay):
+    // its largest axis and the shear for it. Coherent packets nearly always
+    // share the axis, which lets the triangle test run on all lanes at once.
+    alignas(32) int kz[RayPacket::SIZE];
+    alignas(32) float sx[RayPacket::SIZE];
+    alignas(32) float sy[RayPacket::SIZE];
+    alignas(32) float sz[RayPacket::SIZE];
+    int sharedKz; // kz of every active lane, -1 if they differ
+
+    // Closest float hit of every lane; t is also the far bound of the lane.
+    // shape stays -1 while the closest hit, if any, is in the double packet.
+    alignas(32) float t[RayPacket::SIZE];
+    alignas(32) float nx[RayPacket::SIZE];
+    alignas(32) float ny[RayPacket::SIZE];
+    alignas(32) float nz[RayPacket::SIZE];
+    alignas(32) float px[RayPacket::SIZE];
+    alignas(32) float py[RayPacket::SIZE];
+    alignas(32) float pz[RayPacket::SIZE];
+    alignas(32) float offset[RayPacket::SIZE];
+    alignas(32) int shape[RayPacket::SIZE];
+
+    explicit FloatRayPacket(const RayPacket& packet);
+
+    // The ray of a lane, for the scalar kernels
+    FloatRay ray(int lane) const;
+
+    // Takes over the lanes the double kernel of shapeIndex just hit: their
+    // closest hit is now the one in the double packet
+    void takeDoubleHits(const RayPacket& packet, int shapeIndex);
+
+    // Copies the far bounds to the double packet, which the traversal and
+    // the double kernels read
+    void pushBounds(RayPacket& packet) const;
+
+    // Writes the lanes whose closest hit is a float one into the packet
+    void merge(RayPacket& packet) const;
+};
+
+inline FloatRay::FloatRay(double ox, double oy, double oz, double dx, double dy, double dz)
+    : o{ float(ox), float(oy), float(oz) }, d{ float(dx), float(dy), float(dz) } {
+    const float ax = std::fabs(d[0]), ay = std::fabs(d[1]), az = std::fabs(d[2]);
+    kz = ax > ay ? (ax > az ? 0 : 2) : (ay > az ? 1 : 2);
+    kx = kz == 2 ? 0 : kz + 1;
+    ky = kx == 2 ? 0 : kx + 1;
+    sz = 1.0f / d[kz];
+    sx = -d[kx] * sz;
+    sy = -d[ky] * sz;
+}
+
+inline FloatRayPacket::FloatRayPacket(const RayPacket& packet) {
+    // Same set up as FloatRay, without branches so the lanes vectorise.
+    // Inactive lanes get a ray along +z.
+    for (int i = 0; i < RayPacket::SIZE; ++i) {
+        const bool on = (packet.active >> i) & 1u;
+        const float o[3] = { static_cast<float>(packet.ox[i]), static_cast<float>(packet.oy[i]),
+                             static_cast<float>(packet.oz[i]) };
+        const float d[3] = { static_cast<float>(packet.dx[i]), static_cast<float>(packet.dy[i]),
+                             static_cast<float>(packet.dz[i]) };
+        ox[i] = on ? o[0] : 0.0f;
+        oy[i] = on ? o[1] : 0.0f;
+        oz[i] = on ? o[2] : 0.0f;
+        dx[i] = on ? d[0] : 0.0f;
+        dy[i] = on ? d[1] : 0.0f;
+        dz[i] = on ? d[2] : 1.0f;
+        const float ax = std::fabs(dx[i]), ay = std::fabs(dy[i]), az = std::fabs(dz[i]);
+        const int k = ax > ay ? (ax > az ? 0 : 2) : (ay > az ? 1 : 2);
+        // kx and ky follow kz cyclically
+        const float dkz = k == 0 ? dx[i] : (k == 1 ? dy[i] : dz[i]);
+        const float dkx = k == 0 ? dy[i] : (k == 1 ? dz[i] : dx[i]);
+        const float dky = k == 0 ? dz[i] : (k == 1 ? dx[i] : dy[i]);
+        kz[i] = k;
+        sz[i] = 1.0f / dkz;
+        sx[i] = -dkx * sz[i];
+        sy[i] = -dky * sz[i];
+        t[i] = static_cast<float>(packet.t[i]);
+        shape[i] = -1;
+    }
+
+    sharedKz = -1;
+    for (int i = 0; i < RayPacket::SIZE; ++i) {
+        if ((packet.active >> i) & 1u) {
+            if (sharedKz < 0) {
+                sharedKz = kz[i];
+            } else if (kz[i] != sharedKz) {
+                sharedKz = -1;
+                break;
+            }
+        }
+    }
+}
+
+inline FloatRay FloatRayPacket::ray(int lane) const {
+    FloatRay ray;
+    ray.o[0] = ox[lane];
+    ray.o[1] = oy[lane];
+    ray.o[2] = oz[lane];
+    ray.d[0] = dx[lane];
+    ray.d[1] = dy[lane];
+    ray.d[2] = dz[lane];
+    ray.kz = kz[lane];
+    ray.kx = ray.kz == 2 ? 0 : ray.kz + 1;
+    ray.ky = ray.kx == 2 ? 0 : ray.kx + 1;
+    ray.sx = sx[lane];
+    ray.sy = sy[lane];
+    ray.sz = sz[lane];
+    return ray;
+}
+
+inline void FloatRayPacket::takeDoubleHits(const RayPacket& packet, int shapeIndex) {
+    for (int i = 0; i < RayPacket::SIZE; ++i) {
+        if (packet.shape[i] == shapeIndex) {
+            t[i] = static_cast<float>(packet.t[i]);
+            shape[i] = -1;
+        }
+    }
+}
+
+inline void FloatRayPacket::pushBounds(RayPacket& packet) const {
+    for (int i = 0; i < RayPacket::SIZE; ++i) {
+        packet.t[i] = t[i];
+    }
+}
+
+inline void FloatRayPacket::merge(RayPacket& packet) const {
+    for (int i = 0; i < RayPacket::SIZE; ++i) {
+        if (shape[i] >= 0) {
+            packet.t[i] = t[i];
+            packet.nx[i] = nx[i];
+            packet.ny[i] = ny[i];
+            packet.nz[i] = nz[i];
+            packet.px[i] = px[i];
+            packet.py[i] = py[i];
+            packet.pz[i] = pz[i];
+            packet.offset[i] = offset[i];
+            packet.shape[i] = shape[i];
+        }
+    }
+}
+
+// Hit of a sphere with t in [tMin, tMax]
+inline bool floatSphereHit(const FloatSphere& s, const FloatRay& ray, float tMin, float tMax, FloatHit& hit) {
+    const float ocx = ray.o[0] - s.cx, ocy = ray.o[1] - s.cy, ocz = ray.o[2] - s.cz;
+    const float dx = ray.d[0], dy = ray.d[1], dz = ray.d[2];
+    const float a = dx * dx + dy * dy + dz * dz;
+    const float halfB = ocx * dx + ocy * dy + ocz * dz;
+    const float c = ocx * ocx + ocy * ocy + ocz * ocz - s.radius * s.radius;
+
+    // halfB^2 - a c cancels catastrophically for rays far from the sphere.
+    // With f the vector from the centre to the point of the line closest to
+    // it, the same discriminant is a (r - |f|) (r + |f|), which does not.
+    const float invA = 1 / a;
+    const float along = halfB * invA;
+    const float fx = ocx - along * dx, fy = ocy - along * dy, fz = ocz - along * dz;
+    const float f = std::sqrt(fx * fx + fy * fy + fz * fz);
+    const float discriminant = a * (s.radius - f) * (s.radius + f);
+    if (!(discriminant >= 0)) {
+        return false;
+    }
+
+    // One root adds terms of the same sign; the other comes from the product
+    // of the roots, c / a, instead of a subtraction
+    const float root = std::sqrt(discriminant);
+    const float q = -(halfB + std::copysign(root, halfB));
+    float t0 = q * invA, t1 = c / q;
+    if (t0 > t1) {
+        const float swap = t0;
+        t0 = t1;
+        t1 = swap;
+    }
+    const float t = t0 >= tMin ? t0 : t1;
+    if (!(t >= tMin && t <= tMax)) {
+        return false;
+    }
+
+    // Back onto the surface: the reprojected point is within gamma_5 of it
+    float px = ocx + t * dx, py = ocy + t * dy, pz = ocz + t * dz;
+    const float scale = s.radius / std::sqrt(px * px + py * py + pz * pz);
+    px *= scale;
+    py *= scale;
+    pz *= scale;
+
+    hit.t = t;
+    hit.nx = px * s.invRadius;
+    hit.ny = py * s.invRadius;
+    hit.nz = pz * s.invRadius;
+    hit.px = s.cx + px;
+    hit.py = s.cy + py;
+    hit.pz = s.cz + pz;
+    // Plus the rounding of adding the centre back and of the next origin
+    const float ex = floatGamma(5) * std::fabs(px) + floatGamma(2) * std::fabs(hit.px);
+    const float ey = floatGamma(5) * std::fabs(py) + floatGamma(2) * std::fabs(hit.py);
+    const float ez = floatGamma(5) * std::fabs(pz) + floatGamma(2) * std::fabs(hit.pz);
+    hit.offset = std::fabs(hit.nx) * ex + std::fabs(hit.ny) * ey + std::fabs(hit.nz) * ez;
+    return true;
+}
+
+// Watertight hit of a triangle with t in [tMin, tMax]
+inline bool floatTriangleHit(const FloatTriangle& tri, const FloatRay& ray, float tMin, float tMax, FloatHit& hit) {
+    // Vertices relative to the origin, permuted and sheared so the ray runs
+    // along +z from (0, 0, 0): what is left is a 2D point in triangle test
+    float p[3][3];
+    for (int v = 0; v < 3; ++v) {
+        const float x = tri.v[v][ray.kx] - ray.o[ray.kx];
+        const float y = tri.v[v][ray.ky] - ray.o[ray.ky];
+        const float z = tri.v[v][ray.kz] - ray.o[ray.kz];
+        p[v][0] = x + ray.sx * z;
+        p[v][1] = y + ray.sy * z;
+        p[v][2] = z;
+    }
+
+    float e0 = p[1][0] * p[2][1] - p[1][1] * p[2][0];
+    float e1 = p[2][0] * p[0][1] - p[2][1] * p[0][0];
+    float e2 = p[0][0] * p[1][1] - p[0][1] * p[1][0];
+    // A zero edge function may be a rounding artefact on an edge: redo it in double
+    if (e0 == 0 || e1 == 0 || e2 == 0) {
+        e0 = static_cast<float>(double(p[1][0]) * p[2][1] - double(p[1][1]) * p[2][0]);
+        e1 = static_cast<float>(double(p[2][0]) * p[0][1] - double(p[2][1]) * p[0][0]);
+        e2 = static_cast<float>(double(p[0][0]) * p[1][1] - double(p[0][1]) * p[1][0]);
+    }
+    if ((e0 < 0 || e1 < 0 || e2 < 0) && (e0 > 0 || e1 > 0 || e2 > 0)) {
+        return false;
+    }
+    const float det = e0 + e1 + e2;
+    if (det == 0) {
+        return false;
+    }
+
+    // t scaled by det, compared without dividing first
+    for (int v = 0; v < 3; ++v) {
+        p[v][2] *= ray.sz;
+    }
+    const float tScaled = e0 * p[0][2] + e1 * p[1][2] + e2 * p[2][2];
+    if (det < 0 ? (tScaled > tMin * det || tScaled < tMax * det) : (tScaled < tMin * det || tScaled > tMax * det)) {
+        return false;
+    }
+    const float invDet = 1 / det;
+    const float b0 = e0 * invDet, b1 = e1 * invDet, b2 = e2 * invDet;
+    const float t = tScaled * invDet;
+
+    // Reject hits whose t is not certainly positive given the errors above
+    const float maxZ = std::fmax(std::fabs(p[0][2]), std::fmax(std::fabs(p[1][2]), std::fabs(p[2][2])));
+    const float maxX = std::fmax(std::fabs(p[0][0]), std::fmax(std::fabs(p[1][0]), std::fabs(p[2][0])));
+    const float maxY = std::fmax(std::fabs(p[0][1]), std::fmax(std::fabs(p[1][1]), std::fabs(p[2][1])));
+    const float maxE = std::fmax(std::fabs(e0), std::fmax(std::fabs(e1), std::fabs(e2)));
+    const float deltaZ = floatGamma(3) * maxZ;
+    const float deltaX = floatGamma(5) * (maxX + maxZ);
+    const float deltaY = floatGamma(5) * (maxY + maxZ);
+    const float deltaE = 2 * (floatGamma(2) * maxX * maxY + deltaY * maxX + deltaX * maxY);
+    const float deltaT = 3 * (floatGamma(3) * maxE * maxZ + deltaE * maxZ + deltaZ * maxE) * std::fabs(invDet);
+    if (t <= deltaT) {
+        return false;
+    }
+
+    hit.t = t;
+    hit.px = b0 * tri.v[0][0] + b1 * tri.v[1][0] + b2 * tri.v[2][0];
+    hit.py = b0 * tri.v[0][1] + b1 * tri.v[1][1] + b2 * tri.v[2][1];
+    hit.pz = b0 * tri.v[0][2] + b1 * tri.v[1][2] + b2 * tri.v[2][2];
+    hit.nx = tri.nx;
+    hit.ny = tri.ny;
+    hit.nz = tri.nz;
+    // The barycentric interpolation is within gamma_7, the next origin adds one rounding
+    const float ex = floatGamma(8) * (std::fabs(b0 * tri.v[0][0]) + std::fabs(b1 * tri.v[1][0]) + std::fabs(b2 * tri.v[2][0]));
+    const float ey = floatGamma(8) * (std::fabs(b0 * tri.v[0][1]) + std::fabs(b1 * tri.v[1][1]) + std::fabs(b2 * tri.v[2][1]));
+    const float ez = floatGamma(8) * (std::fabs(b0 * tri.v[0][2]) + std::fabs(b1 * tri.v[1][2]) + std::fabs(b2 * tri.v[2][2]));
+    hit.offset = std::fabs(tri.nx) * ex + std::fabs(tri.ny) * ey + std::fabs(tri.nz) * ez;
+    return true;
+}
+
+// Hit of a plane with t in [tMin, tMax]. Rays closer to parallel than the
+// double kernel accepts are missed, as there.
+inline bool floatPlaneHit(const FloatPlane& plane, const FloatRay& ray, float tMin, float tMax, FloatHit& hit) {
+    const float denom = plane.nx * ray.d[0] + plane.ny * ray.d[1] + plane.nz * ray.d[2];
+    if (std::fabs(denom) <= 1e-6f) {
+        return false;
+    }
+    const float t = (plane.distance - (plane.nx * ray.o[0] + plane.ny * ray.o[1] + plane.nz * ray.o[2])) / denom;
+    if (!(t >= tMin && t <= tMax)) {
+        return false;
+    }
+
+    // Back onto the plane along its normal
+    float px = ray.o[0] + t * ray.d[0], py = ray.o[1] + t * ray.d[1], pz = ray.o[2] + t * ray.d[2];
+    const float off = plane.nx * px + plane.ny * py + plane.nz * pz - plane.distance;
+    px -= plane.nx * off;
+    py -= plane.ny * off;
+    pz -= plane.nz * off;
+
+    hit.t = t;
+    hit.px = px;
+    hit.py = py;
+    hit.pz = pz;
+    hit.nx = plane.nx;
+    hit.ny = plane.ny;
+    hit.nz = plane.nz;
+    hit.offset = floatGamma(8) * (std::fabs(px) + std::fabs(py) + std::fabs(pz) + std::fabs(plane.distance));
+    return true;
+}
+
+// Far bound of every lane, -infinity outside mask: testing the mask bits
+// inside the lane loops keeps compilers from vectorising them
+inline void floatLaneBounds(const FloatRayPacket& rays, uint32_t mask, float (&far)[RayPacket::SIZE]) {
+    for (int i = 0; i < RayPacket::SIZE; ++i) {
+        far[i] = ((mask >> i) & 1u) ? rays.t[i] : -std::numeric_limits<float>::infinity();
+    }
+}
+
+// Packet versions: every lane in mask hit within [tMin, rays.t[lane]] gets
+// its float hit updated, with shape = shapeIndex. Spheres and planes run the
+// scalar arithmetic above without branches, so the lanes vectorise.
+inline void floatSpherePacket(const FloatSphere& s, FloatRayPacket& rays,
+                              uint32_t mask, float tMin, int shapeIndex) {
+    const float r = s.radius, r2 = s.radius * s.radius;
+    alignas(32) float far[RayPacket::SIZE];
+    floatLaneBounds(rays, mask, far);
+    for (int i = 0; i < RayPacket::SIZE; ++i) {
+        const float ocx = rays.ox[i] - s.cx, ocy = rays.oy[i] - s.cy, ocz = rays.oz[i] - s.cz;
+        const float dx = rays.dx[i], dy = rays.dy[i], dz = rays.dz[i];
+        const float a = dx * dx + dy * dy + dz * dz;
+        const float halfB = ocx * dx + ocy * dy + ocz * dz;
+        const float c = ocx * ocx + ocy * ocy + ocz * ocz - r2;
+        const float invA = 1 / a;
+        const float along = halfB * invA;
+        const float fx = ocx - along * dx, fy = ocy - along * dy, fz = ocz - along * dz;
+        const float f = std::sqrt(fx * fx + fy * fy + fz * fz);
+        const float discriminant = a * (r - f) * (r + f);
+
+        const float root = std::sqrt(discriminant > 0 ? discriminant : 0.0f);
+        const float q = -(halfB + std::copysign(root, halfB));
+        const float ta = q * invA, tb = c / q;
+        const float t0 = ta < tb ? ta : tb, t1 = ta < tb ? tb : ta;
+        const float t = t0 >= tMin ? t0 : t1;
+
+        float px = ocx + t * dx, py = ocy + t * dy, pz = ocz + t * dz;
+        const float scale = r / std::sqrt(px * px + py * py + pz * pz);
+        px *= scale;
+        py *= scale;
+        pz *= scale;
+        const float nx = px * s.invRadius, ny = py * s.invRadius, nz = pz * s.invRadius;
+        const float ex = floatGamma(5) * std::fabs(px) + floatGamma(2) * std::fabs(s.cx + px);
+        const float ey = floatGamma(5) * std::fabs(py) + floatGamma(2) * std::fabs(s.cy + py);
+        const float ez = floatGamma(5) * std::fabs(pz) + floatGamma(2) * std::fabs(s.cz + pz);
+
+        const bool valid = (discriminant >= 0) & (t >= tMin) & (t <= far[i]);
+        rays.t[i] = valid ? t : rays.t[i];
+        rays.nx[i] = valid ? nx : rays.nx[i];
+        rays.ny[i] = valid ? ny : rays.ny[i];
+        rays.nz[i] = valid ? nz : rays.nz[i];
+        rays.px[i] = valid ? s.cx + px : rays.px[i];
+        rays.py[i] = valid ? s.cy + py : rays.py[i];
+        rays.pz[i] = valid ? s.cz + pz : rays.pz[i];
+        rays.offset[i] = valid ? std::fabs(nx) * ex + std::fabs(ny) * ey + std::fabs(nz) * ez : rays.offset[i];
+        rays.shape[i] = valid ? shapeIndex : rays.shape[i];
+    }
+}
+
+// Lanes that share the axis permutation run the watertight test above side
+// by side. A zero edge function sends its lane to the scalar test, which
+// redoes the edges in double; so do all lanes of packets whose rays have
+// different largest axes.
+inline void floatTrianglePacket(const FloatTriangle& tri, FloatRayPacket& rays,
+                                uint32_t mask, float tMin, int shapeIndex) {
+    alignas(32) int scalar[RayPacket::SIZE] = {};
+    if (rays.sharedKz >= 0) {
+        const int kz = rays.sharedKz, kx = kz == 2 ? 0 : kz + 1, ky = kx == 2 ? 0 : kx + 1;
+        // Permuted origins and vertices, copied out so the compiler knows the
+        // lane writes below leave them alone
+        const float* const origin[3] = { rays.ox, rays.oy, rays.oz };
+        alignas(32) float okx[RayPacket::SIZE], oky[RayPacket::SIZE], okz[RayPacket::SIZE];
+        std::copy_n(origin[kx], RayPacket::SIZE, okx);
+        std::copy_n(origin[ky], RayPacket::SIZE, oky);
+        std::copy_n(origin[kz], RayPacket::SIZE, okz);
+        const float ax = tri.v[0][kx], ay = tri.v[0][ky], az = tri.v[0][kz];
+        const float bx = tri.v[1][kx], by = tri.v[1][ky], bz = tri.v[1][kz];
+        const float cx = tri.v[2][kx], cy = tri.v[2][ky], cz = tri.v[2][kz];
+        const float v0x = tri.v[0][0], v0y = tri.v[0][1], v0z = tri.v[0][2];
+        const float v1x = tri.v[1][0], v1y = tri.v[1][1], v1z = tri.v[1][2];
+        const float v2x = tri.v[2][0], v2y = tri.v[2][1], v2z = tri.v[2][2];
+        const float nx = tri.nx, ny = tri.ny, nz = tri.nz;
+        const float normalOffset[3] = { std::fabs(nx), std::fabs(ny), std::fabs(nz) };
+        alignas(32) float far[RayPacket::SIZE];
+        floatLaneBounds(rays, mask, far);
+        for (int i = 0; i < RayPacket::SIZE; ++i) {
+            const float z0 = az - okz[i], z1 = bz - okz[i], z2 = cz - okz[i];
+            const float x0 = ax - okx[i] + rays.sx[i] * z0;
+            const float x1 = bx - okx[i] + rays.sx[i] * z1;
+            const float x2 = cx - okx[i] + rays.sx[i] * z2;
+            const float y0 = ay - oky[i] + rays.sy[i] * z0;
+            const float y1 = by - oky[i] + rays.sy[i] * z1;
+            const float y2 = cy - oky[i] + rays.sy[i] * z2;
+
+            const float e0 = x1 * y2 - y1 * x2;
+            const float e1 = x2 * y0 - y2 * x0;
+            const float e2 = x0 * y1 - y0 * x1;
+            const bool zeroEdge = (e0 == 0) | (e1 == 0) | (e2 == 0);
+            const bool mixed = ((e0 < 0) | (e1 < 0) | (e2 < 0)) & ((e0 > 0) | (e1 > 0) | (e2 > 0));
+            const float det = e0 + e1 + e2;
+
+            const float zs0 = z0 * rays.sz[i], zs1 = z1 * rays.sz[i], zs2 = z2 * rays.sz[i];
+            const float tScaled = e0 * zs0 + e1 * zs1 + e2 * zs2;
+            // t in [tMin, far] scaled by det, whose sign swaps the bounds
+            const float nearScaled = tMin * det, farScaled = far[i] * det;
+            const float lower = det < 0 ? farScaled : nearScaled;
+            const float upper = det < 0 ? nearScaled : farScaled;
+            const bool inRange = (tScaled >= lower) & (tScaled <= upper);
+            const float invDet = 1 / det;
+            const float b0 = e0 * invDet, b1 = e1 * invDet, b2 = e2 * invDet;
+            const float t = tScaled * invDet;
+
+            const float maxZ = std::max(std::fabs(zs0), std::max(std::fabs(zs1), std::fabs(zs2)));
+            const float maxX = std::max(std::fabs(x0), std::max(std::fabs(x1), std::fabs(x2)));
+            const float maxY = std::max(std::fabs(y0), std::max(std::fabs(y1), std::fabs(y2)));
+            const float maxE = std::max(std::fabs(e0), std::max(std::fabs(e1), std::fabs(e2)));
+            const float deltaZ = floatGamma(3) * maxZ;
+            const float deltaX = floatGamma(5) * (maxX + maxZ);
+            const float deltaY = floatGamma(5) * (maxY + maxZ);
+            const float deltaE = 2 * (floatGamma(2) * maxX * maxY + deltaY * maxX + deltaX * maxY);
+            const float deltaT = 3 * (floatGamma(3) * maxE * maxZ + deltaE * maxZ + deltaZ * maxE) * std::fabs(invDet);
+
+            const float hx0 = b0 * v0x, hx1 = b1 * v1x, hx2 = b2 * v2x;
+            const float hy0 = b0 * v0y, hy1 = b1 * v1y, hy2 = b2 * v2y;
+            const float hz0 = b0 * v0z, hz1 = b1 * v1z, hz2 = b2 * v2z;
+            const float ex = floatGamma(8) * (std::fabs(hx0) + std::fabs(hx1) + std::fabs(hx2));
+            const float ey = floatGamma(8) * (std::fabs(hy0) + std::fabs(hy1) + std::fabs(hy2));
+            const float ez = floatGamma(8) * (std::fabs(hz0) + std::fabs(hz1) + std::fabs(hz2));
+
+            // far >= tMin leaves out the lanes outside mask
+            const bool valid = !zeroEdge & !mixed & (det != 0) & inRange & (t > deltaT) & (far[i] >= tMin);
+            scalar[i] = zeroEdge;
+            rays.t[i] = valid ? t : rays.t[i];
+            rays.nx[i] = valid ? nx : rays.nx[i];
+            rays.ny[i] = valid ? ny : rays.ny[i];
+            rays.nz[i] = valid ? nz : rays.nz[i];
+            rays.px[i] = valid ? hx0 + hx1 + hx2 : rays.px[i];
+            rays.py[i] = valid ? hy0 + hy1 + hy2 : rays.py[i];
+            rays.pz[i] = valid ? hz0 + hz1 + hz2 : rays.pz[i];
+            const float offset = normalOffset[0] * ex + normalOffset[1] * ey + normalOffset[2] * ez;
+            rays.offset[i] = valid ? offset : rays.offset[i];
+            rays.shape[i] = valid ? shapeIndex : rays.shape[i];
+        }
+    } else {
+        std::fill_n(scalar, RayPacket::SIZE, 1);
+    }
+
+    for (int i = 0; i < RayPacket::SIZE; ++i) {
+        FloatHit hit;
+        if (scalar[i] && ((mask >> i) & 1u) && floatTriangleHit(tri, rays.ray(i), tMin, rays.t[i], hit)) {
+            rays.t[i] = hit.t;
+            rays.nx[i] = hit.nx;
+            rays.ny[i] = hit.ny;
+            rays.nz[i] = hit.nz;
+            rays.px[i] = hit.px;
+            rays.py[i] = hit.py;
+            rays.pz[i] = hit.pz;
+            rays.offset[i] = hit.offset;
+            rays.shape[i] = shapeIndex;
+        }
+    }
+}
+
+inline void floatPlanePacket(const FloatPlane& plane, FloatRayPacket& rays,
+                             uint32_t mask, float tMin, int shapeIndex) {
+    alignas(32) float far[RayPacket::SIZE];
+    floatLaneBounds(rays, mask, far);
+    for (int i = 0; i < RayPacket::SIZE; ++i) {
+        const float denom = plane.nx * rays.dx[i] + plane.ny * rays.dy[i] + plane.nz * rays.dz[i];
+        const float toPlane = plane.distance - (plane.nx * rays.ox[i] + plane.ny * rays.oy[i] + plane.nz * rays.oz[i]);
+        const bool crossing = std::fabs(denom) > 1e-6f;
+        const float t = toPlane / (crossing ? denom : 1.0f);
+
+        float px = rays.ox[i] + t * rays.dx[i], py = rays.oy[i] + t * rays.dy[i], pz = rays.oz[i] + t * rays.dz[i];
+        const float off = plane.nx * px + plane.ny * py + plane.nz * pz - plane.distance;
+        px -= plane.nx * off;
+        py -= plane.ny * off;
+        pz -= plane.nz * off;
+        const float offset = floatGamma(8) * (std::fabs(px) + std::fabs(py) + std::fabs(pz) + std::fabs(plane.distance));
+
+        const bool valid = crossing & (t >= tMin) & (t <= far[i]);
+        rays.t[i] = valid ? t : rays.t[i];
+        rays.nx[i] = valid ? plane.nx : rays.nx[i];
+        rays.ny[i] = valid ? plane.ny : rays.ny[i];
+        rays.nz[i] = valid ? plane.nz : rays.nz[i];
+        rays.px[i] = valid ? px : rays.px[i];
+        rays.py[i] = valid ? py : rays.py[i];
+        rays.pz[i] = valid ? pz : rays.pz[i];
+        rays.offset[i] = valid ? offset : rays.offset[i];
+        rays.shape[i] = valid ? shapeIndex : rays.shape[i];
+    }
+}
+
+#endif // FLOAT_KERNELS_HPP
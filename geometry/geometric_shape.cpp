@@ -0,0 +1,24 @@
+#include "geometric_shape.hpp"
+#include "../ray.hpp"
+#include "../ray_packet.hpp"
+
+bool GeometricShape::occludes(const Ray& ray, double tMin, double tMax) const {
+    HitRecord hit;
+    return closestHit(ray, tMin, tMax, hit);
+}
+
+void GeometricShape::intersectPacket(RayPacket& packet, uint32_t mask, double tMin, int shapeIndex) const {
+    for (int i = 0; i < RayPacket::SIZE; ++i) {
+        if (!(mask & (1u << i))) {
+            continue;
+        }
+        HitRecord hit;
+        if (closestHit(packet.ray(i), tMin, packet.t[i], hit)) {
+            packet.t[i] = hit.t;
+            packet.nx[i] = hit.normal.x();
+            packet.ny[i] = hit.normal.y();
+            packet.nz[i] = hit.normal.z();
+            packet.shape[i] = shapeIndex;
+        }
+    }
+}
@@ -2,10 +2,22 @@
 #define GEOMETRIC_SHAPE_HPP
 
 #include "geometry.hpp" 
+#include "bounding_box.hpp"
+#include <cstdint>
 #include <vector>
 
-// Forward declaration
+// Forward declarations
 class Ray;
+struct RayPacket;
+
+// Closest intersection found along a ray
+struct HitRecord {
+    double t;         // Ray parameter of the hit
+    Point point;      // Hit point in world coordinates
+    Direction normal; // Unit geometric normal at the hit point
+    int shape = -1;   // Index of the shape inside the scene (set by the scene)
+    double offset = 0.0; // Bound of the error of point along the normal (0: no bound known)
+};
 
 class GeometricShape {
 public:
@@ -13,9 +25,34 @@ public:
     
     // Pure virtual method that each shape must implement
     virtual std::vector<Point> intersections(const Ray& ray) const = 0;
-    
+
+    // Closest intersection with t in [tMin, tMax]. Fills hit (except hit.shape) and returns true if found
+    virtual bool closestHit(const Ray& ray, double tMin, double tMax, HitRecord& hit) const = 0;
+
+    // Whether the shape has any intersection with t in [tMin, tMax]. Shadow
+    // rays only need the answer, so shapes may stop at the first hit found and
+    // skip the hit point and normal. Defaults to closestHit.
+    virtual bool occludes(const Ray& ray, double tMin, double tMax) const;
+
+    // Packet version of closestHit: every lane in mask hit within [tMin, packet.t[lane]]
+    // gets its t, normal and shape (= shapeIndex) updated in the packet.
+    // The default implementation falls back to one closestHit call per lane.
+    virtual void intersectPacket(RayPacket& packet, uint32_t mask, double tMin, int shapeIndex) const;
+
+    // World space bounds, used by the acceleration structures
+    virtual BoundingBox bounds() const = 0;
+
+    // Unbounded shapes (planes) are kept out of the acceleration structures
+    virtual bool isBounded() const { return true; }
+
+    // Shapes that move during the exposure (Ray::time) have bounds() covering
+    // the whole motion, plus a box at shutter open and one at shutter close
+    // whose linear interpolation holds the shape at every time in between.
+    virtual bool isMoving() const { return false; }
+    virtual void motionBounds(BoundingBox& open, BoundingBox& close) const { open = close = bounds(); }
+
     // Optional: virtual method for displaying shape info
     virtual void print() const = 0;
 };
 
-#endif // GEOMETRIC_SHAPE_HPP
\ No newline at end of file
+#endif // GEOMETRIC_SHAPE_HPP
@@ -0,0 +1,130 @@
+#include "instance.hpp"
+#include "../ray.hpp"
+#include "../ray_packet.hpp"
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+
+using namespace std;
+
+Instance::Instance(std::shared_ptr<const GeometricShape> object_, const Matrix4d& transform)
+    : object(std::move(object_)), transformation_matrix(transform)
+{
+    if (!object) {
+        throw invalid_argument("La instancia no tiene objeto.");
+    }
+    Eigen::Matrix3d linear = transform.topLeftCorner<3, 3>();
+    if (fabs(linear.determinant()) < 1e-12) {
+        throw invalid_argument("La transformacion de la instancia no es invertible.");
+    }
+
+    inverse_transformation_matrix = transformation_matrix.inverse();
+    toObjectLinear = inverse_transformation_matrix.topLeftCorner<3, 3>();
+    toObjectOffset = inverse_transformation_matrix.topRightCorner<3, 1>();
+    normalMatrix = toObjectLinear.transpose();
+
+    // World bounds: the transformed corners of the object bounds
+    if (!object->isBounded()) {
+        worldBounds = BoundingBox::infinite();
+        return;
+    }
+    BoundingBox local = object->bounds();
+    for (int corner = 0; corner < 8; ++corner) {
+        Vector3d p((corner & 1) ? local.max.x() : local.min.x(),
+                   (corner & 2) ? local.max.y() : local.min.y(),
+                   (corner & 4) ? local.max.z() : local.min.z());
+        worldBounds.expand(linear * p + transform.topRightCorner<3, 1>());
+    }
+}
+
+Ray Instance::toObject(const Ray& ray) const {
+    return Ray(Point(toObjectLinear * ray.o.coords + toObjectOffset), Direction(toObjectLinear * ray.d.d), ray.time);
+}
+
+std::vector<Point> Instance::intersections(const Ray& ray) const {
+    vector<Point> points = object->intersections(toObject(ray));
+    for (auto& p : points) {
+        Vector4d world = transformation_matrix * Vector4d(p.x(), p.y(), p.z(), 1.0);
+        p = Point(world.head<3>());
+    }
+    return points;
+}
+
+bool Instance::closestHit(const Ray& ray, double tMin, double tMax, HitRecord& hit) const {
+    if (!object->closestHit(toObject(ray), tMin, tMax, hit)) {
+        return false;
+    }
+    hit.point = ray.o + ray.d * hit.t;
+    hit.normal = Direction(normalMatrix * hit.normal.d).normalized();
+    return true;
+}
+
+bool Instance::occludes(const Ray& ray, double tMin, double tMax) const {
+    // t is the same in both spaces
+    return object->occludes(toObject(ray), tMin, tMax);
+}
+
+void Instance::intersectPacket(RayPacket& packet, uint32_t mask, double tMin, int shapeIndex) const {
+    const Eigen::Matrix3d& m = toObjectLinear;
+    const Vector3d& o = toObjectOffset;
+
+    // Same lanes, hits and far bounds, in object space
+    RayPacket local;
+    local.active = packet.active;
+    local.time = packet.time;
+    for (int i = 0; i < RayPacket::SIZE; ++i) {
+        double ox = packet.ox[i], oy = packet.oy[i], oz = packet.oz[i];
+        double dx = packet.dx[i], dy = packet.dy[i], dz = packet.dz[i];
+        local.ox[i] = m(0, 0) * ox + m(0, 1) * oy + m(0, 2) * oz + o.x();
+        local.oy[i] = m(1, 0) * ox + m(1, 1) * oy + m(1, 2) * oz + o.y();
+        local.oz[i] = m(2, 0) * ox + m(2, 1) * oy + m(2, 2) * oz + o.z();
+        local.dx[i] = m(0, 0) * dx + m(0, 1) * dy + m(0, 2) * dz;
+        local.dy[i] = m(1, 0) * dx + m(1, 1) * dy + m(1, 2) * dz;
+        local.dz[i] = m(2, 0) * dx + m(2, 1) * dy + m(2, 2) * dz;
+        local.invDx[i] = 1.0 / local.dx[i];
+        local.invDy[i] = 1.0 / local.dy[i];
+        local.invDz[i] = 1.0 / local.dz[i];
+        local.t[i] = packet.t[i];
+        local.shape[i] = -1;
+    }
+
+    object->intersectPacket(local, mask, tMin, shapeIndex);
+
+    for (int i = 0; i < RayPacket::SIZE; ++i) {
+        if (local.shape[i] < 0) {
+            continue;
+        }
+        Vector3d n = (normalMatrix * Vector3d(local.nx[i], local.ny[i], local.nz[i])).normalized();
+        packet.t[i] = local.t[i];
+        packet.nx[i] = n.x();
+        packet.ny[i] = n.y();
+        packet.nz[i] = n.z();
+        packet.shape[i] = shapeIndex;
+    }
+}
+
+void Instance::print() const {
+    cout << "Instance of ";
+    object->print();
+}
+
+Matrix4d translation(const Vector3d& offset) {
+    Matrix4d m = Matrix4d::Identity();
+    m.topRightCorner<3, 1>() = offset;
+    return m;
+}
+
+Matrix4d rotation(const Vector3d& axis, double degrees) {
+    if (axis.norm() < 1e-12) {
+        throw invalid_argument("El eje de rotacion no puede ser nulo.");
+    }
+    Matrix4d m = Matrix4d::Identity();
+    m.topLeftCorner<3, 3>() = Eigen::AngleAxisd(degrees * M_PI / 180.0, axis.normalized()).toRotationMatrix();
+    return m;
+}
+
+Matrix4d scaling(const Vector3d& factors) {
+    Matrix4d m = Matrix4d::Identity();
+    m.diagonal().head<3>() = factors;
+    return m;
+}
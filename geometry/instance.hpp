@@ -0,0 +1,53 @@
+#ifndef INSTANCE_HPP
+#define INSTANCE_HPP
+
+#include "geometry.hpp"
+#include "geometric_shape.hpp"
+#include <memory>
+
+// A shared object (typically a mesh with its own BVH) placed in the world
+// by an affine transform. Rays are moved into object space on entry, so any
+// number of instances share the geometry and its acceleration structure:
+// the scene BVH over the instances and the object BVHs form a two-level
+// hierarchy. The object direction is not renormalised, which keeps t equal
+// in both spaces.
+class Instance : public GeometricShape {
+    public:
+        std::shared_ptr<const GeometricShape> object;
+        Matrix4d transformation_matrix;         // Object -> world
+        Matrix4d inverse_transformation_matrix; // World -> object
+
+        // Throws invalid_argument if the transform is not invertible
+        Instance(std::shared_ptr<const GeometricShape> object_, const Matrix4d& transform);
+
+        std::vector<Point> intersections(const Ray& ray) const override;
+
+        bool closestHit(const Ray& ray, double tMin, double tMax, HitRecord& hit) const override;
+
+        bool occludes(const Ray& ray, double tMin, double tMax) const override;
+
+        // Moves the whole packet into object space and runs the packet routine of the object
+        void intersectPacket(RayPacket& packet, uint32_t mask, double tMin, int shapeIndex) const override;
+
+        BoundingBox bounds() const override { return worldBounds; }
+
+        bool isBounded() const override { return object->isBounded(); }
+
+        void print() const override;
+
+    private:
+        // Cached parts of the matrices used by every intersection
+        Eigen::Matrix3d toObjectLinear;
+        Vector3d toObjectOffset;
+        Eigen::Matrix3d normalMatrix; // Inverse transpose of the linear part
+        BoundingBox worldBounds;
+
+        Ray toObject(const Ray& ray) const;
+};
+
+// Affine transforms used to place instances
+Matrix4d translation(const Vector3d& offset);
+Matrix4d rotation(const Vector3d& axis, double degrees);
+Matrix4d scaling(const Vector3d& factors);
+
+#endif // INSTANCE_HPP
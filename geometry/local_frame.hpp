@@ -0,0 +1,62 @@
+#ifndef LOCAL_FRAME_HPP
+#define LOCAL_FRAME_HPP
+
+#include "geometry.hpp"
+#include <cmath>
+
+// Orthonormal frame (origin and axes u, v, w) in which a shape has a simple
+// canonical form. The kernels move each ray into it with plain dot products,
+// so the frame is stored as scalars.
+struct LocalFrame {
+    double ox, oy, oz;
+    double ux, uy, uz;
+    double vx, vy, vz;
+    double wx, wy, wz;
+
+    LocalFrame() : LocalFrame(Point(0, 0, 0), Direction(1, 0, 0), Direction(0, 1, 0), Direction(0, 0, 1)) {}
+
+    // The axes must already be orthonormal
+    LocalFrame(const Point& origin, const Direction& u, const Direction& v, const Direction& w)
+        : ox(origin.x()), oy(origin.y()), oz(origin.z()),
+          ux(u.x()), uy(u.y()), uz(u.z()),
+          vx(v.x()), vy(v.y()), vz(v.z()),
+          wx(w.x()), wy(w.y()), wz(w.z()) {}
+
+    // Frame whose w axis is the given unit axis, with u and v completed
+    // without branches (Duff et al., "Building an orthonormal basis, revisited")
+    static LocalFrame around(const Point& origin, const Direction& w) {
+        const double sign = std::copysign(1.0, w.z());
+        const double a = -1.0 / (sign + w.z());
+        const double b = w.x() * w.y() * a;
+        Direction u(1.0 + sign * w.x() * w.x() * a, sign * b, -sign * w.x());
+        Direction v(b, sign + w.y() * w.y() * a, -w.y());
+        return LocalFrame(origin, u, v, w);
+    }
+
+    // Point and direction in local coordinates
+    void pointToLocal(double x, double y, double z, double& lx, double& ly, double& lz) const {
+        x -= ox; y -= oy; z -= oz;
+        lx = ux * x + uy * y + uz * z;
+        ly = vx * x + vy * y + vz * z;
+        lz = wx * x + wy * y + wz * z;
+    }
+
+    void directionToLocal(double x, double y, double z, double& lx, double& ly, double& lz) const {
+        lx = ux * x + uy * y + uz * z;
+        ly = vx * x + vy * y + vz * z;
+        lz = wx * x + wy * y + wz * z;
+    }
+
+    void directionToWorld(double lx, double ly, double lz, double& x, double& y, double& z) const {
+        x = ux * lx + vx * ly + wx * lz;
+        y = uy * lx + vy * ly + wy * lz;
+        z = uz * lx + vz * ly + wz * lz;
+    }
+
+    Point origin() const { return Point(ox, oy, oz); }
+    Direction u() const { return Direction(ux, uy, uz); }
+    Direction v() const { return Direction(vx, vy, vz); }
+    Direction w() const { return Direction(wx, wy, wz); }
+};
+
+#endif // LOCAL_FRAME_HPP
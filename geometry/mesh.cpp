@@ -0,0 +1,188 @@
+#include "mesh.hpp"
+#include "../ray.hpp"
+#include "../ray_packet.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+Mesh::Mesh(vector<Point> vertices_, vector<array<int, 3>> faces_)
+    : vertices(std::move(vertices_)), faces(std::move(faces_))
+{
+    checkFaces();
+
+    vector<BoundingBox> faceBounds(faces.size());
+    for (size_t f = 0; f < faces.size(); ++f) {
+        for (int index : faces[f]) {
+            faceBounds[f].expand(vertices[index].coords);
+        }
+    }
+    bvh.build(faceBounds);
+}
+
+Mesh::Mesh(vector<Point> vertices_, vector<array<int, 3>> faces_, BVH bvh_)
+    : vertices(std::move(vertices_)), faces(std::move(faces_)), bvh(std::move(bvh_))
+{
+    checkFaces();
+    if (bvh.primIndices.size() != faces.size()) {
+        throw invalid_argument("La BVH no corresponde a las caras de la malla.");
+    }
+}
+
+void Mesh::checkFaces() const {
+    const int numVertices = static_cast<int>(vertices.size());
+    for (const auto& face : faces) {
+        for (int index : face) {
+            if (index < 0 || index >= numVertices) {
+                throw invalid_argument("Indice de vertice fuera de rango en la malla: " + to_string(index));
+            }
+        }
+    }
+}
+
+bool Mesh::intersectFace(int face, const Ray& ray, double tMin, double tMax, double& t) const {
+    const array<int, 3>& f = faces[face];
+    const Vector3d& p0 = vertices[f[0]].coords;
+    Vector3d edge1 = vertices[f[1]].coords - p0;
+    Vector3d edge2 = vertices[f[2]].coords - p0;
+
+    Vector3d pvec = ray.d.d.cross(edge2);
+    double det = edge1.dot(pvec);
+    if (fabs(det) < 1e-12) {
+        return false; // Ray is parallel to the triangle plane
+    }
+
+    double invDet = 1.0 / det;
+    Vector3d tvec = ray.o.coords - p0;
+    double u = tvec.dot(pvec) * invDet;
+    if (u < 0 || u > 1) {
+        return false;
+    }
+
+    Vector3d qvec = tvec.cross(edge1);
+    double v = ray.d.d.dot(qvec) * invDet;
+    if (v < 0 || u + v > 1) {
+        return false;
+    }
+
+    t = edge2.dot(qvec) * invDet;
+    return t >= tMin && t <= tMax;
+}
+
+std::vector<Point> Mesh::intersections(const Ray& ray) const {
+    vector<double> hits;
+
+    // Collect every hit: tMax is never shrunk so all overlapping leaves are visited
+    double tMax = numeric_limits<double>::infinity();
+    bvh.traverse(ray, 0.0, tMax, [&](int face, double& tFar) {
+        double t;
+        if (intersectFace(face, ray, 0.0, tFar, t)) {
+            hits.push_back(t);
+        }
+        return false;
+    });
+
+    // Sort intersections so closest is first
+    sort(hits.begin(), hits.end());
+
+    vector<Point> intersectionPoints;
+    intersectionPoints.reserve(hits.size());
+    for (double t : hits) {
+        intersectionPoints.push_back(ray.o + ray.d * t);
+    }
+    return intersectionPoints;
+}
+
+bool Mesh::closestHit(const Ray& ray, double tMin, double tMax, HitRecord& hit) const {
+    int closestFace = -1;
+    bvh.traverse(ray, tMin, tMax, [&](int face, double& tFar) {
+        double t;
+        if (intersectFace(face, ray, tMin, tFar, t)) {
+            tFar = t;
+            closestFace = face;
+            return true;
+        }
+        return false;
+    });
+
+    if (closestFace < 0) {
+        return false;
+    }
+
+    const array<int, 3>& f = faces[closestFace];
+    hit.t = tMax;
+    hit.point = ray.o + ray.d * tMax;
+    hit.normal = (vertices[f[1]] - vertices[f[0]]).cross(vertices[f[2]] - vertices[f[0]]).normalized();
+    return true;
+}
+
+bool Mesh::occludes(const Ray& ray, double tMin, double tMax) const {
+    return bvh.traverseAny(ray, tMin, tMax, [&](int face) {
+        double t;
+        return intersectFace(face, ray, tMin, tMax, t);
+    });
+}
+
+void Mesh::intersectPacket(RayPacket& packet, uint32_t mask, double tMin, int shapeIndex) const {
+    bvh.traversePacket(packet, mask, tMin, [&](int face, RayPacket::Mask lanes) {
+        // Few lanes left: the scalar test is cheaper than a full lane loop
+        if (__builtin_popcount(lanes) <= 2) {
+            for (int i = 0; i < RayPacket::SIZE; ++i) {
+                double t;
+                if ((lanes & (1u << i)) && intersectFace(face, packet.ray(i), tMin, packet.t[i], t)) {
+                    const array<int, 3>& f = faces[face];
+                    Direction n = (vertices[f[1]] - vertices[f[0]]).cross(vertices[f[2]] - vertices[f[0]]).normalized();
+                    packet.t[i] = t;
+                    packet.nx[i] = n.x();
+                    packet.ny[i] = n.y();
+                    packet.nz[i] = n.z();
+                    packet.shape[i] = shapeIndex;
+                }
+            }
+            return;
+        }
+
+        const array<int, 3>& f = faces[face];
+        const Vector3d& p0 = vertices[f[0]].coords;
+        const Vector3d e1 = vertices[f[1]].coords - p0;
+        const Vector3d e2 = vertices[f[2]].coords - p0;
+        const Vector3d n = e1.cross(e2).normalized();
+
+        for (int i = 0; i < RayPacket::SIZE; ++i) {
+            double dx = packet.dx[i], dy = packet.dy[i], dz = packet.dz[i];
+            double px = dy * e2.z() - dz * e2.y();
+            double py = dz * e2.x() - dx * e2.z();
+            double pz = dx * e2.y() - dy * e2.x();
+            double det = e1.x() * px + e1.y() * py + e1.z() * pz;
+            double invDet = 1.0 / (fabs(det) > 1e-12 ? det : 1.0);
+
+            double tx = packet.ox[i] - p0.x(), ty = packet.oy[i] - p0.y(), tz = packet.oz[i] - p0.z();
+            double u = (tx * px + ty * py + tz * pz) * invDet;
+            double qx = ty * e1.z() - tz * e1.y();
+            double qy = tz * e1.x() - tx * e1.z();
+            double qz = tx * e1.y() - ty * e1.x();
+            double v = (dx * qx + dy * qy + dz * qz) * invDet;
+            double t = (e2.x() * qx + e2.y() * qy + e2.z() * qz) * invDet;
+
+            bool valid = ((lanes >> i) & 1u) && fabs(det) > 1e-12 && u >= 0 && v >= 0 && u + v <= 1
+                         && t >= tMin && t <= packet.t[i];
+            packet.t[i] = valid ? t : packet.t[i];
+            packet.nx[i] = valid ? n.x() : packet.nx[i];
+            packet.ny[i] = valid ? n.y() : packet.ny[i];
+            packet.nz[i] = valid ? n.z() : packet.nz[i];
+            packet.shape[i] = valid ? shapeIndex : packet.shape[i];
+        }
+    });
+}
+
+BoundingBox Mesh::bounds() const {
+    return bvh.bounds();
+}
+
+void Mesh::print() const {
+    cout << "Mesh: vertices=" << vertices.size() << ", triangles=" << faces.size() << endl;
+}
@@ -0,0 +1,46 @@
+#ifndef MESH_HPP
+#define MESH_HPP
+
+#include "geometry.hpp"
+#include "geometric_shape.hpp"
+#include "bvh.hpp"
+#include <array>
+#include <vector>
+
+class Mesh : public GeometricShape {
+    public:
+        std::vector<Point> vertices;
+        std::vector<std::array<int, 3>> faces; // Vertex indices of each triangle
+        BVH bvh; // Hierarchy over the triangles
+
+        // Builds the BVH over the faces
+        Mesh(std::vector<Point> vertices_, std::vector<std::array<int, 3>> faces_);
+
+        // Reuses an already built BVH (e.g. read back from a scene cache)
+        Mesh(std::vector<Point> vertices_, std::vector<std::array<int, 3>> faces_, BVH bvh_);
+
+        // Override the pure virtual method
+        std::vector<Point> intersections(const Ray& ray) const override;
+        
+        // Closest intersection in [tMin, tMax]
+        bool closestHit(const Ray& ray, double tMin, double tMax, HitRecord& hit) const override;
+        
+        // Any intersection in [tMin, tMax]
+        bool occludes(const Ray& ray, double tMin, double tMax) const override;
+        
+        // Lane by lane version over a ray packet, written to be vectorised
+        void intersectPacket(RayPacket& packet, uint32_t mask, double tMin, int shapeIndex) const override;
+        
+        BoundingBox bounds() const override;
+
+        // Override the print method
+        void print() const override;
+
+    private:
+        void checkFaces() const;
+
+        // Moller-Trumbore test of one triangle, t must lie in [tMin, tMax]
+        bool intersectFace(int face, const Ray& ray, double tMin, double tMax, double& t) const;
+};
+
+#endif // MESH_HPP
@@ -0,0 +1,586 @@
+#include "mesh_loader.hpp"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+
+// Smallest amount of bytes worth handing to a separate parsing thread
+const size_t MIN_CHUNK_BYTES = 1 << 20;
+
+// Read-only memory mapping of a whole file
+class MappedFile {
+    public:
+        const char* data;
+        size_t size;
+
+        MappedFile(const string& filename) : data(nullptr), size(0) {
+            int fd = open(filename.c_str(), O_RDONLY);
+            if (fd < 0) {
+                throw runtime_error("Cannot open file: " + filename);
+            }
+
+            struct stat st;
+            if (fstat(fd, &st) != 0) {
+                close(fd);
+                throw runtime_error("Cannot stat file: " + filename);
+            }
+
+            size = static_cast<size_t>(st.st_size);
+            if (size > 0) {
+                void* ptr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (ptr == MAP_FAILED) {
+                    close(fd);
+                    throw runtime_error("Cannot map file: " + filename);
+                }
+                // Every chunk is read exactly once, let the kernel prefetch it all
+                madvise(ptr, size, MADV_WILLNEED);
+                data = static_cast<const char*>(ptr);
+            }
+            close(fd);
+        }
+
+        ~MappedFile() {
+            if (data) {
+                munmap(const_cast<char*>(data), size);
+            }
+        }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+};
+
+unsigned chunkCount(unsigned threads, size_t bytes) {
+    if (threads == 0) {
+        threads = thread::hardware_concurrency();
+    }
+    size_t bySize = bytes / MIN_CHUNK_BYTES + 1;
+    return static_cast<unsigned>(max<size_t>(1, min<size_t>(max(1u, threads), bySize)));
+}
+
+// Runs task(i) for every i in [0, count), each one on its own thread.
+// The first exception thrown by any task is rethrown once all have finished.
+template <typename Task>
+void runParallel(unsigned count, Task task) {
+    vector<exception_ptr> errors(count);
+    vector<thread> workers;
+    for (unsigned i = 1; i < count; ++i) {
+        workers.emplace_back([&task, &errors, i]() {
+            try { task(i); } catch (...) { errors[i] = current_exception(); }
+        });
+    }
+    try { task(0); } catch (...) { errors[0] = current_exception(); }
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    for (auto& error : errors) {
+        if (error) {
+            rethrow_exception(error);
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Wavefront OBJ
+// ---------------------------------------------------------------------------
+
+struct ObjChunk {
+    vector<Point> vertices;
+    vector<array<int, 3>> faces;
+    // Face corners given with negative (relative) indices. They are stored
+    // relative to the first vertex of the chunk until the chunk offset is known.
+    vector<size_t> relativeCorners;
+};
+
+inline bool isBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+inline const char* skipBlanks(const char* p, const char* end) {
+    while (p < end && isBlank(*p)) {
+        ++p;
+    }
+    return p;
+}
+
+inline const char* parseDouble(const char* p, const char* end, double& value) {
+    p = skipBlanks(p, end);
+    if (p < end && *p == '+') {
+        ++p;
+    }
+    auto result = from_chars(p, end, value);
+    if (result.ec != errc()) {
+        throw runtime_error("OBJ: malformed vertex coordinate");
+    }
+    return result.ptr;
+}
+
+void parseObjChunk(const char* p, const char* end, ObjChunk& chunk) {
+    // (index, relative) pairs of the polygon being read
+    vector<pair<int, bool>> polygon;
+
+    while (p < end) {
+        const char* lineEnd = static_cast<const char*>(memchr(p, '\n', end - p));
+        if (!lineEnd) {
+            lineEnd = end;
+        }
+        p = skipBlanks(p, lineEnd);
+
+        if (lineEnd - p > 1 && p[0] == 'v' && isBlank(p[1])) {
+            double x, y, z;
+            const char* q = parseDouble(p + 1, lineEnd, x);
+            q = parseDouble(q, lineEnd, y);
+            parseDouble(q, lineEnd, z);
+            chunk.vertices.emplace_back(x, y, z);
+        } else if (lineEnd - p > 1 && p[0] == 'f' && isBlank(p[1])) {
+            polygon.clear();
+            const char* q = skipBlanks(p + 1, lineEnd);
+            while (q < lineEnd) {
+                int index;
+                auto result = from_chars(q, lineEnd, index);
+                if (result.ec != errc() || index == 0) {
+                    throw runtime_error("OBJ: malformed face index");
+                }
+                if (index > 0) {
+                    polygon.emplace_back(index - 1, false);
+                } else {
+                    polygon.emplace_back(static_cast<int>(chunk.vertices.size()) + index, true);
+                }
+                // Skip texture/normal references ("v/vt/vn")
+                q = result.ptr;
+                while (q < lineEnd && !isBlank(*q)) {
+                    ++q;
+                }
+                q = skipBlanks(q, lineEnd);
+            }
+            if (polygon.size() < 3) {
+                throw runtime_error("OBJ: face with less than 3 vertices");
+            }
+
+            // Fan triangulation
+            for (size_t i = 1; i + 1 < polygon.size(); ++i) {
+                const pair<int, bool> corners[3] = { polygon[0], polygon[i], polygon[i + 1] };
+                array<int, 3> face;
+                for (int k = 0; k < 3; ++k) {
+                    face[k] = corners[k].first;
+                    if (corners[k].second) {
+                        chunk.relativeCorners.push_back(chunk.faces.size() * 3 + k);
+                    }
+                }
+                chunk.faces.push_back(face);
+            }
+        }
+        // Any other record (vt, vn, g, o, usemtl, comments...) is ignored
+
+        p = lineEnd < end ? lineEnd + 1 : end;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Binary PLY
+// ---------------------------------------------------------------------------
+
+enum class PlyType { Int8, UInt8, Int16, UInt16, Int32, UInt32, Float32, Float64 };
+
+struct PlyProperty {
+    string name;
+    PlyType type;       // Value type (item type for lists)
+    bool isList;
+    PlyType countType;  // Only meaningful for lists
+};
+
+struct PlyElement {
+    string name;
+    size_t count;
+    vector<PlyProperty> properties;
+};
+
+PlyType parsePlyType(const string& name) {
+    if (name == "char" || name == "int8") return PlyType::Int8;
+    if (name == "uchar" || name == "uint8") return PlyType::UInt8;
+    if (name == "short" || name == "int16") return PlyType::Int16;
+    if (name == "ushort" || name == "uint16") return PlyType::UInt16;
+    if (name == "int" || name == "int32") return PlyType::Int32;
+    if (name == "uint" || name == "uint32") return PlyType::UInt32;
+    if (name == "float" || name == "float32") return PlyType::Float32;
+    if (name == "double" || name == "float64") return PlyType::Float64;
+    throw runtime_error("PLY: unknown property type '" + name + "'");
+}
+
+size_t plySize(PlyType type) {
+    switch (type) {
+        case PlyType::Int8: case PlyType::UInt8: return 1;
+        case PlyType::Int16: case PlyType::UInt16: return 2;
+        case PlyType::Int32: case PlyType::UInt32: case PlyType::Float32: return 4;
+        case PlyType::Float64: return 8;
+    }
+    return 0;
+}
+
+template <typename T>
+inline T readRaw(const char* p, bool swapBytes) {
+    char bytes[sizeof(T)];
+    memcpy(bytes, p, sizeof(T));
+    if (swapBytes) {
+        reverse(bytes, bytes + sizeof(T));
+    }
+    T value;
+    memcpy(&value, bytes, sizeof(T));
+    return value;
+}
+
+inline double readPlyValue(const char* p, PlyType type, bool swapBytes) {
+    switch (type) {
+        case PlyType::Int8: return readRaw<int8_t>(p, false);
+        case PlyType::UInt8: return readRaw<uint8_t>(p, false);
+        case PlyType::Int16: return readRaw<int16_t>(p, swapBytes);
+        case PlyType::UInt16: return readRaw<uint16_t>(p, swapBytes);
+        case PlyType::Int32: return readRaw<int32_t>(p, swapBytes);
+        case PlyType::UInt32: return readRaw<uint32_t>(p, swapBytes);
+        case PlyType::Float32: return readRaw<float>(p, swapBytes);
+        case PlyType::Float64: return readRaw<double>(p, swapBytes);
+    }
+    return 0;
+}
+
+inline int readPlyIndex(const char* p, PlyType type, bool swapBytes) {
+    double value = readPlyValue(p, type, swapBytes);
+    if (value < 0 || value > numeric_limits<int>::max()) {
+        throw runtime_error("PLY: vertex index out of range");
+    }
+    return static_cast<int>(value);
+}
+
+bool hostIsLittleEndian() {
+    const uint16_t probe = 1;
+    return *reinterpret_cast<const uint8_t*>(&probe) == 1;
+}
+
+// Size in bytes of one record of an element without list properties
+size_t fixedRecordSize(const PlyElement& element) {
+    size_t size = 0;
+    for (const auto& property : element.properties) {
+        if (property.isList) {
+            return 0;
+        }
+        size += plySize(property.type);
+    }
+    return size;
+}
+
+// Walks one record of an element with list properties, returning its end
+const char* skipPlyRecord(const char* p, const char* end, const PlyElement& element, bool swapBytes) {
+    for (const auto& property : element.properties) {
+        if (property.isList) {
+            if (p + plySize(property.countType) > end) {
+                throw runtime_error("PLY: file is truncated");
+            }
+            size_t n = static_cast<size_t>(readPlyValue(p, property.countType, swapBytes));
+            p += plySize(property.countType) + n * plySize(property.type);
+        } else {
+            p += plySize(property.type);
+        }
+        if (p > end) {
+            throw runtime_error("PLY: file is truncated");
+        }
+    }
+    return p;
+}
+
+} // namespace
+
+std::unique_ptr<Mesh> loadOBJ(const std::string& filename, unsigned threads) {
+    MappedFile file(filename);
+    const char* begin = file.data;
+    const char* end = file.data + file.size;
+
+    // Split the file in chunks that start right after a line break
+    unsigned numChunks = chunkCount(threads, file.size);
+    vector<const char*> bounds(numChunks + 1, end);
+    bounds[0] = begin;
+    for (unsigned i = 1; i < numChunks; ++i) {
+        const char* p = begin + file.size / numChunks * i;
+        p = max(p, bounds[i - 1]);
+        const char* nl = static_cast<const char*>(memchr(p, '\n', end - p));
+        bounds[i] = nl ? nl + 1 : end;
+    }
+
+    vector<ObjChunk> chunks(numChunks);
+    runParallel(numChunks, [&](unsigned i) {
+        parseObjChunk(bounds[i], bounds[i + 1], chunks[i]);
+    });
+
+    // Offsets of every chunk in the final arrays
+    vector<size_t> vertexBase(numChunks + 1, 0), faceBase(numChunks + 1, 0);
+    for (unsigned i = 0; i < numChunks; ++i) {
+        vertexBase[i + 1] = vertexBase[i] + chunks[i].vertices.size();
+        faceBase[i + 1] = faceBase[i] + chunks[i].faces.size();
+    }
+    if (vertexBase[numChunks] > static_cast<size_t>(numeric_limits<int>::max())) {
+        throw runtime_error("OBJ: too many vertices");
+    }
+
+    vector<Point> vertices(vertexBase[numChunks]);
+    vector<array<int, 3>> faces(faceBase[numChunks]);
+    runParallel(numChunks, [&](unsigned i) {
+        ObjChunk& chunk = chunks[i];
+        for (size_t corner : chunk.relativeCorners) {
+            chunk.faces[corner / 3][corner % 3] += static_cast<int>(vertexBase[i]);
+        }
+        copy(chunk.vertices.begin(), chunk.vertices.end(), vertices.begin() + vertexBase[i]);
+        copy(chunk.faces.begin(), chunk.faces.end(), faces.begin() + faceBase[i]);
+        vector<Point>().swap(chunk.vertices);
+        vector<array<int, 3>>().swap(chunk.faces);
+    });
+
+    return make_unique<Mesh>(std::move(vertices), std::move(faces));
+}
+
+std::unique_ptr<Mesh> loadPLY(const std::string& filename, unsigned threads) {
+    MappedFile file(filename);
+    const char* end = file.data + file.size;
+
+    // Header
+    const char* headerEnd = nullptr;
+    const char marker[] = "end_header";
+    for (const char* p = file.data; p && p < end; ) {
+        const char* nl = static_cast<const char*>(memchr(p, '\n', end - p));
+        if (!nl) {
+            break;
+        }
+        if (static_cast<size_t>(nl - p) >= sizeof(marker) - 1 && memcmp(p, marker, sizeof(marker) - 1) == 0) {
+            headerEnd = nl + 1;
+            break;
+        }
+        p = nl + 1;
+    }
+    if (file.size < 4 || memcmp(file.data, "ply", 3) != 0 || !headerEnd) {
+        throw runtime_error("Not a valid PLY file: " + filename);
+    }
+
+    istringstream header(string(file.data, headerEnd));
+    string line;
+    vector<PlyElement> elements;
+    bool swapBytes = false;
+    bool formatFound = false;
+    while (getline(header, line)) {
+        istringstream tokens(line);
+        string keyword;
+        tokens >> keyword;
+        if (keyword == "format") {
+            string format;
+            tokens >> format;
+            if (format == "binary_little_endian") {
+                swapBytes = !hostIsLittleEndian();
+            } else if (format == "binary_big_endian") {
+                swapBytes = hostIsLittleEndian();
+            } else {
+                throw runtime_error("PLY: only binary files are supported (format " + format + ")");
+            }
+            formatFound = true;
+        } else if (keyword == "element") {
+            PlyElement element;
+            tokens >> element.name >> element.count;
+            elements.push_back(element);
+        } else if (keyword == "property") {
+            if (elements.empty()) {
+                throw runtime_error("PLY: property declared before any element");
+            }
+            PlyProperty property;
+            string type;
+            tokens >> type;
+            property.isList = (type == "list");
+            if (property.isList) {
+                string countType, itemType;
+                tokens >> countType >> itemType;
+                property.countType = parsePlyType(countType);
+                property.type = parsePlyType(itemType);
+            } else {
+                property.type = parsePlyType(type);
+                property.countType = property.type;
+            }
+            tokens >> property.name;
+            elements.back().properties.push_back(property);
+        }
+    }
+    if (!formatFound) {
+        throw runtime_error("PLY: missing format line");
+    }
+
+    vector<Point> vertices;
+    vector<array<int, 3>> faces;
+    const char* p = headerEnd;
+
+    for (const auto& element : elements) {
+        size_t recordSize = fixedRecordSize(element);
+
+        if (element.name == "vertex") {
+            if (recordSize == 0) {
+                throw runtime_error("PLY: list properties in vertices are not supported");
+            }
+            size_t offsets[3];
+            PlyType types[3];
+            const char* axes[3] = { "x", "y", "z" };
+            for (int k = 0; k < 3; ++k) {
+                size_t offset = 0;
+                bool found = false;
+                for (const auto& property : element.properties) {
+                    if (property.name == axes[k]) {
+                        offsets[k] = offset;
+                        types[k] = property.type;
+                        found = true;
+                        break;
+                    }
+                    offset += plySize(property.type);
+                }
+                if (!found) {
+                    throw runtime_error(string("PLY: vertex property '") + axes[k] + "' not found");
+                }
+            }
+            if (element.count > static_cast<size_t>(end - p) / recordSize) {
+                throw runtime_error("PLY: file is truncated");
+            }
+
+            // Fixed stride: every thread decodes its own range of vertices
+            vertices.resize(element.count);
+            unsigned numChunks = chunkCount(threads, element.count * recordSize);
+            const char* base = p;
+            runParallel(numChunks, [&](unsigned i) {
+                size_t first = element.count * i / numChunks;
+                size_t last = element.count * (i + 1) / numChunks;
+                for (size_t v = first; v < last; ++v) {
+                    const char* record = base + v * recordSize;
+                    vertices[v] = Point(readPlyValue(record + offsets[0], types[0], swapBytes),
+                                        readPlyValue(record + offsets[1], types[1], swapBytes),
+                                        readPlyValue(record + offsets[2], types[2], swapBytes));
+                }
+            });
+            p += element.count * recordSize;
+        } else if (element.name == "face") {
+            const PlyProperty* indices = nullptr;
+            for (const auto& property : element.properties) {
+                if (property.isList && (property.name == "vertex_indices" || property.name == "vertex_index")) {
+                    indices = &property;
+                }
+            }
+            if (!indices) {
+                throw runtime_error("PLY: face element without vertex_indices list");
+            }
+            size_t countSize = plySize(indices->countType);
+            size_t indexSize = plySize(indices->type);
+
+            // Fast path: faces are only triangles, so records have a fixed stride.
+            // Checking every count at that stride proves the layout is consistent.
+            bool fixedTriangles = element.properties.size() == 1;
+            size_t triangleSize = countSize + 3 * indexSize;
+            if (fixedTriangles && element.count > static_cast<size_t>(end - p) / triangleSize) {
+                fixedTriangles = false;
+            }
+            if (fixedTriangles) {
+                faces.resize(element.count);
+                unsigned numChunks = chunkCount(threads, element.count * triangleSize);
+                vector<char> valid(numChunks, 1);
+                const char* base = p;
+                runParallel(numChunks, [&](unsigned i) {
+                    size_t first = element.count * i / numChunks;
+                    size_t last = element.count * (i + 1) / numChunks;
+                    for (size_t f = first; f < last; ++f) {
+                        const char* record = base + f * triangleSize;
+                        if (readPlyValue(record, indices->countType, swapBytes) != 3) {
+                            valid[i] = 0;
+                            return;
+                        }
+                        const char* q = record + countSize;
+                        faces[f] = { readPlyIndex(q, indices->type, swapBytes),
+                                     readPlyIndex(q + indexSize, indices->type, swapBytes),
+                                     readPlyIndex(q + 2 * indexSize, indices->type, swapBytes) };
+                    }
+                });
+                fixedTriangles = find(valid.begin(), valid.end(), 0) == valid.end();
+                if (fixedTriangles) {
+                    p += element.count * triangleSize;
+                } else {
+                    faces.clear();
+                }
+            }
+
+            // General path: polygons of any size, sequential walk
+            if (!fixedTriangles) {
+                faces.reserve(element.count);
+                vector<int> polygon;
+                for (size_t f = 0; f < element.count; ++f) {
+                    for (const auto& property : element.properties) {
+                        if (!property.isList) {
+                            p += plySize(property.type);
+                            continue;
+                        }
+                        if (p + plySize(property.countType) > end) {
+                            throw runtime_error("PLY: file is truncated");
+                        }
+                        size_t n = static_cast<size_t>(readPlyValue(p, property.countType, swapBytes));
+                        p += plySize(property.countType);
+                        if (p + n * plySize(property.type) > end) {
+                            throw runtime_error("PLY: file is truncated");
+                        }
+                        if (&property == indices) {
+                            polygon.clear();
+                            for (size_t k = 0; k < n; ++k) {
+                                polygon.push_back(readPlyIndex(p + k * indexSize, property.type, swapBytes));
+                            }
+                            // Fan triangulation
+                            for (size_t k = 1; k + 1 < polygon.size(); ++k) {
+                                faces.push_back({ polygon[0], polygon[k], polygon[k + 1] });
+                            }
+                        }
+                        p += n * plySize(property.type);
+                    }
+                    if (p > end) {
+                        throw runtime_error("PLY: file is truncated");
+                    }
+                }
+            }
+        } else if (recordSize > 0) {
+            // Unused element with fixed size records
+            if (element.count > static_cast<size_t>(end - p) / recordSize) {
+                throw runtime_error("PLY: file is truncated");
+            }
+            p += element.count * recordSize;
+        } else {
+            for (size_t r = 0; r < element.count; ++r) {
+                p = skipPlyRecord(p, end, element, swapBytes);
+            }
+        }
+    }
+
+    return make_unique<Mesh>(std::move(vertices), std::move(faces));
+}
+
+std::unique_ptr<Mesh> loadMesh(const std::string& filename, unsigned threads) {
+    size_t dot = filename.find_last_of('.');
+    string extension = dot == string::npos ? "" : filename.substr(dot + 1);
+    transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+
+    if (extension == "obj") {
+        return loadOBJ(filename, threads);
+    }
+    if (extension == "ply") {
+        return loadPLY(filename, threads);
+    }
+    throw runtime_error("Unsupported mesh format (expected .obj or .ply): " + filename);
+}
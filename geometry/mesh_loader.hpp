@@ -0,0 +1,20 @@
+#ifndef MESH_LOADER_HPP
+#define MESH_LOADER_HPP
+
+#include "mesh.hpp"
+#include <memory>
+#include <string>
+
+// Mesh importers. Files are memory-mapped and parsed in parallel chunks;
+// threads = 0 uses every hardware thread available.
+
+// Loads a Wavefront OBJ file (only "v" and "f" records, polygons are fan-triangulated)
+std::unique_ptr<Mesh> loadOBJ(const std::string& filename, unsigned threads = 0);
+
+// Loads a binary (little or big endian) PLY file
+std::unique_ptr<Mesh> loadPLY(const std::string& filename, unsigned threads = 0);
+
+// Chooses the importer from the file extension (.obj or .ply)
+std::unique_ptr<Mesh> loadMesh(const std::string& filename, unsigned threads = 0);
+
+#endif // MESH_LOADER_HPP
@@ -0,0 +1,108 @@
+#include "moving_shape.hpp"
+#include "../ray.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+
+using namespace std;
+
+namespace {
+
+// Largest spin between two samples of the swept bounds
+const double SPIN_STEP = M_PI / 8.0;
+
+} // namespace
+
+MovingShape::MovingShape(std::shared_ptr<const GeometricShape> shape_, const Motion& motion_)
+    : shape(std::move(shape_)), motion(motion_)
+{
+    if (!shape) {
+        throw invalid_argument("La forma en movimiento no tiene forma.");
+    }
+    if (motion.angle != 0.0) {
+        if (motion.axis.norm() < 1e-12) {
+            throw invalid_argument("El eje de giro no puede ser nulo.");
+        }
+        motion.axis.normalize();
+    }
+
+    if (!shape->isBounded()) {
+        spunBounds = BoundingBox::infinite();
+        return;
+    }
+    const BoundingBox local = shape->bounds();
+    if (motion.angle == 0.0) {
+        spunBounds = local;
+        return;
+    }
+
+    // The box spun to a few sampled angles. Between two samples a point
+    // leaves the chord of its arc by at most r (1 - cos(step / 2)), r being
+    // its distance to the axis, which is largest at a corner of the box.
+    const int steps = max(1, static_cast<int>(ceil(fabs(motion.angle) / SPIN_STEP)));
+    double radius = 0.0;
+    for (int step = 0; step <= steps; ++step) {
+        Eigen::Matrix3d r = motion.rotationAt(static_cast<double>(step) / steps);
+        for (int corner = 0; corner < 8; ++corner) {
+            Vector3d p(((corner & 1) ? local.max.x() : local.min.x()) - motion.center.x(),
+                       ((corner & 2) ? local.max.y() : local.min.y()) - motion.center.y(),
+                       ((corner & 4) ? local.max.z() : local.min.z()) - motion.center.z());
+            spunBounds.expand(motion.center + r * p);
+            if (step == 0) {
+                radius = max(radius, (p - motion.axis * motion.axis.dot(p)).norm());
+            }
+        }
+    }
+    const double pad = radius * (1.0 - cos(0.5 * fabs(motion.angle) / steps));
+    spunBounds.min -= Vector3d::Constant(pad);
+    spunBounds.max += Vector3d::Constant(pad);
+}
+
+Ray MovingShape::toOpen(const Ray& ray, Eigen::Matrix3d& rotation) const {
+    rotation = motion.rotationAt(ray.time);
+    Vector3d o = ray.o.coords - ray.time * motion.offset - motion.center;
+    return Ray(Point(rotation.transpose() * o + motion.center), Direction(rotation.transpose() * ray.d.d), ray.time);
+}
+
+std::vector<Point> MovingShape::intersections(const Ray& ray) const {
+    Eigen::Matrix3d rotation;
+    vector<Point> points = shape->intersections(toOpen(ray, rotation));
+    for (auto& p : points) {
+        p = Point(motion.center + rotation * (p.coords - motion.center) + ray.time * motion.offset);
+    }
+    return points;
+}
+
+bool MovingShape::closestHit(const Ray& ray, double tMin, double tMax, HitRecord& hit) const {
+    Eigen::Matrix3d rotation;
+    if (!shape->closestHit(toOpen(ray, rotation), tMin, tMax, hit)) {
+        return false;
+    }
+    hit.point = ray.o + ray.d * hit.t;
+    hit.normal = Direction(rotation * hit.normal.d);
+    return true;
+}
+
+bool MovingShape::occludes(const Ray& ray, double tMin, double tMax) const {
+    Eigen::Matrix3d rotation;
+    return shape->occludes(toOpen(ray, rotation), tMin, tMax);
+}
+
+BoundingBox MovingShape::bounds() const {
+    BoundingBox open, close;
+    motionBounds(open, close);
+    open.expand(close);
+    return open;
+}
+
+void MovingShape::motionBounds(BoundingBox& open, BoundingBox& close) const {
+    open = spunBounds;
+    close = BoundingBox(spunBounds.min + motion.offset, spunBounds.max + motion.offset);
+}
+
+void MovingShape::print() const {
+    cout << "Moving (offset=" << Direction(motion.offset) << ", spin=" << motion.angle * 180.0 / M_PI
+         << " degrees) ";
+    shape->print();
+}
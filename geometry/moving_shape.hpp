@@ -0,0 +1,65 @@
+#ifndef MOVING_SHAPE_HPP
+#define MOVING_SHAPE_HPP
+
+#include "geometry.hpp"
+#include "geometric_shape.hpp"
+#include <memory>
+
+// Rigid motion over the exposure, with Ray::time going from 0 (shutter open)
+// to 1 (shutter close): a spin about an axis, with the right hand rule of
+// Planet, followed by a linear displacement. At time t a point p of the
+// shape at shutter open is at center + R(t) (p - center) + t offset.
+struct Motion {
+    Vector3d offset = Vector3d::Zero(); // Displacement from shutter open to shutter close
+    Vector3d center = Vector3d::Zero(); // Point on the spin axis
+    Vector3d axis = Vector3d::UnitZ();  // Unit spin axis
+    double angle = 0.0;                 // Spin from shutter open to shutter close, in radians
+
+    bool moves() const { return offset != Vector3d::Zero() || angle != 0.0; }
+
+    // Spin after the given time
+    Eigen::Matrix3d rotationAt(double time) const {
+        return angle == 0.0 ? Eigen::Matrix3d::Identity()
+                            : Eigen::AngleAxisd(angle * time, axis).toRotationMatrix();
+    }
+};
+
+// A shape (any of them, instances included) that moves during the exposure.
+// Rays are moved back to the pose at shutter open at their own time, like
+// an instance whose transform depends on the ray. The motion is rigid, so t
+// is the same in both frames.
+class MovingShape : public GeometricShape {
+    public:
+        std::shared_ptr<const GeometricShape> shape; // Pose at shutter open
+        Motion motion;
+
+        // Throws invalid_argument without a shape or with a null spin axis
+        MovingShape(std::shared_ptr<const GeometricShape> shape_, const Motion& motion_);
+
+        std::vector<Point> intersections(const Ray& ray) const override;
+
+        bool closestHit(const Ray& ray, double tMin, double tMax, HitRecord& hit) const override;
+
+        bool occludes(const Ray& ray, double tMin, double tMax) const override;
+
+        // Bounds of the whole motion
+        BoundingBox bounds() const override;
+
+        bool isBounded() const override { return shape->isBounded(); }
+
+        bool isMoving() const override { return true; }
+
+        // The displacement is linear, so the boxes at the ends are the spun
+        // bounds moved by 0 and by offset
+        void motionBounds(BoundingBox& open, BoundingBox& close) const override;
+
+        void print() const override;
+
+    private:
+        BoundingBox spunBounds; // Bounds of the spin alone over the exposure
+
+        // Ray in the frame of the shape at shutter open, and the spin at its time
+        Ray toOpen(const Ray& ray, Eigen::Matrix3d& rotation) const;
+};
+
+#endif // MOVING_SHAPE_HPP
@@ -1,5 +1,6 @@
 #include "plane.hpp"
 #include "../ray.hpp"
+#include "../ray_packet.hpp"
 #include <cmath>
 #include <iostream>
 
@@ -21,6 +22,55 @@ std::vector<Point> Plane::intersections(const Ray& ray) const {
     return intersectionPoints;
 }
 
+bool Plane::closestHit(const Ray& ray, double tMin, double tMax, HitRecord& hit) const {
+    double denom = ray.d.dot(normal);
+    if (fabs(denom) <= 1e-6) {
+        return false; // Ray is parallel to the plane
+    }
+
+    double t = (origin - ray.o).dot(normal) / denom;
+    if (t < tMin || t > tMax) {
+        return false;
+    }
+
+    hit.t = t;
+    hit.point = ray.o + ray.d * t;
+    hit.normal = normal.normalized();
+    return true;
+}
+
+bool Plane::occludes(const Ray& ray, double tMin, double tMax) const {
+    double denom = ray.d.dot(normal);
+    if (fabs(denom) <= 1e-6) {
+        return false;
+    }
+    double t = (origin - ray.o).dot(normal) / denom;
+    return t >= tMin && t <= tMax;
+}
+
+void Plane::intersectPacket(RayPacket& packet, uint32_t mask, double tMin, int shapeIndex) const {
+    Direction n = normal.normalized();
+    const double nx = n.x(), ny = n.y(), nz = n.z();
+    const double offset = n.dot(origin - Point(0, 0, 0));
+
+    for (int i = 0; i < RayPacket::SIZE; ++i) {
+        double denom = packet.dx[i] * nx + packet.dy[i] * ny + packet.dz[i] * nz;
+        double dist = offset - (packet.ox[i] * nx + packet.oy[i] * ny + packet.oz[i] * nz);
+        double t = dist / (fabs(denom) > 1e-6 ? denom : 1.0);
+
+        bool valid = ((mask >> i) & 1u) && fabs(denom) > 1e-6 && t >= tMin && t <= packet.t[i];
+        packet.t[i] = valid ? t : packet.t[i];
+        packet.nx[i] = valid ? nx : packet.nx[i];
+        packet.ny[i] = valid ? ny : packet.ny[i];
+        packet.nz[i] = valid ? nz : packet.nz[i];
+        packet.shape[i] = valid ? shapeIndex : packet.shape[i];
+    }
+}
+
+BoundingBox Plane::bounds() const {
+    return BoundingBox::infinite();
+}
+
 void Plane::print() const {
     cout << "Plane: normal=" << normal << ", point=" << origin << endl;
 }
\ No newline at end of file
@@ -14,6 +14,18 @@ class Plane : public GeometricShape {
         // Override the pure virtual method
         std::vector<Point> intersections(const Ray& ray) const override;
         
+        // Closest intersection in [tMin, tMax]
+        bool closestHit(const Ray& ray, double tMin, double tMax, HitRecord& hit) const override;
+        
+        // Any intersection in [tMin, tMax]
+        bool occludes(const Ray& ray, double tMin, double tMax) const override;
+        
+        // Lane by lane version over a ray packet, written to be vectorised
+        void intersectPacket(RayPacket& packet, uint32_t mask, double tMin, int shapeIndex) const override;
+        
+        BoundingBox bounds() const override;
+        bool isBounded() const override { return false; }
+        
         // Override the print method
         void print() const override;
 };
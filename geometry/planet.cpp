@@ -0,0 +1,349 @@
+#include "planet.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+namespace {
+
+// Samples of the safety functions per turn of the fastest relative rotation
+const int WINDOW_SAMPLES_PER_TURN = 32;
+
+// Samples advanced by incremental rotations before the frames are evaluated
+// exactly again, which bounds the drift of the repeated products
+const int WINDOW_RESYNC = 256;
+
+// Root finding stops when the bracket is below this fraction of a sample step
+// (or below the resolution of the time values)
+const double WINDOW_TOLERANCE = 1e-9;
+const int WINDOW_MAX_ITERATIONS = 100;
+
+// A station moving with its planet. Only what the safety functions need is
+// kept: the offset from the planet center and the unit normal k.
+struct StationMotion {
+    Vector3d center;
+    Vector3d axis;
+    double rate;
+    Vector3d offset0, normal0; // At time 0
+    Vector3d offset, normal;   // At the current sample
+    Matrix3d step;             // Rotation of one sample step
+
+    StationMotion(const Planet& planet, const Station& station, double dt)
+        : center(planet.center.coords), axis(planet.axis.normalized().d), rate(planet.angular_rate),
+          offset0(station.position.coords - planet.center.coords), normal0(station.rotation.col(2)),
+          step(Eigen::AngleAxisd(rate * dt, axis).toRotationMatrix()) {}
+
+    void exact(double time, Vector3d& offsetAt, Vector3d& normalAt) const {
+        Matrix3d r = Eigen::AngleAxisd(rate * time, axis).toRotationMatrix();
+        offsetAt = r * offset0;
+        normalAt = r * normal0;
+    }
+
+    void reset(double time) { exact(time, offset, normal); }
+
+    void advance() {
+        offset = step * offset;
+        normal = step * normal;
+    }
+};
+
+// Local z of the direction at each end, signed so that both are positive
+// when the connection is safe
+struct SafetyMargins {
+    double launch;
+    double receive;
+};
+
+SafetyMargins margins(const Vector3d& launchPosition, const Vector3d& launchNormal,
+                      const Vector3d& receivePosition, const Vector3d& receiveNormal) {
+    Vector3d d = receivePosition - launchPosition;
+    return { launchNormal.dot(d), -receiveNormal.dot(d) };
+}
+
+// Root of f in [ta, tb], where f(ta) and f(tb) have different signs, by the
+// Illinois variant of regula falsi
+template <typename F>
+double findRoot(F f, double ta, double fa, double tb, double fb, double tolerance) {
+    int side = 0;
+    tolerance = max(tolerance, 4 * numeric_limits<double>::epsilon() * max(abs(ta), abs(tb)));
+    for (int iteration = 0; iteration < WINDOW_MAX_ITERATIONS && tb - ta > tolerance; ++iteration) {
+        double t = (ta * fb - tb * fa) / (fb - fa);
+        double ft = f(t);
+        if (ft == 0) {
+            return t;
+        }
+        if ((ft > 0) == (fa > 0)) {
+            ta = t;
+            fa = ft;
+            if (side == -1) {
+                fb *= 0.5;
+            }
+            side = -1;
+        } else {
+            tb = t;
+            fb = ft;
+            if (side == 1) {
+                fa *= 0.5;
+            }
+            side = 1;
+        }
+    }
+    return 0.5 * (ta + tb);
+}
+
+} // namespace
+
+Planet::Planet(const Point& center_, const Direction& axis_, const Point& city_ref_, double angular_rate_)
+    : center(center_), city_ref(city_ref_), axis(axis_), angular_rate(angular_rate_)
+{
+    // Check radius consistency
+    double radius_from_axis = axis.norm() / 2.0;
+    double radius_from_city = (city_ref - center).norm();
+
+    if (abs(radius_from_axis - radius_from_city) > 1e-6) {
+        throw invalid_argument("Radio inconsistente. Radio del eje: "
+            + to_string(radius_from_axis)
+            + ", Radio desde ciudad: "
+            + to_string(radius_from_city));
+    }
+
+    radius = radius_from_axis;
+    // Calculate the direction of center->city
+    Direction center_to_city = (city_ref - center);
+    // Get the perpendicular vector of the axis and the center->city
+    Direction equatorial = axis.cross(center_to_city);
+    // Calculate the perpendicular projection of the equatorial and the axis
+    azimut0 = equatorial.cross(axis);
+
+    // Normalize directions
+    Direction equatorial_norm = equatorial.normalized();
+    Direction azimut0_norm = azimut0.normalized();
+    Direction axis_norm = axis.normalized();
+
+    // Build transformation matrix
+    transformation_matrix(0,0) = azimut0_norm.x();
+    transformation_matrix(0,1) = equatorial_norm.x();
+    transformation_matrix(0,2) = axis_norm.x();
+    transformation_matrix(0,3) = center.x();
+
+    transformation_matrix(1,0) = azimut0_norm.y();
+    transformation_matrix(1,1) = equatorial_norm.y();
+    transformation_matrix(1,2) = axis_norm.y();
+    transformation_matrix(1,3) = center.y();
+
+    transformation_matrix(2,0) = azimut0_norm.z();
+    transformation_matrix(2,1) = equatorial_norm.z();
+    transformation_matrix(2,2) = axis_norm.z();
+    transformation_matrix(2,3) = center.z();
+
+    transformation_matrix(3,0) = 0;
+    transformation_matrix(3,1) = 0;
+    transformation_matrix(3,2) = 0;
+    transformation_matrix(3,3) = 1;
+
+    inverse_transformation_matrix = transformation_matrix.inverse();
+}
+
+Matrix3d Planet::rotationAt(double time) const {
+    return Eigen::AngleAxisd(angular_rate * time, axis.normalized().d).toRotationMatrix();
+}
+
+Station::Station(const Planet& planet, double inclination_, double azimut_, int planet_index_)
+    : inclination(inclination_), azimut(azimut_), planet_index(planet_index_), position(0, 0, 0)
+{
+    position = Point(
+        planet.center.x() + planet.radius * sin(inclination) * cos(azimut),
+        planet.center.y() + planet.radius * sin(inclination) * sin(azimut),
+        planet.center.z() + planet.radius * cos(inclination)
+    );
+
+    // k: Normal to surface
+    k = (position - planet.center);
+
+    // i: Tangent to longitude (azimut direction)
+    i = planet.axis.cross(k);
+
+    // j: Tangent to latitude (inclination direction)
+    j = i.cross(k);
+
+    Direction i_norm = i.normalized();
+    Direction j_norm = j.normalized();
+    Direction k_norm = k.normalized();
+
+    transformation_matrix(0,0) = i_norm.x();
+    transformation_matrix(0,1) = j_norm.x();
+    transformation_matrix(0,2) = k_norm.x();
+    transformation_matrix(0,3) = position.x();
+
+    transformation_matrix(1,0) = i_norm.y();
+    transformation_matrix(1,1) = j_norm.y();
+    transformation_matrix(1,2) = k_norm.y();
+    transformation_matrix(1,3) = position.y();
+
+    transformation_matrix(2,0) = i_norm.z();
+    transformation_matrix(2,1) = j_norm.z();
+    transformation_matrix(2,2) = k_norm.z();
+    transformation_matrix(2,3) = position.z();
+
+    transformation_matrix(3,0) = 0;
+    transformation_matrix(3,1) = 0;
+    transformation_matrix(3,2) = 0;
+    transformation_matrix(3,3) = 1;
+
+    inverse_transformation_matrix = transformation_matrix.inverse();
+    rotation = transformation_matrix.block<3, 3>(0, 0);
+}
+
+void Station::printPosition() const {
+    cout << "Posicion de la estacion: ("
+         << position.x() << ", "
+         << position.y() << ", "
+         << position.z() << ")" << endl;
+}
+
+Direction Station::localToGlobal(const Direction& localDir) const {
+    // Rotation block of inverse_transformation_matrix (the inverse of a rotation is its transpose)
+    return Direction(rotation.transpose() * localDir.d);
+}
+
+Direction Station::globalToLocal(const Direction& globalDir) const {
+    return Direction(rotation.transpose() * globalDir.d);
+}
+
+StationFrame Station::frameAt(const Planet& planet, double time) const {
+    Matrix3d r = planet.rotationAt(time);
+    return { Point(planet.center.coords + r * (position.coords - planet.center.coords)), r * rotation };
+}
+
+Connection::Connection(const Station* launch, const Station* receive)
+    : launch_station(launch), receive_station(receive)
+{
+    // Calculate global direction from launch to receive
+    global_direction = (receive_station->position - launch_station->position);
+
+    // Convert to local coordinates for each station
+    launch_local_direction = launch_station->globalToLocal(global_direction);
+
+    // For receive station, we need the INCOMING direction (opposite)
+    receive_local_direction = receive_station->globalToLocal(global_direction);
+
+    // Check safety: direction must point away from planet surface (positive k component)
+    safe_launch = launch_local_direction.z() > 0;   // pointing outward from planet
+    safe_receive = receive_local_direction.z() < 0; // incoming from outward
+}
+
+void Connection::printConnection() const {
+    cout << "=== CONEXIÓN INTERPLANETARIA ===" << endl;
+    cout << "Direccion global UCS: ("
+         << global_direction.x() << ", "
+         << global_direction.y() << ", "
+         << global_direction.z() << ")" << endl;
+
+    cout << "\nEstacion de lanzamiento:" << endl;
+    cout << "Coordenadas locales de salida: ("
+         << launch_local_direction.x() << ", "
+         << launch_local_direction.y() << ", "
+         << launch_local_direction.z() << ")" << endl;
+
+    cout << "Estacion receptora:" << endl;
+    cout << "Coordenadas locales de entrada: ("
+         << receive_local_direction.x() << ", "
+         << receive_local_direction.y() << ", "
+         << receive_local_direction.z() << ")" << endl;
+
+    // Safety warnings
+    if (!safe_launch) {
+        cout << "\nADVERTENCIA: La catapulta cuantica apunta hacia el interior del planeta de lanzamiento. OPERACION PELIGROSA." << endl;
+    }
+    if (!safe_receive) {
+        cout << "\nADVERTENCIA: La materia traspasa el interior del planeta receptor. OPERACION PELIGROSA." << endl;
+    }
+    if (safe_launch && safe_receive) {
+        cout << "\nConexion segura establecida." << endl;
+    }
+}
+
+vector<TimeWindow> connectionWindows(const Planet& launchPlanet, const Station& launch,
+                                    const Planet& receivePlanet, const Station& receive,
+                                    double t0, double t1) {
+    if (!(t1 >= t0)) {
+        throw invalid_argument("Intervalo de tiempo invalido: [" + to_string(t0) + ", " + to_string(t1) + "]");
+    }
+
+    // The safety functions mix the two rotations, so the fastest frequency
+    // they contain is the sum of both rates
+    const double speed = abs(launchPlanet.angular_rate) + abs(receivePlanet.angular_rate);
+    const long steps = speed > 0 ? max(1L, static_cast<long>(ceil((t1 - t0) * speed / (2 * M_PI) * WINDOW_SAMPLES_PER_TURN))) : 1;
+    const double dt = (t1 - t0) / steps;
+
+    StationMotion a(launchPlanet, launch, dt), b(receivePlanet, receive, dt);
+    auto exactMargins = [&](double t) {
+        Vector3d offsetA, normalA, offsetB, normalB;
+        a.exact(t, offsetA, normalA);
+        b.exact(t, offsetB, normalB);
+        return margins(a.center + offsetA, normalA, b.center + offsetB, normalB);
+    };
+    auto launchMargin = [&](double t) { return exactMargins(t).launch; };
+    auto receiveMargin = [&](double t) { return exactMargins(t).receive; };
+
+    vector<TimeWindow> windows;
+    a.reset(t0);
+    b.reset(t0);
+    SafetyMargins previous = margins(a.center + a.offset, a.normal, b.center + b.offset, b.normal);
+    bool safe = previous.launch > 0 && previous.receive > 0;
+    double open = t0;
+
+    for (long s = 1; s <= steps && speed > 0; ++s) {
+        const double tPrevious = t0 + (s - 1) * dt, t = s == steps ? t1 : t0 + s * dt;
+        if (s % WINDOW_RESYNC == 0) {
+            a.reset(t);
+            b.reset(t);
+        } else {
+            a.advance();
+            b.advance();
+        }
+        SafetyMargins current = margins(a.center + a.offset, a.normal, b.center + b.offset, b.normal);
+
+        // Sign changes inside the step, in time order
+        struct Event { double t; bool launch; };
+        Event events[2];
+        int count = 0;
+        if ((previous.launch > 0) != (current.launch > 0)) {
+            events[count++] = { findRoot(launchMargin, tPrevious, previous.launch, t, current.launch, WINDOW_TOLERANCE * dt), true };
+        }
+        if ((previous.receive > 0) != (current.receive > 0)) {
+            events[count++] = { findRoot(receiveMargin, tPrevious, previous.receive, t, current.receive, WINDOW_TOLERANCE * dt), false };
+        }
+        if (count == 2 && events[1].t < events[0].t) {
+            swap(events[0], events[1]);
+        }
+
+        bool launchOk = previous.launch > 0, receiveOk = previous.receive > 0;
+        for (int e = 0; e < count; ++e) {
+            if (events[e].launch) {
+                launchOk = !launchOk;
+            } else {
+                receiveOk = !receiveOk;
+            }
+            bool now = launchOk && receiveOk;
+            if (now != safe) {
+                if (now) {
+                    open = events[e].t;
+                } else {
+                    windows.push_back({ open, events[e].t });
+                }
+                safe = now;
+            }
+        }
+        previous = current;
+    }
+
+    if (safe) {
+        windows.push_back({ open, t1 });
+    }
+    return windows;
+}
@@ -0,0 +1,104 @@
+#ifndef PLANET_HPP
+#define PLANET_HPP
+
+#include "geometry.hpp"
+#include <vector>
+
+using Eigen::Matrix3d;
+
+class Planet {
+    public:
+        // Key points
+        Point center;
+        Point city_ref;
+        // Planet radius
+        double radius;
+        // Main directions
+        Direction axis; // from south to north pole (k)
+        Direction azimut0; // in the same plane as equatorial and perpendicular to axis (i)
+        Direction equatorial; // perpendicular to axis and azimut0 (j)
+        // Transformation matrices from world coordinates to planet coordinates and vice versa
+        Matrix4d transformation_matrix;
+        Matrix4d inverse_transformation_matrix;
+        // Rotation about the axis in radians per unit of time (right hand rule,
+        // so positive is counterclockwise seen from the north pole)
+        double angular_rate;
+
+        // Throws invalid_argument if the axis and the city give different radii
+        Planet(const Point& center_, const Direction& axis_, const Point& city_ref_, double angular_rate_ = 0.0);
+
+        // Rotation of the planet after the given time
+        Matrix3d rotationAt(double time) const;
+};
+
+// Frame of a station at some time: position and unit axes (columns i, j, k)
+struct StationFrame {
+    Point position;
+    Matrix3d rotation;
+
+    Direction globalToLocal(const Direction& globalDir) const {
+        return Direction(rotation.transpose() * globalDir.d);
+    }
+};
+
+class Station {
+    public:
+        double inclination;
+        double azimut;
+        int planet_index; // Index of the planet in the catalogue (-1 outside one)
+        Point position;
+        Direction i, j ,k;
+        // Transformation matrix from planet coordinates to station coordinates and vice versa
+        Matrix4d transformation_matrix;
+        Matrix4d inverse_transformation_matrix;
+        // Rotation part of transformation_matrix (columns i, j, k normalised),
+        // built once instead of on every change of coordinates
+        Matrix3d rotation;
+
+        // The planet is only read here: stations keep its index, not a copy
+        Station(const Planet& planet, double inclination_, double azimut_, int planet_index_ = -1);
+
+        void printPosition() const;
+
+        // Convert direction from local coordinates (i,j,k) to global UCS coordinates
+        Direction localToGlobal(const Direction& localDir) const;
+
+        // Convert direction from global UCS coordinates to local coordinates (i,j,k)
+        Direction globalToLocal(const Direction& globalDir) const;
+
+        // Frame after the given time of rotation of its planet (the frame
+        // built by the constructor is the one at time 0)
+        StationFrame frameAt(const Planet& planet, double time) const;
+};
+
+class Connection {
+    public:
+        const Station* launch_station;
+        const Station* receive_station;
+        Direction global_direction;
+        Direction launch_local_direction;
+        Direction receive_local_direction;
+        bool safe_launch;
+        bool safe_receive;
+
+        Connection(const Station* launch, const Station* receive);
+
+        void printConnection() const;
+};
+
+// Interval of time [start, end]
+struct TimeWindow {
+    double start;
+    double end;
+};
+
+// Windows of [t0, t1] in which the connection from launch to receive is safe
+// while their planets rotate. The safety functions are sampled at a fraction
+// of the fastest relative rotation, with the station frames rotated
+// incrementally from sample to sample, and each sign change is located by
+// root finding. Throws invalid_argument if t1 < t0.
+std::vector<TimeWindow> connectionWindows(const Planet& launchPlanet, const Station& launch,
+                                          const Planet& receivePlanet, const Station& receive,
+                                          double t0, double t1);
+
+#endif // PLANET_HPP
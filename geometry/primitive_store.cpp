@@ -0,0 +1,95 @@
+#include "primitive_store.hpp"
+#include <typeinfo>
+
+using namespace std;
+
+namespace {
+
+FloatSphere toFloat(const Sphere& sphere) {
+    return { float(sphere.center.x()), float(sphere.center.y()), float(sphere.center.z()), float(sphere.radius),
+             float(1.0 / sphere.radius) };
+}
+
+FloatTriangle toFloat(const Triangle& triangle) {
+    FloatTriangle result;
+    const Point* vertices[3] = { &triangle.v0, &triangle.v1, &triangle.v2 };
+    for (int v = 0; v < 3; ++v) {
+        for (int axis = 0; axis < 3; ++axis) {
+            result.v[v][axis] = static_cast<float>(vertices[v]->coords[axis]);
+        }
+    }
+    Direction n = triangle.normal.normalized();
+    result.nx = float(n.x());
+    result.ny = float(n.y());
+    result.nz = float(n.z());
+    return result;
+}
+
+FloatPlane toFloat(const Plane& plane) {
+    Direction n = plane.normal.normalized();
+    return { float(n.x()), float(n.y()), float(n.z()), float(n.dot(plane.origin - Point(0, 0, 0))) };
+}
+
+} // namespace
+
+void PrimitiveStore::clear() {
+    spheres.clear();
+    triangles.clear();
+    planes.clear();
+    generic.clear();
+    floatSpheres.clear();
+    floatTriangles.clear();
+    floatPlanes.clear();
+    for (auto& indices : shapes) {
+        indices.clear();
+    }
+}
+
+PrimitiveStore::Ref PrimitiveStore::add(const GeometricShape& shape, int shapeIndex) {
+    // Exact type only: a subclass could override the intersection
+    Kind kind;
+    uint32_t slot;
+    if (typeid(shape) == typeid(Sphere)) {
+        kind = SPHERE;
+        slot = static_cast<uint32_t>(spheres.size());
+        spheres.push_back(static_cast<const Sphere&>(shape));
+        floatSpheres.push_back(toFloat(spheres.back()));
+    } else if (typeid(shape) == typeid(Triangle)) {
+        kind = TRIANGLE;
+        slot = static_cast<uint32_t>(triangles.size());
+        triangles.push_back(static_cast<const Triangle&>(shape));
+        floatTriangles.push_back(toFloat(triangles.back()));
+    } else if (typeid(shape) == typeid(Plane)) {
+        kind = PLANE;
+        slot = static_cast<uint32_t>(planes.size());
+        planes.push_back(static_cast<const Plane&>(shape));
+        floatPlanes.push_back(toFloat(planes.back()));
+    } else {
+        kind = GENERIC;
+        slot = static_cast<uint32_t>(generic.size());
+        generic.push_back(&shape);
+    }
+    shapes[kind].push_back(shapeIndex);
+    return static_cast<Ref>(kind) << 30 | slot;
+}
+
+PrimitiveStore::Ref PrimitiveStore::replace(Ref ref, const GeometricShape& shape) {
+    const uint32_t slot = slotOf(ref);
+    const Kind kind = kindOf(ref);
+    if (kind == SPHERE && typeid(shape) == typeid(Sphere)) {
+        spheres[slot] = static_cast<const Sphere&>(shape);
+        floatSpheres[slot] = toFloat(spheres[slot]);
+    } else if (kind == TRIANGLE && typeid(shape) == typeid(Triangle)) {
+        triangles[slot] = static_cast<const Triangle&>(shape);
+        floatTriangles[slot] = toFloat(triangles[slot]);
+    } else if (kind == PLANE && typeid(shape) == typeid(Plane)) {
+        planes[slot] = static_cast<const Plane&>(shape);
+        floatPlanes[slot] = toFloat(planes[slot]);
+    } else if (kind == GENERIC && typeid(shape) != typeid(Sphere) && typeid(shape) != typeid(Triangle)
+               && typeid(shape) != typeid(Plane)) {
+        generic[slot] = &shape;
+    } else {
+        return add(shape, shapes[kind][slot]);
+    }
+    return ref;
+}
@@ -0,0 +1,174 @@
+#ifndef PRIMITIVE_STORE_HPP
+#define PRIMITIVE_STORE_HPP
+
+#include "geometric_shape.hpp"
+#include "sphere.hpp"
+#include "plane.hpp"
+#include "triangle.hpp"
+#include "float_kernels.hpp"
+#include "trace_counters.hpp"
+#include "../ray_packet.hpp"
+#include <cstdint>
+#include <vector>
+
+// Primitives sorted by type: every analytic shape kind lives by value in its
+// own contiguous array and is intersected through a direct (non virtual,
+// inlinable) call, chosen by a switch on the kind. Composite shapes (meshes,
+// instances) keep their virtual path, as they spend their time inside.
+//
+// The analytic shapes are also kept in floats for the robust single
+// precision kernels of float_kernels.hpp; precision chooses which copy the
+// scene intersects. Composite shapes stay in double either way.
+class PrimitiveStore {
+    public:
+        enum Kind : uint32_t { SPHERE, TRIANGLE, PLANE, GENERIC };
+        enum class Precision { Double, Float };
+
+        // Kind in the top two bits, slot in the array of that kind below
+        using Ref = uint32_t;
+        static Kind kindOf(Ref ref) { return static_cast<Kind>(ref >> 30); }
+        static uint32_t slotOf(Ref ref) { return ref & 0x3fffffffu; }
+
+        std::vector<Sphere> spheres;
+        std::vector<Triangle> triangles;
+        std::vector<Plane> planes;
+        std::vector<const GeometricShape*> generic; // Not owned
+
+        // Same slots as spheres, triangles and planes
+        std::vector<FloatSphere> floatSpheres;
+        std::vector<FloatTriangle> floatTriangles;
+        std::vector<FloatPlane> floatPlanes;
+
+        // Kept by clear()
+        Precision precision = Precision::Double;
+
+        void clear();
+
+        // Copies the analytic shapes, keeps a pointer to the others.
+        // shapeIndex is reported back in the hits.
+        Ref add(const GeometricShape& shape, int shapeIndex);
+
+        // Puts shape in place of the primitive of ref and returns its ref,
+        // which only changes when the kind does: the new primitive then goes
+        // to a new slot and the old one stays unused until clear()
+        Ref replace(Ref ref, const GeometricShape& shape);
+
+        // Changes the scene shape index the hits of ref report
+        void setShape(Ref ref, int shapeIndex) { shapes[kindOf(ref)][slotOf(ref)] = shapeIndex; }
+
+        // Closest hit of the referenced primitive with t in [tMin, tMax]; sets hit.shape
+        bool closestHit(Ref ref, const Ray& ray, double tMin, double tMax, HitRecord& hit) const {
+            const uint32_t slot = slotOf(ref);
+            bool found;
+            switch (kindOf(ref)) {
+                case SPHERE: found = spheres[slot].Sphere::closestHit(ray, tMin, tMax, hit); break;
+                case TRIANGLE: found = triangles[slot].Triangle::closestHit(ray, tMin, tMax, hit); break;
+                case PLANE: found = planes[slot].Plane::closestHit(ray, tMin, tMax, hit); break;
+                default: found = generic[slot]->closestHit(ray, tMin, tMax, hit); break;
+            }
+            if (found) {
+                hit.shape = shapes[kindOf(ref)][slot];
+            }
+            INFGR_COUNT(countTest(ref, found));
+            return found;
+        }
+
+        // Any hit of the referenced primitive with t in [tMin, tMax], in
+        // double precision whatever the precision setting
+        bool occludes(Ref ref, const Ray& ray, double tMin, double tMax) const {
+            const uint32_t slot = slotOf(ref);
+            bool blocked;
+            switch (kindOf(ref)) {
+                case SPHERE: blocked = spheres[slot].Sphere::occludes(ray, tMin, tMax); break;
+                case TRIANGLE: blocked = triangles[slot].Triangle::occludes(ray, tMin, tMax); break;
+                case PLANE: blocked = planes[slot].Plane::occludes(ray, tMin, tMax); break;
+                default: blocked = generic[slot]->occludes(ray, tMin, tMax); break;
+            }
+            INFGR_COUNT(countTest(ref, blocked));
+            return blocked;
+        }
+
+        // Scene shape index of the referenced primitive
+        int shapeOf(Ref ref) const { return shapes[kindOf(ref)][slotOf(ref)]; }
+
+        void intersectPacket(Ref ref, RayPacket& packet, RayPacket::Mask mask, double tMin) const {
+            const uint32_t slot = slotOf(ref);
+            const int shape = shapes[kindOf(ref)][slot];
+            INFGR_COUNT(countLanes(ref, mask));
+            switch (kindOf(ref)) {
+                case SPHERE: spheres[slot].Sphere::intersectPacket(packet, mask, tMin, shape); break;
+                case TRIANGLE: triangles[slot].Triangle::intersectPacket(packet, mask, tMin, shape); break;
+                case PLANE: planes[slot].Plane::intersectPacket(packet, mask, tMin, shape); break;
+                default: generic[slot]->intersectPacket(packet, mask, tMin, shape); break;
+            }
+        }
+
+        // Float versions, for Precision::Float. Hits of the analytic shapes
+        // come with their error bound (hit.offset); the others with none.
+        bool closestHit(Ref ref, const Ray& ray, const FloatRay& floatRay, double tMin, double tMax,
+                        HitRecord& hit) const {
+            const uint32_t slot = slotOf(ref);
+            const float fMin = static_cast<float>(tMin), fMax = static_cast<float>(tMax);
+            FloatHit floatHit;
+            bool found;
+            switch (kindOf(ref)) {
+                case SPHERE: found = floatSphereHit(floatSpheres[slot], floatRay, fMin, fMax, floatHit); break;
+                case TRIANGLE: found = floatTriangleHit(floatTriangles[slot], floatRay, fMin, fMax, floatHit); break;
+                case PLANE: found = floatPlaneHit(floatPlanes[slot], floatRay, fMin, fMax, floatHit); break;
+                default:
+                    found = generic[slot]->closestHit(ray, tMin, tMax, hit);
+                    if (found) {
+                        hit.offset = 0.0;
+                        hit.shape = shapes[GENERIC][slot];
+                    }
+                    INFGR_COUNT(countTest(ref, found));
+                    return found;
+            }
+            if (found) {
+                hit.t = floatHit.t;
+                hit.point = Point(floatHit.px, floatHit.py, floatHit.pz);
+                hit.normal = Direction(floatHit.nx, floatHit.ny, floatHit.nz);
+                hit.offset = floatHit.offset;
+                hit.shape = shapes[kindOf(ref)][slot];
+            }
+            INFGR_COUNT(countTest(ref, found));
+            return found;
+        }
+
+        // Float hits stay in floatRays until FloatRayPacket::merge; the far
+        // bounds of packet are kept up to date for the traversal
+        void intersectPacket(Ref ref, FloatRayPacket& floatRays, RayPacket& packet, RayPacket::Mask mask,
+                             double tMin) const {
+            const uint32_t slot = slotOf(ref);
+            const int shape = shapes[kindOf(ref)][slot];
+            const float fMin = static_cast<float>(tMin);
+            INFGR_COUNT(countLanes(ref, mask));
+            switch (kindOf(ref)) {
+                case SPHERE: floatSpherePacket(floatSpheres[slot], floatRays, mask, fMin, shape); break;
+                case TRIANGLE: floatTrianglePacket(floatTriangles[slot], floatRays, mask, fMin, shape); break;
+                case PLANE: floatPlanePacket(floatPlanes[slot], floatRays, mask, fMin, shape); break;
+                default:
+                    generic[slot]->intersectPacket(packet, mask, tMin, shape);
+                    floatRays.takeDoubleHits(packet, shape);
+                    return;
+            }
+            floatRays.pushBounds(packet);
+        }
+
+    private:
+        // Scene shape index of every slot, by kind
+        std::vector<int> shapes[4];
+
+        // TraceCounters bookkeeping (INFGR_COUNTERS builds only)
+        static void countTest(Ref ref, bool hit) {
+            TraceCounters& counters = TraceCounters::local();
+            counters.primitiveTests[kindOf(ref)]++;
+            counters.primitiveHits[kindOf(ref)] += hit;
+        }
+
+        static void countLanes(Ref ref, RayPacket::Mask lanes) {
+            TraceCounters::local().primitiveTests[kindOf(ref)] += __builtin_popcount(lanes);
+        }
+};
+
+#endif // PRIMITIVE_STORE_HPP
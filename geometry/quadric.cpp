@@ -0,0 +1,137 @@
+#include "quadric.hpp"
+#include "../ray.hpp"
+#include "../ray_packet.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+
+using namespace std;
+
+namespace {
+
+const double INF = numeric_limits<double>::infinity();
+
+} // namespace
+
+Quadric::Quadric(const std::array<double, 10>& coefficients_, const BoundingBox& clip_)
+    : coefficients(coefficients_), clip(clip_) {
+    if (all_of(coefficients.begin(), coefficients.begin() + 9, [](double c) { return c == 0; })) {
+        throw invalid_argument("La cuadrica debe tener algun coeficiente no nulo salvo el termino independiente.");
+    }
+    if (clip.empty() || !clip.min.allFinite() || !clip.max.allFinite()) {
+        throw invalid_argument("La caja de recorte de la cuadrica debe ser finita y no vacia.");
+    }
+}
+
+void Quadric::roots(const double o[3], const double d[3], double t[2]) const {
+    const double A = coefficients[0], B = coefficients[1], C = coefficients[2];
+    const double D = coefficients[3], E = coefficients[4], F = coefficients[5];
+    const double G = coefficients[6], H = coefficients[7], I = coefficients[8], J = coefficients[9];
+
+    // f(o + t d) = a t^2 + 2 halfB t + c
+    const double a = A * d[0] * d[0] + B * d[1] * d[1] + C * d[2] * d[2]
+                   + D * d[0] * d[1] + E * d[0] * d[2] + F * d[1] * d[2];
+    const double halfB = A * o[0] * d[0] + B * o[1] * d[1] + C * o[2] * d[2]
+                       + 0.5 * (D * (o[0] * d[1] + o[1] * d[0]) + E * (o[0] * d[2] + o[2] * d[0])
+                                + F * (o[1] * d[2] + o[2] * d[1]) + G * d[0] + H * d[1] + I * d[2]);
+    const double c = A * o[0] * o[0] + B * o[1] * o[1] + C * o[2] * o[2]
+                   + D * o[0] * o[1] + E * o[0] * o[2] + F * o[1] * o[2]
+                   + G * o[0] + H * o[1] + I * o[2] + J;
+    const double discriminant = halfB * halfB - a * c;
+
+    // Roots without cancellation; a = 0 (degree one along this ray) leaves
+    // the single root c / q. Degenerate cases give inf or NaN and fail the tests.
+    const double q = -(halfB + copysign(sqrt(discriminant > 0 ? discriminant : 0.0), halfB));
+    const double s[2] = { q / a, c / q };
+    for (int k = 0; k < 2; ++k) {
+        const double x = o[0] + s[k] * d[0], y = o[1] + s[k] * d[1], z = o[2] + s[k] * d[2];
+        const bool inside = x >= clip.min.x() && x <= clip.max.x() && y >= clip.min.y() && y <= clip.max.y()
+                            && z >= clip.min.z() && z <= clip.max.z();
+        t[k] = discriminant >= 0 && inside ? s[k] : INF;
+    }
+}
+
+void Quadric::gradient(const double p[3], double n[3]) const {
+    const double A = coefficients[0], B = coefficients[1], C = coefficients[2];
+    const double D = coefficients[3], E = coefficients[4], F = coefficients[5];
+    const double G = coefficients[6], H = coefficients[7], I = coefficients[8];
+    const double gx = 2 * A * p[0] + D * p[1] + E * p[2] + G;
+    const double gy = 2 * B * p[1] + D * p[0] + F * p[2] + H;
+    const double gz = 2 * C * p[2] + E * p[0] + F * p[1] + I;
+    const double inv = 1.0 / sqrt(gx * gx + gy * gy + gz * gz);
+    n[0] = gx * inv;
+    n[1] = gy * inv;
+    n[2] = gz * inv;
+}
+
+std::vector<Point> Quadric::intersections(const Ray& ray) const {
+    double o[3] = { ray.o.x(), ray.o.y(), ray.o.z() };
+    double d[3] = { ray.d.x(), ray.d.y(), ray.d.z() };
+    double t[2];
+    roots(o, d, t);
+    if (t[1] < t[0]) {
+        swap(t[0], t[1]);
+    }
+
+    vector<Point> intersectionPoints;
+    for (int k = 0; k < 2; ++k) {
+        if (t[k] >= 0 && t[k] != INF && (k == 0 || t[k] != t[0])) {
+            intersectionPoints.push_back(ray.o + ray.d * t[k]);
+        }
+    }
+    return intersectionPoints;
+}
+
+bool Quadric::closestHit(const Ray& ray, double tMin, double tMax, HitRecord& hit) const {
+    double o[3] = { ray.o.x(), ray.o.y(), ray.o.z() };
+    double d[3] = { ray.d.x(), ray.d.y(), ray.d.z() };
+    double t[2];
+    roots(o, d, t);
+
+    bool first = t[0] >= tMin && t[0] <= tMax;
+    bool second = t[1] >= tMin && t[1] <= tMax && (!first || t[1] < t[0]);
+    if (!first && !second) {
+        return false;
+    }
+
+    double best = second ? t[1] : t[0];
+    double p[3] = { o[0] + best * d[0], o[1] + best * d[1], o[2] + best * d[2] };
+    double n[3];
+    gradient(p, n);
+    hit.t = best;
+    hit.point = Point(p[0], p[1], p[2]);
+    hit.normal = Direction(n[0], n[1], n[2]);
+    return true;
+}
+
+void Quadric::intersectPacket(RayPacket& packet, uint32_t mask, double tMin, int shapeIndex) const {
+    for (int i = 0; i < RayPacket::SIZE; ++i) {
+        double o[3] = { packet.ox[i], packet.oy[i], packet.oz[i] };
+        double d[3] = { packet.dx[i], packet.dy[i], packet.dz[i] };
+        double t[2];
+        roots(o, d, t);
+
+        bool first = t[0] >= tMin && t[0] <= packet.t[i];
+        bool second = t[1] >= tMin && t[1] <= packet.t[i] && (!first || t[1] < t[0]);
+        double best = second ? t[1] : t[0];
+        double p[3] = { o[0] + best * d[0], o[1] + best * d[1], o[2] + best * d[2] };
+        double n[3];
+        gradient(p, n);
+
+        bool valid = ((mask >> i) & 1u) && (first || second);
+        packet.t[i] = valid ? best : packet.t[i];
+        packet.nx[i] = valid ? n[0] : packet.nx[i];
+        packet.ny[i] = valid ? n[1] : packet.ny[i];
+        packet.nz[i] = valid ? n[2] : packet.nz[i];
+        packet.shape[i] = valid ? shapeIndex : packet.shape[i];
+    }
+}
+
+void Quadric::print() const {
+    cout << "Quadric: coefficients=";
+    for (size_t k = 0; k < coefficients.size(); ++k) {
+        cout << (k ? " " : "") << coefficients[k];
+    }
+    cout << ", clip min=" << Point(clip.min) << ", max=" << Point(clip.max) << endl;
+}
@@ -0,0 +1,44 @@
+#ifndef QUADRIC_HPP
+#define QUADRIC_HPP
+
+#include "geometry.hpp"
+#include "geometric_shape.hpp"
+#include <array>
+
+// General quadric surface
+//
+//   A x^2 + B y^2 + C z^2 + D xy + E xz + F yz + G x + H y + I z + J = 0
+//
+// clipped to an axis aligned box, which keeps it bounded for the
+// acceleration structures (paraboloids, hyperboloids, elliptic cylinders...).
+// The normal is the gradient, so it points to the side where the left hand
+// side is positive.
+class Quadric : public GeometricShape {
+    public:
+        std::array<double, 10> coefficients; // A to J
+        BoundingBox clip;
+
+        Quadric(const std::array<double, 10>& coefficients_, const BoundingBox& clip_);
+
+        std::vector<Point> intersections(const Ray& ray) const override;
+
+        // Closest intersection in [tMin, tMax]
+        bool closestHit(const Ray& ray, double tMin, double tMax, HitRecord& hit) const override;
+
+        // Lane by lane version over a ray packet
+        void intersectPacket(RayPacket& packet, uint32_t mask, double tMin, int shapeIndex) const override;
+
+        BoundingBox bounds() const override { return clip; }
+
+        void print() const override;
+
+    private:
+        // The two roots along the ray that lie inside the clip box, infinity
+        // for the missing ones
+        void roots(const double o[3], const double d[3], double t[2]) const;
+
+        // Unit gradient at p
+        void gradient(const double p[3], double n[3]) const;
+};
+
+#endif // QUADRIC_HPP
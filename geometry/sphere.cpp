@@ -1,5 +1,6 @@
 #include "sphere.hpp"
 #include "../ray.hpp"
+#include "../ray_packet.hpp"
 #include <stdexcept>
 #include <cmath>
 #include <iostream>
@@ -43,6 +44,78 @@ std::vector<Point> Sphere::intersections(const Ray& ray) const {
     }
 }
 
+bool Sphere::closestHit(const Ray& ray, double tMin, double tMax, HitRecord& hit) const {
+    Direction oc = ray.o - center;
+    double a = ray.d.dot(ray.d);
+    double halfB = oc.dot(ray.d);
+    double c = oc.dot(oc) - radius * radius;
+    double discriminant = halfB * halfB - a * c;
+    if (discriminant < 0) {
+        return false;
+    }
+
+    // Try the nearest root first, then the farthest one
+    double sqrtDisc = sqrt(discriminant);
+    double t = (-halfB - sqrtDisc) / a;
+    if (t < tMin || t > tMax) {
+        t = (-halfB + sqrtDisc) / a;
+        if (t < tMin || t > tMax) {
+            return false;
+        }
+    }
+
+    hit.t = t;
+    hit.point = ray.o + ray.d * t;
+    hit.normal = (hit.point - center) / radius;
+    return true;
+}
+
+bool Sphere::occludes(const Ray& ray, double tMin, double tMax) const {
+    Direction oc = ray.o - center;
+    double a = ray.d.dot(ray.d);
+    double halfB = oc.dot(ray.d);
+    double c = oc.dot(oc) - radius * radius;
+    double discriminant = halfB * halfB - a * c;
+    if (discriminant < 0) {
+        return false;
+    }
+
+    double sqrtDisc = sqrt(discriminant);
+    double t0 = (-halfB - sqrtDisc) / a, t1 = (-halfB + sqrtDisc) / a;
+    return (t0 >= tMin && t0 <= tMax) || (t1 >= tMin && t1 <= tMax);
+}
+
+void Sphere::intersectPacket(RayPacket& packet, uint32_t mask, double tMin, int shapeIndex) const {
+    const double cx = center.x(), cy = center.y(), cz = center.z();
+    const double r2 = radius * radius, invRadius = 1.0 / radius;
+
+    for (int i = 0; i < RayPacket::SIZE; ++i) {
+        double ocx = packet.ox[i] - cx, ocy = packet.oy[i] - cy, ocz = packet.oz[i] - cz;
+        double dx = packet.dx[i], dy = packet.dy[i], dz = packet.dz[i];
+        double a = dx * dx + dy * dy + dz * dz;
+        double halfB = ocx * dx + ocy * dy + ocz * dz;
+        double c = ocx * ocx + ocy * ocy + ocz * ocz - r2;
+        double discriminant = halfB * halfB - a * c;
+
+        double sqrtDisc = sqrt(discriminant > 0 ? discriminant : 0.0);
+        double t0 = (-halfB - sqrtDisc) / a;
+        double t1 = (-halfB + sqrtDisc) / a;
+        double t = t0 >= tMin ? t0 : t1;
+
+        bool valid = ((mask >> i) & 1u) && discriminant >= 0 && t >= tMin && t <= packet.t[i];
+        packet.t[i] = valid ? t : packet.t[i];
+        packet.nx[i] = valid ? (ocx + t * dx) * invRadius : packet.nx[i];
+        packet.ny[i] = valid ? (ocy + t * dy) * invRadius : packet.ny[i];
+        packet.nz[i] = valid ? (ocz + t * dz) * invRadius : packet.nz[i];
+        packet.shape[i] = valid ? shapeIndex : packet.shape[i];
+    }
+}
+
+BoundingBox Sphere::bounds() const {
+    Vector3d r = Vector3d::Constant(radius);
+    return BoundingBox(center.coords - r, center.coords + r);
+}
+
 void Sphere::print() const {
     cout << "Sphere: center=" << center << ", radius=" << radius << endl;
 }
\ No newline at end of file
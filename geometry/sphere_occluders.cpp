@@ -0,0 +1,21 @@
+#include "sphere_occluders.hpp"
+#include "../ray.hpp"
+
+using namespace std;
+
+SphereOccluders::SphereOccluders(vector<Sphere> spheres_) : spheres(move(spheres_)) {
+    vector<BoundingBox> bounds;
+    bounds.reserve(spheres.size());
+    for (const Sphere& sphere : spheres) {
+        bounds.push_back(sphere.bounds());
+    }
+    bvh.build(bounds);
+}
+
+bool SphereOccluders::clear(const Point& a, const Point& b) const {
+    // The direction is not normalised, so t = 1 is b
+    Ray ray(a, b - a);
+    return !bvh.traverseAny(ray, SEGMENT_EPSILON, 1.0 - SEGMENT_EPSILON, [&](int prim) {
+        return spheres[prim].occludes(ray, SEGMENT_EPSILON, 1.0 - SEGMENT_EPSILON);
+    });
+}
@@ -0,0 +1,29 @@
+#ifndef SPHERE_OCCLUDERS_HPP
+#define SPHERE_OCCLUDERS_HPP
+
+#include "sphere.hpp"
+#include "bvh.hpp"
+#include <vector>
+
+// Set of spheres (the planets of a system) under a BVH, for line of sight
+// queries between points. Each query only tests the spheres whose boxes the
+// segment crosses instead of every sphere.
+class SphereOccluders {
+    public:
+        // Fraction of the segment ignored at each end, so points lying on a
+        // sphere surface (stations) are not blocked by that surface itself
+        static constexpr double SEGMENT_EPSILON = 1e-9;
+
+        std::vector<Sphere> spheres;
+
+        SphereOccluders() = default;
+        explicit SphereOccluders(std::vector<Sphere> spheres_);
+
+        // True if no sphere cuts the segment from a to b (ends excluded)
+        bool clear(const Point& a, const Point& b) const;
+
+    private:
+        BVH bvh;
+};
+
+#endif // SPHERE_OCCLUDERS_HPP
@@ -0,0 +1,120 @@
+#include "station_frames.hpp"
+#include <algorithm>
+
+using namespace std;
+
+namespace {
+
+// Receive stations per tile of countSafeConnections: the six arrays it reads
+// take 6 * 8 * 2048 bytes = 96 KB, which stays in L2
+const int FRAME_TILE = 2048;
+
+} // namespace
+
+void StationFrames::add(const Point& position, const Direction& i, const Direction& j, const Direction& k) {
+    px.push_back(position.x()); py.push_back(position.y()); pz.push_back(position.z());
+    ix.push_back(i.x()); iy.push_back(i.y()); iz.push_back(i.z());
+    jx.push_back(j.x()); jy.push_back(j.y()); jz.push_back(j.z());
+    kx.push_back(k.x()); ky.push_back(k.y()); kz.push_back(k.z());
+}
+
+void ConnectionLanes::resize(size_t count) {
+    for (int axis = 0; axis < 3; ++axis) {
+        launch[axis].resize(count);
+        receive[axis].resize(count);
+    }
+    safeLaunch.resize(count);
+    safeReceive.resize(count);
+}
+
+void evaluateRow(const StationFrames& f, int launch, int begin, int end, ConnectionLanes& out, size_t offset) {
+    // Frame of the launch station, the same for the whole row
+    const double ax = f.px[launch], ay = f.py[launch], az = f.pz[launch];
+    const double aix = f.ix[launch], aiy = f.iy[launch], aiz = f.iz[launch];
+    const double ajx = f.jx[launch], ajy = f.jy[launch], ajz = f.jz[launch];
+    const double akx = f.kx[launch], aky = f.ky[launch], akz = f.kz[launch];
+
+    const double* __restrict px = f.px.data();
+    const double* __restrict py = f.py.data();
+    const double* __restrict pz = f.pz.data();
+    const double* __restrict ix = f.ix.data();
+    const double* __restrict iy = f.iy.data();
+    const double* __restrict iz = f.iz.data();
+    const double* __restrict jx = f.jx.data();
+    const double* __restrict jy = f.jy.data();
+    const double* __restrict jz = f.jz.data();
+    const double* __restrict kx = f.kx.data();
+    const double* __restrict ky = f.ky.data();
+    const double* __restrict kz = f.kz.data();
+
+    double* __restrict li = out.launch[0].data() + offset;
+    double* __restrict lj = out.launch[1].data() + offset;
+    double* __restrict lk = out.launch[2].data() + offset;
+    double* __restrict ri = out.receive[0].data() + offset;
+    double* __restrict rj = out.receive[1].data() + offset;
+    double* __restrict rk = out.receive[2].data() + offset;
+    uint8_t* __restrict safeLaunch = out.safeLaunch.data() + offset;
+    uint8_t* __restrict safeReceive = out.safeReceive.data() + offset;
+
+    const int count = end - begin;
+    for (int n = 0; n < count; ++n) {
+        const int b = begin + n;
+        // Global direction from the launch to the receive station
+        const double dx = px[b] - ax, dy = py[b] - ay, dz = pz[b] - az;
+
+        li[n] = aix * dx + aiy * dy + aiz * dz;
+        lj[n] = ajx * dx + ajy * dy + ajz * dz;
+        lk[n] = akx * dx + aky * dy + akz * dz;
+
+        ri[n] = ix[b] * dx + iy[b] * dy + iz[b] * dz;
+        rj[n] = jx[b] * dx + jy[b] * dy + jz[b] * dz;
+        rk[n] = kx[b] * dx + ky[b] * dy + kz[b] * dz;
+
+        safeLaunch[n] = lk[n] > 0;  // Leaves above the horizon of the launch station
+        safeReceive[n] = rk[n] < 0; // Arrives from above the horizon of the receive station
+    }
+}
+
+void evaluatePairs(const StationFrames& f, const pair<int, int>* pairs, size_t count,
+                   ConnectionLanes& out, size_t offset) {
+    // Pairs in arbitrary order cannot be read with unit stride; evaluating
+    // them as rows of one keeps a single code path for the arithmetic
+    for (size_t n = 0; n < count; ++n) {
+        evaluateRow(f, pairs[n].first, pairs[n].second, pairs[n].second + 1, out, offset + n);
+    }
+}
+
+SafetyCounts countSafeConnections(const StationFrames& f, int launchBegin, int launchEnd) {
+    // The flags only depend on the k axes, so the sweep reads positions and k
+    const double* __restrict px = f.px.data();
+    const double* __restrict py = f.py.data();
+    const double* __restrict pz = f.pz.data();
+    const double* __restrict kx = f.kx.data();
+    const double* __restrict ky = f.ky.data();
+    const double* __restrict kz = f.kz.data();
+
+    SafetyCounts counts;
+    const int n = f.size();
+    for (int tile = 0; tile < n; tile += FRAME_TILE) {
+        const int tileEnd = min(n, tile + FRAME_TILE);
+        for (int a = launchBegin; a < launchEnd; ++a) {
+            const double ax = px[a], ay = py[a], az = pz[a];
+            const double akx = kx[a], aky = ky[a], akz = kz[a];
+
+            // The station against itself gives a null direction, never safe
+            int64_t safeLaunch = 0, safeReceive = 0, safe = 0;
+            for (int b = tile; b < tileEnd; ++b) {
+                const double dx = px[b] - ax, dy = py[b] - ay, dz = pz[b] - az;
+                const bool launchOk = akx * dx + aky * dy + akz * dz > 0;
+                const bool receiveOk = kx[b] * dx + ky[b] * dy + kz[b] * dz < 0;
+                safeLaunch += launchOk;
+                safeReceive += receiveOk;
+                safe += launchOk & receiveOk;
+            }
+            counts.safeLaunch += safeLaunch;
+            counts.safeReceive += safeReceive;
+            counts.safe += safe;
+        }
+    }
+    return counts;
+}
@@ -0,0 +1,60 @@
+#ifndef STATION_FRAMES_HPP
+#define STATION_FRAMES_HPP
+
+#include "geometry.hpp"
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Local frames (position and unit axes i, j, k) of every station of a
+// catalogue in structure of arrays form. Connection sweeps read them with
+// unit stride, so the kernels below evaluate several pairs per instruction.
+struct StationFrames {
+    std::vector<double> px, py, pz;
+    std::vector<double> ix, iy, iz;
+    std::vector<double> jx, jy, jz;
+    std::vector<double> kx, ky, kz;
+
+    // The axes must already be normalised
+    void add(const Point& position, const Direction& i, const Direction& j, const Direction& k);
+
+    int size() const { return static_cast<int>(px.size()); }
+};
+
+// Results of evaluated connections, one lane per connection
+struct ConnectionLanes {
+    std::vector<double> launch[3];  // Direction in the local frame of the launch station
+    std::vector<double> receive[3]; // Direction in the local frame of the receive station
+    std::vector<uint8_t> safeLaunch;
+    std::vector<uint8_t> safeReceive;
+
+    void resize(size_t count);
+    size_t size() const { return safeLaunch.size(); }
+};
+
+struct SafetyCounts {
+    uint64_t safeLaunch = 0;
+    uint64_t safeReceive = 0;
+    uint64_t safe = 0; // Both
+
+    void merge(const SafetyCounts& other) {
+        safeLaunch += other.safeLaunch;
+        safeReceive += other.safeReceive;
+        safe += other.safe;
+    }
+};
+
+// Connections from station launch to stations [begin, end), written to
+// out lanes [offset, offset + end - begin)
+void evaluateRow(const StationFrames& frames, int launch, int begin, int end, ConnectionLanes& out, size_t offset);
+
+// Arbitrary (launch, receive) pairs, written to out lanes [offset, offset + count)
+void evaluatePairs(const StationFrames& frames, const std::pair<int, int>* pairs, size_t count,
+                   ConnectionLanes& out, size_t offset);
+
+// Counts the safe connections from stations [launchBegin, launchEnd) to
+// every other station without storing them. The sweep is tiled so a block
+// of receive frames stays in cache while the launch stations go through it.
+SafetyCounts countSafeConnections(const StationFrames& frames, int launchBegin, int launchEnd);
+
+#endif // STATION_FRAMES_HPP
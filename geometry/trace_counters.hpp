@@ -0,0 +1,60 @@
+#ifndef TRACE_COUNTERS_HPP
+#define TRACE_COUNTERS_HPP
+
+#include <cstdint>
+
+// Work done by the ray queries of one thread: BVH nodes visited and
+// primitive tests and hits by PrimitiveStore::Kind (packet tests count one
+// per lane; their hits are not counted). Only built with INFGR_COUNTERS,
+// which makes INFGR_COUNT keep its statement; otherwise the counters stay at
+// zero and the queries pay nothing.
+// Every thread counts into its own thread_local copy, so the hot path never
+// writes shared memory; whoever wants the counts of a piece of work reads
+// local() before and after it.
+struct TraceCounters {
+    static const int KINDS = 4;
+
+    uint64_t nodesVisited = 0;
+    uint64_t primitiveTests[KINDS] = {};
+    uint64_t primitiveHits[KINDS] = {};
+
+    static TraceCounters& local() {
+        thread_local TraceCounters counters;
+        return counters;
+    }
+
+    uint64_t totalTests() const {
+        uint64_t total = 0;
+        for (int kind = 0; kind < KINDS; ++kind) {
+            total += primitiveTests[kind];
+        }
+        return total;
+    }
+
+    void merge(const TraceCounters& other) {
+        nodesVisited += other.nodesVisited;
+        for (int kind = 0; kind < KINDS; ++kind) {
+            primitiveTests[kind] += other.primitiveTests[kind];
+            primitiveHits[kind] += other.primitiveHits[kind];
+        }
+    }
+
+    // Counts since an earlier reading of the same counters
+    TraceCounters since(const TraceCounters& before) const {
+        TraceCounters delta;
+        delta.nodesVisited = nodesVisited - before.nodesVisited;
+        for (int kind = 0; kind < KINDS; ++kind) {
+            delta.primitiveTests[kind] = primitiveTests[kind] - before.primitiveTests[kind];
+            delta.primitiveHits[kind] = primitiveHits[kind] - before.primitiveHits[kind];
+        }
+        return delta;
+    }
+};
+
+#ifdef INFGR_COUNTERS
+#define INFGR_COUNT(statement) statement
+#else
+#define INFGR_COUNT(statement)
+#endif
+
+#endif // TRACE_COUNTERS_HPP
@@ -1,5 +1,6 @@
 #include "triangle.hpp"
 #include "../ray.hpp"
+#include "../ray_packet.hpp"
 #include <iostream>
 #include <cmath>
 
@@ -40,6 +41,77 @@ std::vector<Point> Triangle::intersections(const Ray& ray) const {
     return intersectionPoints;
 }
 
+bool Triangle::closestHit(const Ray& ray, double tMin, double tMax, HitRecord& hit) const {
+    double denom = ray.d.dot(normal);
+    if (fabs(denom) < 1e-6) {
+        return false; // Ray is parallel to triangle plane
+    }
+
+    double t = (v0 - ray.o).dot(normal) / denom;
+    if (t < tMin || t > tMax) {
+        return false;
+    }
+
+    Point intersectionPoint = ray.o + ray.d * t;
+    if (!isPointInside(intersectionPoint)) {
+        return false;
+    }
+
+    hit.t = t;
+    hit.point = intersectionPoint;
+    hit.normal = normal;
+    return true;
+}
+
+bool Triangle::occludes(const Ray& ray, double tMin, double tMax) const {
+    double denom = ray.d.dot(normal);
+    if (fabs(denom) < 1e-6) {
+        return false;
+    }
+    double t = (v0 - ray.o).dot(normal) / denom;
+    return t >= tMin && t <= tMax && isPointInside(ray.o + ray.d * t);
+}
+
+void Triangle::intersectPacket(RayPacket& packet, uint32_t mask, double tMin, int shapeIndex) const {
+    // Moller-Trumbore, which needs no division before the early outs
+    const Vector3d e1 = v1.coords - v0.coords;
+    const Vector3d e2 = v2.coords - v0.coords;
+    const double nx = normal.x(), ny = normal.y(), nz = normal.z();
+
+    for (int i = 0; i < RayPacket::SIZE; ++i) {
+        double dx = packet.dx[i], dy = packet.dy[i], dz = packet.dz[i];
+        double px = dy * e2.z() - dz * e2.y();
+        double py = dz * e2.x() - dx * e2.z();
+        double pz = dx * e2.y() - dy * e2.x();
+        double det = e1.x() * px + e1.y() * py + e1.z() * pz;
+        double invDet = 1.0 / (fabs(det) > 1e-12 ? det : 1.0);
+
+        double tx = packet.ox[i] - v0.x(), ty = packet.oy[i] - v0.y(), tz = packet.oz[i] - v0.z();
+        double u = (tx * px + ty * py + tz * pz) * invDet;
+        double qx = ty * e1.z() - tz * e1.y();
+        double qy = tz * e1.x() - tx * e1.z();
+        double qz = tx * e1.y() - ty * e1.x();
+        double v = (dx * qx + dy * qy + dz * qz) * invDet;
+        double t = (e2.x() * qx + e2.y() * qy + e2.z() * qz) * invDet;
+
+        bool valid = ((mask >> i) & 1u) && fabs(det) > 1e-12 && u >= 0 && v >= 0 && u + v <= 1
+                     && t >= tMin && t <= packet.t[i];
+        packet.t[i] = valid ? t : packet.t[i];
+        packet.nx[i] = valid ? nx : packet.nx[i];
+        packet.ny[i] = valid ? ny : packet.ny[i];
+        packet.nz[i] = valid ? nz : packet.nz[i];
+        packet.shape[i] = valid ? shapeIndex : packet.shape[i];
+    }
+}
+
+BoundingBox Triangle::bounds() const {
+    BoundingBox box;
+    box.expand(v0.coords);
+    box.expand(v1.coords);
+    box.expand(v2.coords);
+    return box;
+}
+
 bool Triangle::isPointInside(const Point& p) const {
     // Using barycentric coordinates method
     Direction v0v1 = v1 - v0;
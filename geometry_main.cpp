@@ -1,226 +1,508 @@
-#include "geometry/geometry.hpp"
+#include "geometry/planet.hpp"
+#include "geometry/sphere_occluders.hpp"
+#include "geometry/station_frames.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
 
 using namespace std;
 
-// Incluir las clases Planet, Station y Connection aquí o en un archivo separado
-// Por ahora las incluyo directamente
+// ---------------------------------------------------------------------------
+// Batch mode: catalogues of planets and stations read from a file
+//
+//   planet <nombre> <centro x y z> <eje dx dy dz> <ciudad x y z> [rotation <rad por unidad de tiempo>]
+//   station <nombre> <planeta> <inclinacion> <azimut>      (radianes)
+//   connection <estacion de lanzamiento> <estacion receptora>
+//
+// '#' starts a comment. Without connection statements (or with --all-pairs)
+// every ordered pair of different stations is evaluated.
+// ---------------------------------------------------------------------------
 
-class Planet {
-    public:
-        // Key points
-        Point center;
-        Point city_ref;
-        // Planet radius
-        double radius;
-        // Main directions
-        Direction axis; // from south to north pole (k)
-        Direction azimut0; // in the same plane as equatorial and perpendicular to axis (i)
-        Direction equatorial; // perpendicular to axis and azimut0 (j)
-        // Transformation matrices from world coordinates to planet coordinates and vice versa
-        Matrix4d transformation_matrix;
-        Matrix4d inverse_transformation_matrix;
-
-        Planet(const Point& center_, const Direction& axis_, const Point& city_ref_)
-            : center(center_), axis(axis_), city_ref(city_ref_) 
-        {
-            // Check radius consistency
-            double radius_from_axis = axis.norm() / 2.0;
-            double radius_from_city = (city_ref - center).norm();
-
-            if (abs(radius_from_axis - radius_from_city) > 1e-6) {
-                throw invalid_argument("Radio inconsistente. Radio del eje: " 
-                    + to_string(radius_from_axis) 
-                    + ", Radio desde ciudad: " 
-                    + to_string(radius_from_city));
+struct Catalogue {
+    // Contiguous storage, everything else refers to it by index
+    vector<Planet> planets;
+    vector<Station> stations;
+    vector<string> planet_names;
+    vector<string> station_names;
+    vector<pair<int, int>> connections; // (launch, receive) station indices
+    StationFrames frames;               // Frames of the stations, same order
+    SphereOccluders occluders;          // Planet spheres, only built for line of sight checks
+};
+
+struct BatchOptions {
+    string output;          // .bin for binary, CSV otherwise (stdout if empty)
+    unsigned threads = 0;   // 0: one per hardware thread
+    bool allPairs = false;  // Every ordered pair even if the catalogue lists connections
+    bool summary = false;   // Only count, write nothing
+    bool occlusion = false; // Check the line of sight against every planet
+    bool windows = false;   // Safe time windows over [windowStart, windowEnd] instead
+    double windowStart = 0.0, windowEnd = 0.0;
+};
+
+// Safety counts plus the line of sight ones (occlusion mode)
+struct ConnectionCounts {
+    SafetyCounts safety;
+    uint64_t clear = 0;  // Segment not blocked by any planet
+    uint64_t usable = 0; // Safe and clear
+
+    void merge(const ConnectionCounts& other) {
+        safety.merge(other.safety);
+        clear += other.clear;
+        usable += other.usable;
+    }
+};
+
+// One evaluated connection, 64 bytes, also the record of the binary output
+struct ConnectionRecord {
+    int32_t launch;
+    int32_t receive;
+    double launch_local[3];
+    double receive_local[3];
+    uint8_t safe_launch;
+    uint8_t safe_receive;
+    uint8_t line_of_sight; // 1 clear, 0 blocked by a planet, LINE_OF_SIGHT_UNKNOWN if not checked
+    uint8_t padding[5];
+};
+static_assert(sizeof(ConnectionRecord) == 64, "ConnectionRecord must stay 64 bytes");
+
+const char CONNECTIONS_MAGIC[8] = { 'I', 'N', 'F', 'G', 'R', 'C', 'O', 'N' };
+const uint32_t CONNECTIONS_VERSION = 2;
+const uint8_t LINE_OF_SIGHT_UNKNOWN = 0xFF;
+
+// Connections evaluated before their results are written out, which bounds
+// the memory used by all-pairs runs
+const size_t CONNECTION_BLOCK = 1 << 16;
+
+// Largest -t accepted, far above any real machine
+const int MAX_THREADS = 1024;
+
+Catalogue readCatalogue(const string& filename) {
+    ifstream in(filename);
+    if (!in) {
+        throw runtime_error("No se puede abrir el catalogo: " + filename);
+    }
+
+    Catalogue catalogue;
+    map<string, int> planet_index, station_index;
+    string text;
+    int line = 0;
+    while (getline(in, text)) {
+        ++line;
+        size_t comment = text.find('#');
+        if (comment != string::npos) {
+            text.erase(comment);
+        }
+        istringstream tokens(text);
+        string keyword;
+        if (!(tokens >> keyword)) {
+            continue;
+        }
+
+        auto fail = [&](const string& message) {
+            throw runtime_error(filename + ":" + to_string(line) + ": " + message);
+        };
+        auto lookup = [&](const map<string, int>& names, const string& name, const string& what) {
+            auto it = names.find(name);
+            if (it == names.end()) {
+                fail(what + " desconocido '" + name + "'");
             }
+            return it->second;
+        };
 
-            radius = radius_from_axis;
-            // Calculate the direction of center->city
-            Direction center_to_city = (city_ref - center);
-            // Get the perpendicular vector of the axis and the center->city
-            Direction equatorial = axis.cross(center_to_city);
-            // Calculate the perpendicular projection of the equatorial and the axis
-            azimut0 = equatorial.cross(axis);
-
-            // Normalize directions
-            Direction equatorial_norm = equatorial.normalized();
-            Direction azimut0_norm = azimut0.normalized();
-            Direction axis_norm = axis.normalized();
-
-            // Build transformation matrix
-            transformation_matrix(0,0) = azimut0_norm.x();
-            transformation_matrix(0,1) = equatorial_norm.x();
-            transformation_matrix(0,2) = axis_norm.x();
-            transformation_matrix(0,3) = center.x();
-
-            transformation_matrix(1,0) = azimut0_norm.y();
-            transformation_matrix(1,1) = equatorial_norm.y();
-            transformation_matrix(1,2) = axis_norm.y();
-            transformation_matrix(1,3) = center.y();
-
-            transformation_matrix(2,0) = azimut0_norm.z();
-            transformation_matrix(2,1) = equatorial_norm.z();
-            transformation_matrix(2,2) = axis_norm.z();
-            transformation_matrix(2,3) = center.z();
-
-            transformation_matrix(3,0) = 0;
-            transformation_matrix(3,1) = 0;
-            transformation_matrix(3,2) = 0;
-            transformation_matrix(3,3) = 1;
-
-            inverse_transformation_matrix = transformation_matrix.inverse();
+        try {
+            string name;
+            if (keyword == "planet") {
+                double cx, cy, cz, ax, ay, az, rx, ry, rz;
+                if (!(tokens >> name >> cx >> cy >> cz >> ax >> ay >> az >> rx >> ry >> rz)) {
+                    fail("se esperaba 'planet <nombre> <centro> <eje> <ciudad>'");
+                }
+                if (planet_index.count(name)) {
+                    fail("planeta repetido '" + name + "'");
+                }
+                double rate = 0.0;
+                string option;
+                if (tokens >> option) {
+                    if (option != "rotation" || !(tokens >> rate)) {
+                        fail("se esperaba 'rotation <velocidad angular>' tras la ciudad");
+                    }
+                }
+                catalogue.planets.emplace_back(Point(cx, cy, cz), Direction(ax, ay, az), Point(rx, ry, rz), rate);
+                planet_index[name] = static_cast<int>(catalogue.planet_names.size());
+                catalogue.planet_names.push_back(name);
+            } else if (keyword == "station") {
+                string planet;
+                double inclination, azimut;
+                if (!(tokens >> name >> planet >> inclination >> azimut)) {
+                    fail("se esperaba 'station <nombre> <planeta> <inclinacion> <azimut>'");
+                }
+                if (station_index.count(name)) {
+                    fail("estacion repetida '" + name + "'");
+                }
+                int p = lookup(planet_index, planet, "planeta");
+                catalogue.stations.emplace_back(catalogue.planets[p], inclination, azimut, p);
+                const Station& station = catalogue.stations.back();
+                catalogue.frames.add(station.position, Direction(station.rotation.col(0)),
+                                     Direction(station.rotation.col(1)), Direction(station.rotation.col(2)));
+                station_index[name] = static_cast<int>(catalogue.station_names.size());
+                catalogue.station_names.push_back(name);
+            } else if (keyword == "connection") {
+                string launch, receive;
+                if (!(tokens >> launch >> receive)) {
+                    fail("se esperaba 'connection <lanzamiento> <receptora>'");
+                }
+                catalogue.connections.emplace_back(lookup(station_index, launch, "estacion"),
+                                                   lookup(station_index, receive, "estacion"));
+            } else {
+                fail("sentencia desconocida '" + keyword + "'");
+            }
+            if (tokens >> name) {
+                fail("argumentos de sobra al final de la linea");
+            }
+        } catch (const invalid_argument& e) {
+            // Inconsistent planets
+            fail(e.what());
         }
-};
+    }
+    return catalogue;
+}
+
+void packRecord(const ConnectionLanes& lanes, size_t lane, int launch, int receive, ConnectionRecord& record) {
+    record.launch = launch;
+    record.receive = receive;
+    for (int axis = 0; axis < 3; ++axis) {
+        record.launch_local[axis] = lanes.launch[axis][lane];
+        record.receive_local[axis] = lanes.receive[axis][lane];
+    }
+    record.safe_launch = lanes.safeLaunch[lane];
+    record.safe_receive = lanes.safeReceive[lane];
+    record.line_of_sight = LINE_OF_SIGHT_UNKNOWN;
+    memset(record.padding, 0, sizeof(record.padding));
+}
+
+// Fills in the line of sight of the record when the occluders are built
+void checkLineOfSight(const Catalogue& catalogue, bool occlusion, ConnectionRecord& record) {
+    if (occlusion) {
+        record.line_of_sight = catalogue.occluders.clear(catalogue.stations[record.launch].position,
+                                                         catalogue.stations[record.receive].position);
+    }
+}
+
+void countRecord(const ConnectionRecord& record, ConnectionCounts& counts) {
+    const bool safe = record.safe_launch & record.safe_receive;
+    counts.safety.safeLaunch += record.safe_launch;
+    counts.safety.safeReceive += record.safe_receive;
+    counts.safety.safe += safe;
+    counts.clear += record.line_of_sight == 1;
+    counts.usable += safe && record.line_of_sight == 1;
+}
 
-class Station {
+// Writes the records as CSV (station names) or binary (.bin: header, then
+// fixed 64 byte records; the count is patched in when the run ends)
+class ConnectionWriter {
     public:
-        double inclination;
-        double azimut;
-        Planet planet;
-        Point position;
-        Direction i, j ,k;
-        // Transformation matrix from planet coordinates to station coordinates and vice versa
-        Matrix4d transformation_matrix;
-        Matrix4d inverse_transformation_matrix;
-
-        Station(const Planet& planet_, double inclination_, double azimut_)
-            : planet(planet_), inclination(inclination_), azimut(azimut_), position(0, 0, 0) 
+        ConnectionWriter(const string& filename, const Catalogue& catalogue_, bool occlusion_)
+            : catalogue(catalogue_), binary(endsWith(filename, ".bin")), occlusion(occlusion_), count(0)
         {
-            position = Point(
-                planet.center.x() + planet.radius * sin(inclination) * cos(azimut),
-                planet.center.y() + planet.radius * sin(inclination) * sin(azimut),
-                planet.center.z() + planet.radius * cos(inclination)
-            );
-
-            cout << "Posicion de la estacion: (" 
-                 << position.x() << ", "
-                 << position.y() << ", "
-                 << position.z() << ")" << endl;
-
-            // k: Normal to surface
-            k = (position - planet.center);
-            
-            // i: Tangent to longitude (azimut direction) 
-            i = planet.axis.cross(k);
-            
-            // j: Tangent to latitude (inclination direction)
-            j = i.cross(k);
-
-            Direction i_norm = i.normalized();
-            Direction j_norm = j.normalized();
-            Direction k_norm = k.normalized();
-
-            transformation_matrix(0,0) = i_norm.x();
-            transformation_matrix(0,1) = j_norm.x();
-            transformation_matrix(0,2) = k_norm.x();
-            transformation_matrix(0,3) = position.x();
-
-            transformation_matrix(1,0) = i_norm.y();
-            transformation_matrix(1,1) = j_norm.y();
-            transformation_matrix(1,2) = k_norm.y();
-            transformation_matrix(1,3) = position.y();
-
-            transformation_matrix(2,0) = i_norm.z();
-            transformation_matrix(2,1) = j_norm.z();
-            transformation_matrix(2,2) = k_norm.z();
-            transformation_matrix(2,3) = position.z();
-
-            transformation_matrix(3,0) = 0;
-            transformation_matrix(3,1) = 0;
-            transformation_matrix(3,2) = 0;
-            transformation_matrix(3,3) = 1;
-
-            inverse_transformation_matrix = transformation_matrix.inverse();
+            if (filename.empty() || filename == "-") {
+                out = &cout;
+            } else {
+                file.open(filename, binary ? ios::binary : ios::out);
+                if (!file) {
+                    throw runtime_error("No se puede escribir el fichero: " + filename);
+                }
+                out = &file;
+            }
+
+            if (binary) {
+                uint64_t placeholder = 0;
+                out->write(CONNECTIONS_MAGIC, sizeof(CONNECTIONS_MAGIC));
+                out->write(reinterpret_cast<const char*>(&CONNECTIONS_VERSION), sizeof(CONNECTIONS_VERSION));
+                out->write(reinterpret_cast<const char*>(&placeholder), sizeof(placeholder));
+            } else {
+                *out << "lanzamiento,receptora,salida_i,salida_j,salida_k,entrada_i,entrada_j,entrada_k,"
+                        "lanzamiento_seguro,recepcion_segura" << (occlusion ? ",linea_de_vista\n" : "\n");
+                out->precision(17);
+            }
+        }
+
+        void write(const vector<ConnectionRecord>& records) {
+            if (binary) {
+                out->write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(ConnectionRecord));
+            } else {
+                for (const auto& r : records) {
+                    *out << catalogue.station_names[r.launch] << ',' << catalogue.station_names[r.receive] << ','
+                         << r.launch_local[0] << ',' << r.launch_local[1] << ',' << r.launch_local[2] << ','
+                         << r.receive_local[0] << ',' << r.receive_local[1] << ',' << r.receive_local[2] << ','
+                         << int(r.safe_launch) << ',' << int(r.safe_receive);
+                    if (occlusion) {
+                        *out << ',' << int(r.line_of_sight);
+                    }
+                    *out << '\n';
+                }
+            }
+            count += records.size();
         }
 
-        // Convert direction from local coordinates (i,j,k) to global UCS coordinates
-        Direction localToGlobal(const Direction& localDir) const {
-            Eigen::Matrix3d rotationMatrix;
-            rotationMatrix << inverse_transformation_matrix(0,0), inverse_transformation_matrix(0,1), inverse_transformation_matrix(0,2),
-                            inverse_transformation_matrix(1,0), inverse_transformation_matrix(1,1), inverse_transformation_matrix(1,2),
-                            inverse_transformation_matrix(2,0), inverse_transformation_matrix(2,1), inverse_transformation_matrix(2,2);
-            
-            Vector3d localVec(localDir.x(), localDir.y(), localDir.z());
-            Vector3d globalVec = rotationMatrix * localVec;
-            
-            return Direction(globalVec);
+        void finish() {
+            if (binary && out == &file) {
+                file.seekp(sizeof(CONNECTIONS_MAGIC) + sizeof(CONNECTIONS_VERSION));
+                file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+            }
+            out->flush();
+            if (!*out) {
+                throw runtime_error("Error escribiendo las conexiones");
+            }
         }
 
-        // Convert direction from global UCS coordinates to local coordinates (i,j,k)
-        Direction globalToLocal(const Direction& globalDir) const {
-            Eigen::Matrix3d rotationMatrix;
-            rotationMatrix << transformation_matrix(0,0), transformation_matrix(0,1), transformation_matrix(0,2),
-                            transformation_matrix(1,0), transformation_matrix(1,1), transformation_matrix(1,2),
-                            transformation_matrix(2,0), transformation_matrix(2,1), transformation_matrix(2,2);
-            
-            Vector3d globalVec(globalDir.x(), globalDir.y(), globalDir.z());
-            Vector3d localVec = rotationMatrix.transpose() * globalVec;
-            
-            return Direction(localVec);
+    private:
+        const Catalogue& catalogue;
+        bool binary;
+        bool occlusion;
+        uint64_t count;
+        ofstream file;
+        ostream* out;
+
+        static bool endsWith(const string& text, const string& suffix) {
+            return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
         }
 };
 
-class Connection {
-    public:
-        Station* launch_station;
-        Station* receive_station;
-        Direction global_direction;
-        Direction launch_local_direction;
-        Direction receive_local_direction;
-        bool safe_launch;
-        bool safe_receive;
-
-        Connection(Station* launch, Station* receive) 
-            : launch_station(launch), receive_station(receive) {
-            
-            // Calculate global direction from launch to receive
-            global_direction = (receive_station->position - launch_station->position);
-            
-            // Convert to local coordinates for each station
-            launch_local_direction = launch_station->globalToLocal(global_direction);
-            
-            // For receive station, we need the INCOMING direction (opposite)
-            receive_local_direction = receive_station->globalToLocal(global_direction);
-            
-            // Check safety: direction must point away from planet surface (positive k component)
-            safe_launch = launch_local_direction.z() > 0;   // pointing outward from planet
-            safe_receive = receive_local_direction.z() < 0; // incoming from outward
+// Runs work(worker, begin, end) over [0, count), split in equal parts
+// between the calling thread and threads - 1 more
+template <typename Work>
+void parallelFor(size_t count, unsigned threads, Work work) {
+    auto run = [&](unsigned worker) {
+        work(worker, count * worker / threads, count * (worker + 1) / threads);
+    };
+    vector<thread> pool;
+    for (unsigned worker = 1; worker < threads; ++worker) {
+        pool.emplace_back(run, worker);
+    }
+    run(0);
+    for (auto& t : pool) {
+        t.join();
+    }
+}
+
+// Every ordered pair (a, b), a != b, in row order. Blocks of whole rows are
+// evaluated by the row kernel and written before the next block starts.
+ConnectionCounts solveAllPairs(const Catalogue& catalogue, const BatchOptions& options, ConnectionWriter* writer) {
+    const int n = catalogue.frames.size();
+    const unsigned threads = options.threads;
+    vector<ConnectionCounts> counts(threads);
+    if (n < 2) {
+        return ConnectionCounts();
+    }
+
+    if (!writer && !options.occlusion) {
+        // Only the counts: the tiled sweep, without storing any connection
+        parallelFor(n, threads, [&](unsigned worker, size_t begin, size_t end) {
+            counts[worker].safety = countSafeConnections(catalogue.frames, static_cast<int>(begin), static_cast<int>(end));
+        });
+    } else {
+        const size_t row = n - 1;
+        const int rows_per_block = static_cast<int>(max<size_t>(threads, CONNECTION_BLOCK / row));
+        vector<ConnectionLanes> lanes(threads);
+        vector<ConnectionRecord> block;
+        for (int first = 0; first < n; first += rows_per_block) {
+            const int rows = min(rows_per_block, n - first);
+            block.resize(rows * row);
+            parallelFor(rows, threads, [&](unsigned worker, size_t begin, size_t end) {
+                ConnectionLanes& local = lanes[worker];
+                local.resize(n);
+                for (size_t r = begin; r < end; ++r) {
+                    const int a = first + static_cast<int>(r);
+                    evaluateRow(catalogue.frames, a, 0, n, local, 0);
+                    ConnectionRecord* out = &block[r * row];
+                    for (int b = 0; b < n; ++b) {
+                        if (b != a) {
+                            packRecord(local, b, a, b, *out);
+                            checkLineOfSight(catalogue, options.occlusion, *out);
+                            countRecord(*out++, counts[worker]);
+                        }
+                    }
+                }
+            });
+            if (writer) {
+                writer->write(block);
+            }
         }
+    }
+
+    ConnectionCounts total;
+    for (const auto& c : counts) {
+        total.merge(c);
+    }
+    return total;
+}
 
-        void printConnection() const {
-            cout << "=== CONEXIÓN INTERPLANETARIA ===" << endl;
-            cout << "Direccion global UCS: (" 
-                 << global_direction.x() << ", "
-                 << global_direction.y() << ", "
-                 << global_direction.z() << ")" << endl;
-            
-            cout << "\nEstacion de lanzamiento:" << endl;
-            cout << "Coordenadas locales de salida: ("
-                 << launch_local_direction.x() << ", "
-                 << launch_local_direction.y() << ", "
-                 << launch_local_direction.z() << ")" << endl;
-            
-            cout << "Estacion receptora:" << endl;
-            cout << "Coordenadas locales de entrada: ("
-                 << receive_local_direction.x() << ", "
-                 << receive_local_direction.y() << ", "
-                 << receive_local_direction.z() << ")" << endl;
-            
-            // Safety warnings
-            if (!safe_launch) {
-                cout << "\nADVERTENCIA: La catapulta cuantica apunta hacia el interior del planeta de lanzamiento. OPERACION PELIGROSA." << endl;
+// The connections listed in the catalogue, in blocks of CONNECTION_BLOCK
+ConnectionCounts solveListed(const Catalogue& catalogue, const BatchOptions& options, ConnectionWriter* writer) {
+    const auto& pairs = catalogue.connections;
+    const unsigned threads = options.threads;
+    vector<ConnectionCounts> counts(threads);
+    vector<ConnectionLanes> lanes(threads);
+    vector<ConnectionRecord> block;
+    for (size_t first = 0; first < pairs.size(); first += CONNECTION_BLOCK) {
+        const size_t size = min(CONNECTION_BLOCK, pairs.size() - first);
+        block.resize(size);
+        parallelFor(size, threads, [&](unsigned worker, size_t begin, size_t end) {
+            ConnectionLanes& local = lanes[worker];
+            local.resize(end - begin);
+            evaluatePairs(catalogue.frames, &pairs[first + begin], end - begin, local, 0);
+            for (size_t i = begin; i < end; ++i) {
+                const auto& p = pairs[first + i];
+                packRecord(local, i - begin, p.first, p.second, block[i]);
+                checkLineOfSight(catalogue, options.occlusion, block[i]);
+                countRecord(block[i], counts[worker]);
             }
-            if (!safe_receive) {
-                cout << "\nADVERTENCIA: La materia traspasa el interior del planeta receptor. OPERACION PELIGROSA." << endl;
+        });
+        if (writer) {
+            writer->write(block);
+        }
+    }
+
+    ConnectionCounts total;
+    for (const auto& c : counts) {
+        total.merge(c);
+    }
+    return total;
+}
+
+// Safe windows of every connection while the planets rotate, written as
+// CSV rows (one per window) in the order of the connections
+int runWindows(const Catalogue& catalogue, const BatchOptions& options, chrono::steady_clock::time_point start) {
+    vector<pair<int, int>> pairs = catalogue.connections;
+    if (options.allPairs || pairs.empty()) {
+        pairs.clear();
+        for (int a = 0; a < static_cast<int>(catalogue.stations.size()); ++a) {
+            for (int b = 0; b < static_cast<int>(catalogue.stations.size()); ++b) {
+                if (a != b) {
+                    pairs.emplace_back(a, b);
+                }
+            }
+        }
+    }
+
+    ofstream file;
+    ostream* out = &cout;
+    if (!options.output.empty() && options.output != "-") {
+        file.open(options.output);
+        if (!file) {
+            throw runtime_error("No se puede escribir el fichero: " + options.output);
+        }
+        out = &file;
+    }
+    out->precision(17);
+    *out << "lanzamiento,receptora,inicio,fin\n";
+
+    uint64_t total_windows = 0;
+    double total_time = 0.0;
+    vector<vector<TimeWindow>> block;
+    for (size_t first = 0; first < pairs.size(); first += CONNECTION_BLOCK) {
+        const size_t size = min(CONNECTION_BLOCK, pairs.size() - first);
+        block.assign(size, vector<TimeWindow>());
+        parallelFor(size, options.threads, [&](unsigned, size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                const auto& p = pairs[first + i];
+                const Station& launch = catalogue.stations[p.first];
+                const Station& receive = catalogue.stations[p.second];
+                block[i] = connectionWindows(catalogue.planets[launch.planet_index], launch,
+                                             catalogue.planets[receive.planet_index], receive,
+                                             options.windowStart, options.windowEnd);
             }
-            if (safe_launch && safe_receive) {
-                cout << "\nConexion segura establecida." << endl;
+        });
+        for (size_t i = 0; i < size; ++i) {
+            const auto& p = pairs[first + i];
+            for (const TimeWindow& w : block[i]) {
+                *out << catalogue.station_names[p.first] << ',' << catalogue.station_names[p.second] << ','
+                     << w.start << ',' << w.end << '\n';
+                total_time += w.end - w.start;
             }
+            total_windows += block[i].size();
         }
-};
+    }
+    out->flush();
+    if (!*out) {
+        throw runtime_error("Error escribiendo las ventanas");
+    }
+
+    chrono::duration<double> seconds = chrono::steady_clock::now() - start;
+    cerr << catalogue.planets.size() << " planetas, " << catalogue.stations.size() << " estaciones: "
+         << total_windows << " ventanas seguras en " << pairs.size() << " conexiones (duracion total "
+         << total_time << ") con " << options.threads << " hilos en " << seconds.count() << " s" << endl;
+    return 0;
+}
+
+int runBatch(const string& catalogueFile, BatchOptions options) {
+    auto start = chrono::steady_clock::now();
+    Catalogue catalogue = readCatalogue(catalogueFile);
+    if (options.threads == 0) {
+        options.threads = max(1u, thread::hardware_concurrency());
+    }
+    if (options.windows) {
+        return runWindows(catalogue, options, start);
+    }
+    if (options.occlusion) {
+        vector<Sphere> spheres;
+        spheres.reserve(catalogue.planets.size());
+        for (const Planet& planet : catalogue.planets) {
+            spheres.emplace_back(planet.center, planet.radius);
+        }
+        catalogue.occluders = SphereOccluders(move(spheres));
+    }
+
+    // In summary mode nothing is written, only counted
+    unique_ptr<ConnectionWriter> writer;
+    if (!options.summary) {
+        writer.reset(new ConnectionWriter(options.output, catalogue, options.occlusion));
+    }
+
+    ConnectionCounts counts;
+    uint64_t total;
+    if (options.allPairs || catalogue.connections.empty()) {
+        const uint64_t n = catalogue.stations.size();
+        total = n > 1 ? n * (n - 1) : 0;
+        counts = solveAllPairs(catalogue, options, writer.get());
+    } else {
+        total = catalogue.connections.size();
+        counts = solveListed(catalogue, options, writer.get());
+    }
+    if (writer) {
+        writer->finish();
+    }
+
+    chrono::duration<double> seconds = chrono::steady_clock::now() - start;
+    cerr << catalogue.planets.size() << " planetas, " << catalogue.stations.size() << " estaciones: "
+         << total << " conexiones evaluadas (" << counts.safety.safe << " seguras, " << counts.safety.safeLaunch
+         << " con lanzamiento seguro, " << counts.safety.safeReceive << " con recepcion segura";
+    if (options.occlusion) {
+        cerr << "; " << counts.clear << " con linea de vista, " << counts.usable << " seguras y con linea de vista";
+    }
+    cerr << ") con " << options.threads << " hilos en " << seconds.count() << " s" << endl;
+    return 0;
+}
 
-int main() {
+void printUsage(const char* program) {
+    cout << "Uso: " << program << "                      (modo interactivo)" << endl;
+    cout << "     " << program << " <catalogo.txt> [-o salida.csv|salida.bin] [-t hilos] [--all-pairs] [--summary] [--occlusion]" << endl;
+    cout << "     " << program << " <catalogo.txt> --windows <t0> <t1> [-o ventanas.csv] [-t hilos] [--all-pairs]" << endl;
+    cout << "     --summary: solo cuenta las conexiones seguras, sin escribirlas" << endl;
+    cout << "     --occlusion: comprueba tambien que ningun planeta corte la linea de vista" << endl;
+    cout << "     --windows: intervalos de [t0, t1] en los que cada conexion es segura con los planetas rotando" << endl;
+}
+
+int runInteractive() {
     try {
         cout << "=== SISTEMA DE CONTROL DE CATAPULTA CUANTICA FTL ===" << endl;
         cout << "FTL Dynamics - Tecnologia hasta 20c" << endl;
@@ -249,6 +531,7 @@ int main() {
         double inc1, azimut1;
         cin >> inc1 >> azimut1;
         Station station1(planet1, inc1, azimut1);
+        station1.printPosition();
         
         // Input for second planet
         cout << "\n--- PLANETA RECEPTOR ---" << endl;
@@ -273,6 +556,7 @@ int main() {
         double inc2, azimut2;
         cin >> inc2 >> azimut2;
         Station station2(planet2, inc2, azimut2);
+        station2.printPosition();
         
         // Create and display connection
         cout << "\n--- CALCULANDO CONEXIÓN ---" << endl;
@@ -285,4 +569,53 @@ int main() {
     }
     
     return 0;
-}
\ No newline at end of file
+}
+int main(int argc, char* argv[]) {
+    if (argc == 1) {
+        return runInteractive();
+    }
+
+    string catalogueFile;
+    BatchOptions options;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            string arg = argv[i];
+            if (arg == "-o" && i + 1 < argc) {
+                options.output = argv[++i];
+            } else if (arg == "-t" && i + 1 < argc) {
+                int threads = stoi(argv[++i]);
+                if (threads < 0 || threads > MAX_THREADS) {
+                    throw invalid_argument("Numero de hilos fuera de rango (0 a " + to_string(MAX_THREADS) + ")");
+                }
+                options.threads = static_cast<unsigned>(threads);
+            } else if (arg == "--all-pairs") {
+                options.allPairs = true;
+            } else if (arg == "--summary") {
+                options.summary = true;
+            } else if (arg == "--occlusion") {
+                options.occlusion = true;
+            } else if (arg == "--windows" && i + 2 < argc) {
+                options.windows = true;
+                options.windowStart = stod(argv[++i]);
+                options.windowEnd = stod(argv[++i]);
+            } else if (arg == "-h" || arg == "--help") {
+                printUsage(argv[0]);
+                return 0;
+            } else if (catalogueFile.empty() && arg[0] != '-') {
+                catalogueFile = arg;
+            } else {
+                printUsage(argv[0]);
+                return 1;
+            }
+        }
+        if (catalogueFile.empty()) {
+            printUsage(argv[0]);
+            return 1;
+        }
+
+        return runBatch(catalogueFile, options);
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+}
@@ -0,0 +1,211 @@
+#include "image.hpp"
+#include "png_writer.hpp"
+#include <iostream>
+#include <cmath>
+#include <OpenEXR/ImfRgbaFile.h>
+#include <OpenEXR/ImfArray.h>
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+using namespace Imf;
+using namespace Imath;
+
+// Function to load HDR image from OpenEXR file
+Image loadHDRImage(const string& filename) {
+    try {
+        RgbaInputFile file(filename.c_str());
+        Box2i dw = file.dataWindow();
+        
+        int width = dw.max.x - dw.min.x + 1;
+        int height = dw.max.y - dw.min.y + 1;
+        
+        Array2D<Rgba> pixels(height, width);
+        file.setFrameBuffer(&pixels[0][0] - dw.min.x - dw.min.y * width, 1, width);
+        file.readPixels(dw.min.y, dw.max.y);
+        
+        Image img(width, height);
+        
+        for (int i = 0; i < height; ++i) {
+            for (int j = 0; j < width; ++j) {
+                const Rgba& pixel = pixels[i][j];
+                img.imagen[i][j] = PixelRGB(pixel.r, pixel.g, pixel.b);
+            }
+        }
+        
+        cout << "HDR image loaded successfully: " << width << "x" << height << " pixels" << endl;
+        return img;
+        
+    } catch (const exception& e) {
+        throw runtime_error("Error loading HDR file: " + string(e.what()));
+    }
+}
+
+// Function to save HDR image as OpenEXR file
+void saveHDRImage(const Image& img, const string& filename) {
+    try {
+        Array2D<Rgba> pixels(img.height, img.width);
+        for (int i = 0; i < img.height; ++i) {
+            for (int j = 0; j < img.width; ++j) {
+                const PixelRGB& pixel = img.imagen[i][j];
+                pixels[i][j] = Rgba(pixel.R, pixel.G, pixel.B, 1.0f);
+            }
+        }
+
+        RgbaOutputFile file(filename.c_str(), img.width, img.height, WRITE_RGBA);
+        file.setFrameBuffer(&pixels[0][0], 1, img.width);
+        file.writePixels(img.height);
+
+    } catch (const exception& e) {
+        throw runtime_error("Error saving HDR file: " + string(e.what()));
+    }
+
+    cout << "HDR image saved successfully as: " << filename << endl;
+}
+
+// Function to save LDR image as PNG
+void savePNGImage(const Image& img, const string& filename) {
+    PNGWriter writer(filename, img.width, img.height);
+
+    vector<uint8_t> row(static_cast<size_t>(img.width) * 3);
+    for (int i = 0; i < img.height; ++i) {
+        for (int j = 0; j < img.width; ++j) {
+            const PixelRGB& pixel = img.imagen[i][j];
+            row[j * 3] = static_cast<uint8_t>(pixel.R);
+            row[j * 3 + 1] = static_cast<uint8_t>(pixel.G);
+            row[j * 3 + 2] = static_cast<uint8_t>(pixel.B);
+        }
+        writer.writeRows(row.data(), 1);
+    }
+    writer.finish();
+
+    cout << "LDR image saved successfully as: " << filename << endl;
+}
+
+// img should be a HDR image with values in [0.0, +inf)
+Image clamping(const Image& img) {
+    Image result(img.width, img.height);
+    for (int i = 0; i < img.height; ++i) {
+        for (int j = 0; j < img.width; ++j) {
+            const PixelRGB& pixel = img.imagen[i][j];
+            // Clamp HDR values to [0, 1] range, then scale to [0, 255]
+            double r = max(0.0, min(1.0, pixel.R)) * 255.0;
+            double g = max(0.0, min(1.0, pixel.G)) * 255.0;
+            double b = max(0.0, min(1.0, pixel.B)) * 255.0;
+            
+            result.imagen[i][j] = PixelRGB(r, g, b);
+        }
+    }
+
+    return result;
+}
+
+Image ecualization(const Image& img) {
+    double minR = 1e9, maxR = -1e9;
+    double minG = 1e9, maxG = -1e9;
+    double minB = 1e9, maxB = -1e9;
+
+    // Encuentra mínimos y máximos de cada canal
+    for (int i = 0; i < img.height; ++i) {
+        for (int j = 0; j < img.width; ++j) {
+            const PixelRGB& pixel = img.imagen[i][j];
+            minR = std::min(minR, pixel.R);
+            maxR = std::max(maxR, pixel.R);
+            minG = std::min(minG, pixel.G);
+            maxG = std::max(maxG, pixel.G);
+            minB = std::min(minB, pixel.B);
+            maxB = std::max(maxB, pixel.B);
+        }
+    }
+
+    Image result(img.width, img.height);
+    // Normaliza cada canal
+    for (int i = 0; i < img.height; ++i) {
+        for (int j = 0; j < img.width; ++j) {
+            const PixelRGB& pixel = img.imagen[i][j];
+            double r = (pixel.R - minR) / (maxR - minR) * 255.0;
+            double g = (pixel.G - minG) / (maxG - minG) * 255.0;
+            double b = (pixel.B - minB) / (maxB - minB) * 255.0;
+            // Clamp por seguridad
+            r = std::max(0.0, std::min(255.0, r));
+            g = std::max(0.0, std::min(255.0, g));
+            b = std::max(0.0, std::min(255.0, b));
+            result.imagen[i][j] = PixelRGB(r, g, b);
+        }
+    }
+    return result;
+}
+
+Image clamp_ecualization(const Image& img, double threshold) {
+    double minR = 1e9, maxR = -1e9;
+    double minG = 1e9, maxG = -1e9;
+    double minB = 1e9, maxB = -1e9;
+
+    // Encuentra mínimos y máximos de cada canal
+    for (int i = 0; i < img.height; ++i) {
+        for (int j = 0; j < img.width; ++j) {
+            const PixelRGB& pixel = img.imagen[i][j];
+            minR = std::min(minR, pixel.R);
+            maxR = std::max(maxR, pixel.R);
+            minG = std::min(minG, pixel.G);
+            maxG = std::max(maxG, pixel.G);
+            minB = std::min(minB, pixel.B);
+            maxB = std::max(maxB, pixel.B);
+        }
+    }
+
+    Image result(img.width, img.height);
+    for (int i = 0; i < img.height; ++i) {
+        for (int j = 0; j < img.width; ++j) {
+            const PixelRGB& pixel = img.imagen[i][j];
+            double r, g, b;
+
+            // R
+            if (pixel.R <= threshold) {
+                r = (pixel.R - minR) / (threshold - minR) * 255.0;
+            } else { r = 255.0; }
+            // G
+            if (pixel.G <= threshold) {
+                g = (pixel.G - minG) / (threshold - minG) * 255.0;
+            } else { g = 255.0; }
+            // B
+            if (pixel.B <= threshold) {
+                b = (pixel.B - minB) / (threshold - minB) * 255.0;
+            } else { b = 255.0; }
+
+            // Clamp por seguridad
+            r = std::max(0.0, std::min(255.0, r));
+            g = std::max(0.0, std::min(255.0, g));
+            b = std::max(0.0, std::min(255.0, b));
+            result.imagen[i][j] = PixelRGB(r, g, b);
+        }
+    }
+    return result;
+}
+
+// Hay que usar ecualización antes de aplicar la curva gamma
+Image gamma_curve(const Image& img, double gamma) {
+    Image result(img.width, img.height);
+    for (int i = 0; i < img.height; ++i) {
+        for (int j = 0; j < img.width; ++j) {
+            const PixelRGB& pixel = img.imagen[i][j];
+            double r = 255.0 * pow(pixel.R / 255.0, 1.0 / gamma);
+            double g = 255.0 * pow(pixel.G / 255.0, 1.0 / gamma);
+            double b = 255.0 * pow(pixel.B / 255.0, 1.0 / gamma);
+            // Clamp por seguridad
+            r = std::max(0.0, std::min(255.0, r));
+            g = std::max(0.0, std::min(255.0, g));
+            b = std::max(0.0, std::min(255.0, b));
+            result.imagen[i][j] = PixelRGB(r, g, b);
+        }
+    }
+    return result;
+}
+
+Image clamp_gamma(const Image& img, double clamp_threshold, double gamma) {
+    // 1. Clamping
+    Image clamped = clamp_ecualization(img, clamp_threshold);
+    // 2. Curva gamma
+    Image gamma_img = gamma_curve(clamped, gamma);
+    return gamma_img;
+}
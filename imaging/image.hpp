@@ -0,0 +1,124 @@
+#ifndef IMAGE_HPP
+#define IMAGE_HPP
+
+#include <stdexcept>
+#include <string>
+
+class PixelRGB {
+    public: 
+        double R, G, B;
+
+        PixelRGB() : R(0.0), G(0.0), B(0.0) {}
+        PixelRGB(double r, double g, double b) : R(r), G(g), B(b) {}
+
+        PixelRGB operator+(const PixelRGB& other) const {
+            return PixelRGB(R + other.R, G + other.G, B + other.B);
+        }
+
+        PixelRGB operator*(double scalar) const {
+            return PixelRGB(R * scalar, G * scalar, B * scalar);
+        }
+
+        // Component-wise product (e.g. light times albedo)
+        PixelRGB operator*(const PixelRGB& other) const {
+            return PixelRGB(R * other.R, G * other.G, B * other.B);
+        }
+
+        PixelRGB& operator+=(const PixelRGB& other) {
+            R += other.R;
+            G += other.G;
+            B += other.B;
+            return *this;
+        }
+};
+
+class Image {
+    public:
+        PixelRGB** imagen;
+        int width;
+        int height;
+
+        // Empty image constructor
+        Image(int w, int h) : width(w), height(h) {
+            imagen = new PixelRGB*[height]; // Rows
+            for (int i = 0; i < height; ++i) {
+                imagen[i] = new PixelRGB[width]; // Columns
+            }
+        }
+
+        // Copy constructor
+        Image(const Image& other) : width(other.width), height(other.height) {
+            imagen = new PixelRGB*[height];
+            for (int i = 0; i < height; ++i) {
+                imagen[i] = new PixelRGB[width];
+                for (int j = 0; j < width; ++j) {
+                    imagen[i][j] = other.imagen[i][j];
+                }
+            }
+        }
+
+        // Destructor
+        ~Image() {
+            for (int i = 0; i < height; ++i) {
+                delete[] imagen[i];
+            }
+            delete[] imagen;
+        }
+
+        // Addition operator
+        Image operator+(const Image& other) const {
+            if (width != other.width || height != other.height) {
+                throw std::invalid_argument("Images must have the same dimensions for addition.");
+            }
+
+            Image result(width, height);
+            for (int i = 0; i < height; ++i) {
+                for (int j = 0; j < width; ++j) {
+                    result.imagen[i][j] = imagen[i][j] + other.imagen[i][j];
+                }
+            }
+            return result;
+        }
+
+        Image& operator=(const Image& other) {
+            if (this != &other) {
+                // Free existing memory
+                for (int i = 0; i < height; ++i) {
+                    delete[] imagen[i];
+                }
+                delete[] imagen;
+
+                // Copy dimensions
+                width = other.width;
+                height = other.height;
+
+                // Allocate new memory
+                imagen = new PixelRGB*[height];
+                for (int i = 0; i < height; ++i) {
+                    imagen[i] = new PixelRGB[width];
+                    for (int j = 0; j < width; ++j) {
+                        imagen[i][j] = other.imagen[i][j];
+                    }
+                }
+            }
+            return *this;
+        }
+};
+
+// Function to load HDR image from OpenEXR file
+Image loadHDRImage(const std::string& filename);
+
+// Function to save HDR image as OpenEXR file
+void saveHDRImage(const Image& img, const std::string& filename);
+
+// Function to save LDR image as PNG
+void savePNGImage(const Image& img, const std::string& filename);
+
+// Tone mapping operators (HDR input, LDR output in [0, 255])
+Image clamping(const Image& img);
+Image ecualization(const Image& img);
+Image clamp_ecualization(const Image& img, double threshold);
+Image gamma_curve(const Image& img, double gamma);
+Image clamp_gamma(const Image& img, double clamp_threshold, double gamma);
+
+#endif // IMAGE_HPP
@@ -0,0 +1,129 @@
+#include "png_writer.hpp"
+#include <png.h>
+#include <cstdio>
+#include <stdexcept>
+
+using namespace std;
+
+namespace {
+
+void appendToBuffer(png_structp png, png_bytep data, png_size_t length) {
+    auto* buffer = static_cast<vector<uint8_t>*>(png_get_io_ptr(png));
+    buffer->insert(buffer->end(), data, data + length);
+}
+
+void flushNothing(png_structp) {}
+
+} // namespace
+
+// libpng reports errors by longjmp, so every function that calls it sets
+// its own jump point
+
+PNGWriter::PNGWriter(const std::string& filename_, int width_, int height_)
+    : filename(filename_), width(width_), height(height_), written(0), finished(false),
+      file(nullptr), png(nullptr), info(nullptr) {
+    file = fopen(filename.c_str(), "wb");
+    if (!file) {
+        throw runtime_error("Cannot open file for writing: " + filename);
+    }
+
+    png = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+    if (!png) {
+        fclose(file);
+        remove(filename.c_str());
+        throw runtime_error("Cannot create PNG write structure");
+    }
+
+    info = png_create_info_struct(png);
+    if (!info) {
+        png_destroy_write_struct(&png, NULL);
+        fclose(file);
+        remove(filename.c_str());
+        throw runtime_error("Cannot create PNG info structure");
+    }
+
+    if (setjmp(png_jmpbuf(png))) {
+        png_destroy_write_struct(&png, &info);
+        fclose(file);
+        remove(filename.c_str());
+        throw runtime_error("Error during PNG creation");
+    }
+
+    png_init_io(png, file);
+    png_set_IHDR(png, info, width, height, 8, PNG_COLOR_TYPE_RGB,
+                 PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+    png_write_info(png, info);
+}
+
+PNGWriter::~PNGWriter() {
+    if (png) {
+        png_destroy_write_struct(&png, &info);
+    }
+    if (file) {
+        fclose(file);
+    }
+    if (!finished) {
+        remove(filename.c_str());
+    }
+}
+
+void PNGWriter::writeRows(const uint8_t* rgb, int count) {
+    if (written + count > height) {
+        throw logic_error("PNGWriter: more rows than the image height");
+    }
+    if (setjmp(png_jmpbuf(png))) {
+        throw runtime_error("Error during PNG creation");
+    }
+    for (int i = 0; i < count; ++i) {
+        png_write_row(png, const_cast<png_bytep>(rgb + static_cast<size_t>(i) * width * 3));
+    }
+    written += count;
+}
+
+void PNGWriter::finish() {
+    if (written != height) {
+        throw logic_error("PNGWriter: the image is incomplete");
+    }
+    if (setjmp(png_jmpbuf(png))) {
+        throw runtime_error("Error during PNG creation");
+    }
+    png_write_end(png, NULL);
+    png_destroy_write_struct(&png, &info);
+    png = nullptr;
+    info = nullptr;
+
+    int closed = fclose(file);
+    file = nullptr;
+    if (closed != 0) {
+        throw runtime_error("Error writing file: " + filename);
+    }
+    finished = true;
+}
+
+vector<uint8_t> encodePNG(const uint8_t* rgb, int width, int height) {
+    vector<uint8_t> buffer;
+    png_structp png = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+    if (!png) {
+        throw runtime_error("Cannot create PNG write structure");
+    }
+    png_infop info = png_create_info_struct(png);
+    if (!info) {
+        png_destroy_write_struct(&png, NULL);
+        throw runtime_error("Cannot create PNG info structure");
+    }
+    if (setjmp(png_jmpbuf(png))) {
+        png_destroy_write_struct(&png, &info);
+        throw runtime_error("Error during PNG creation");
+    }
+
+    png_set_write_fn(png, &buffer, appendToBuffer, flushNothing);
+    png_set_IHDR(png, info, width, height, 8, PNG_COLOR_TYPE_RGB,
+                 PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+    png_write_info(png, info);
+    for (int y = 0; y < height; ++y) {
+        png_write_row(png, const_cast<png_bytep>(rgb + static_cast<size_t>(y) * width * 3));
+    }
+    png_write_end(png, NULL);
+    png_destroy_write_struct(&png, &info);
+    return buffer;
+}
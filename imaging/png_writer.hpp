@@ -0,0 +1,47 @@
+#ifndef PNG_WRITER_HPP
+#define PNG_WRITER_HPP
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// libpng handles, kept opaque so png.h stays out of the header
+struct png_struct_def;
+struct png_info_def;
+
+// 8 bit RGB PNG file encoded row by row, so the rows of an image can be
+// compressed and written while the rest of it is still being produced.
+// A file that is not finished is removed when the writer is destroyed.
+class PNGWriter {
+    public:
+        // Opens the file and writes the header. Throws runtime_error
+        PNGWriter(const std::string& filename_, int width_, int height_);
+        ~PNGWriter();
+
+        PNGWriter(const PNGWriter&) = delete;
+        PNGWriter& operator=(const PNGWriter&) = delete;
+
+        // Appends count rows of width * 3 bytes each (RGB), top to bottom
+        void writeRows(const uint8_t* rgb, int count);
+
+        // Ends the file; every row must have been written
+        void finish();
+
+        int rowsWritten() const { return written; }
+
+    private:
+        std::string filename;
+        int width, height;
+        int written;
+        bool finished;
+        FILE* file;
+        png_struct_def* png;
+        png_info_def* info;
+};
+
+// Whole 8 bit RGB image (width * 3 bytes per row) encoded as a PNG in memory,
+// for images that are sent rather than saved. Throws runtime_error
+std::vector<uint8_t> encodePNG(const uint8_t* rgb, int width, int height);
+
+#endif // PNG_WRITER_HPP
@@ -0,0 +1,93 @@
+#include "tone_map.hpp"
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <vector>
+
+using namespace std;
+
+ToneMap ToneMap::parse(const std::string& spec) {
+    // Name and parameters separated by ':'
+    vector<string> parts;
+    stringstream ss(spec);
+    string part;
+    while (getline(ss, part, ':')) {
+        parts.push_back(part);
+    }
+    if (parts.empty()) {
+        throw invalid_argument("Operador de tone mapping vacio.");
+    }
+
+    ToneMap toneMap;
+    const string& name = parts[0];
+    size_t parameters;
+    if (name == "display") {
+        toneMap.op = Display;
+        parameters = 1;
+    } else if (name == "clamping") {
+        toneMap.op = Clamping;
+        parameters = 0;
+    } else if (name == "ecualization") {
+        toneMap.op = Ecualization;
+        parameters = 0;
+    } else if (name == "clamp_ecualization") {
+        toneMap.op = ClampEcualization;
+        parameters = 1;
+    } else if (name == "gamma") {
+        toneMap.op = Gamma;
+        parameters = 1;
+    } else if (name == "clamp_gamma") {
+        toneMap.op = ClampGamma;
+        parameters = 2;
+    } else {
+        throw invalid_argument("Operador de tone mapping desconocido '" + name +
+                               "' (display, clamping, ecualization, clamp_ecualization, gamma o clamp_gamma).");
+    }
+    if (parts.size() > parameters + 1) {
+        throw invalid_argument("Demasiados parametros para el operador '" + name + "'.");
+    }
+
+    try {
+        // The threshold comes first for the clamp operators, gamma last
+        bool hasThreshold = toneMap.op == ClampEcualization || toneMap.op == ClampGamma;
+        for (size_t i = 1; i < parts.size(); ++i) {
+            double value = stod(parts[i]);
+            if (hasThreshold && i == 1) {
+                toneMap.threshold = value;
+            } else {
+                toneMap.gamma = value;
+            }
+        }
+    } catch (const logic_error&) {
+        throw invalid_argument("Parametro no numerico en el operador '" + spec + "'.");
+    }
+    if (toneMap.gamma <= 0) {
+        throw invalid_argument("La gamma debe ser positiva.");
+    }
+    return toneMap;
+}
+
+void ToneMap::mapPixel(const PixelRGB& hdr, uint8_t rgb[3]) const {
+    // Same operations, in the same order, as clamping() and gamma_curve()
+    const double channels[3] = { hdr.R, hdr.G, hdr.B };
+    for (int c = 0; c < 3; ++c) {
+        double v = max(0.0, min(1.0, channels[c])) * 255.0;
+        if (op == Display) {
+            v = 255.0 * pow(v / 255.0, 1.0 / gamma);
+            v = max(0.0, min(255.0, v));
+        }
+        rgb[c] = static_cast<uint8_t>(v);
+    }
+}
+
+Image ToneMap::apply(const Image& hdr) const {
+    switch (op) {
+        case Display: return gamma_curve(clamping(hdr), gamma);
+        case Clamping: return clamping(hdr);
+        case Ecualization: return ecualization(hdr);
+        case ClampEcualization: return clamp_ecualization(hdr, threshold);
+        case Gamma: return gamma_curve(ecualization(hdr), gamma); // As the imaging tool does
+        case ClampGamma: return clamp_gamma(hdr, threshold, gamma);
+    }
+    return clamping(hdr);
+}
@@ -0,0 +1,35 @@
+#ifndef TONE_MAP_HPP
+#define TONE_MAP_HPP
+
+#include "image.hpp"
+#include <cstdint>
+#include <string>
+
+// One of the tone mapping operators of image.hpp with its parameters, so a
+// renderer can turn its HDR framebuffer into 8 bit RGB without going through
+// an EXR file
+struct ToneMap {
+    enum Operator { Display, Clamping, Ecualization, ClampEcualization, Gamma, ClampGamma };
+
+    Operator op = Display;  // Clamping followed by the gamma curve: the usual preview
+    double threshold = 1.0; // ClampEcualization and ClampGamma
+    double gamma = 2.2;     // Display, Gamma and ClampGamma
+
+    // "display", "clamping", "ecualization", "clamp_ecualization:<umbral>",
+    // "gamma:<gamma>" or "clamp_gamma:<umbral>:<gamma>" (the parameters are
+    // optional). Throws invalid_argument.
+    static ToneMap parse(const std::string& spec);
+
+    // Whether every pixel maps on its own, without statistics of the whole
+    // image. Only then can tiles be mapped as soon as they are rendered.
+    bool local() const { return op == Display || op == Clamping; }
+
+    // 8 bit RGB of one pixel under a local operator, the same bytes that
+    // savePNGImage(apply(...)) writes
+    void mapPixel(const PixelRGB& hdr, uint8_t rgb[3]) const;
+
+    // LDR image (values in [0, 255]) of any operator
+    Image apply(const Image& hdr) const;
+};
+
+#endif // TONE_MAP_HPP
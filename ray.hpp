@@ -11,8 +11,9 @@ class Ray {
     public:
         Point o; // Origin of the ray
         Direction d; // Direction of the ray (should be normalized)
+        double time; // Instant within the exposure, from 0 (shutter open) to 1 (shutter close)
 
-        Ray(const Point& origin_, const Direction& direction_);
+        Ray(const Point& origin_, const Direction& direction_, double time_ = 0.0);
 
         // Generic method that works with any geometric shape
         std::vector<Point> intersections(const GeometricShape& shape) const;
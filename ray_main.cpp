@@ -0,0 +1,492 @@
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <string>
+#include <chrono>
+#include <limits>
+#include <atomic>
+#include <csignal>
+#include <fstream>
+#include <thread>
+#include "ray.hpp"
+#include "geometry/geometric_shape.hpp"
+#include "geometry/sphere.hpp"
+#include "geometry/plane.hpp"
+#include "geometry/instance.hpp"
+#include "geometry/mesh_loader.hpp"
+#include "scene/scene_file.hpp"
+#include "render/camera.hpp"
+#include "render/renderer.hpp"
+#include "render/distributed.hpp"
+#include "render/path_tracer.hpp"
+#include "render/preview_server.hpp"
+#include "render/render_profile.hpp"
+#include "render/tile_output.hpp"
+
+using namespace std;
+
+// Raised by Ctrl+C: the path tracer stops after the current pass
+atomic<bool> interrupted(false);
+
+extern "C" void onInterrupt(int) {
+    interrupted = true;
+}
+
+void printUsage(const char* program) {
+    cout << "Uso: " << program << "                      (modo interactivo)" << endl;
+    cout << "     " << program << " <escena.txt> [-o salida.exr] [-t hilos] [--tile lado] [--no-packets] [--quiet] [--no-cache]" << endl;
+    cout << "         [--primary] [--spp muestras] [--checkpoint fichero] [--checkpoint-interval s] [--resume]" << endl;
+    cout << "         [--sampler random|sobol|halton|bluenoise] [--seed n] [--adaptive umbral] [--min-spp n]" << endl;
+    cout << "         [--precision double|float] [--tonemap operador[:parametros]] [--preview puerto] [--preview-cpu fraccion]" << endl;
+    cout << "         [--coordinator puerto] [--spawn trabajadores] [--worker-timeout s] [--worker host:puerto]" << endl;
+    cout << "         [--stats fichero.json]" << endl;
+}
+
+PrimitiveStore::Precision parsePrecision(const string& name) {
+    if (name == "double") {
+        return PrimitiveStore::Precision::Double;
+    } else if (name == "float") {
+        return PrimitiveStore::Precision::Float;
+    }
+    throw invalid_argument("Precision desconocida '" + name + "' (double o float).");
+}
+
+// Path traces the scene, resuming from the checkpoint when asked to and it exists
+Image renderPaths(const Scene& scene, const string& sceneFile, const Camera& camera, TileScheduler& scheduler,
+                  const RenderOptions& options, ProgressiveOptions progressive, bool resume, RenderStats& stats) {
+    // Samples of another sampler or seed must not be mixed in
+    uint64_t salt = static_cast<uint64_t>(progressive.sampler) << 32 | progressive.seed;
+    progressive.fingerprint = renderFingerprint(sceneFile, camera.width, camera.height, salt);
+    progressive.stop = &interrupted;
+
+    Accumulator acc(camera.width, camera.height);
+    if (resume && ifstream(progressive.checkpoint)) {
+        acc = Accumulator::loadCheckpoint(progressive.checkpoint, progressive.fingerprint);
+        cout << "Reanudando desde '" << progressive.checkpoint << "' con " << acc.averageSamples() << " muestras por pixel." << endl;
+    }
+
+    signal(SIGINT, onInterrupt);
+    renderProgressive(scene, camera, scheduler, options, progressive, acc, stats);
+    signal(SIGINT, SIG_DFL);
+
+    if (interrupted) {
+        cout << "Render interrumpido con " << acc.averageSamples() << " muestras por pixel." << endl;
+    }
+    return acc.average();
+}
+
+// What is made of the render besides the EXR
+struct OutputOptions {
+    ToneMap toneMap;          // Of the PNG
+    int previewPort = -1;     // Port of the live preview, -1 for none
+    double previewCpu = 0.05; // Share of the render CPU the preview may take
+    string stats;             // JSON summary of the costs (and <stem>_heatmap.png), empty for none
+};
+
+// Role of this process in a render split over several processes
+struct DistributedMode {
+    bool coordinator = false;
+    CoordinatorOptions settings;
+    string worker; // Address of the coordinator when this process is a worker
+};
+
+// Loads a scene file and renders it without prompts. The PNG is tone mapped
+// in memory and written while the tiles finish.
+int runScene(const string& sceneFile, bool useCache, const string& output, RenderOptions options,
+             bool primaryOnly, const ProgressiveOptions& progressive, bool resume, const OutputOptions& outputs,
+             const DistributedMode& distributed) {
+    auto inicio = chrono::steady_clock::now();
+    Scene scene = loadScene(sceneFile, useCache);
+    scene.primitives.precision = options.precision;
+    chrono::duration<double> tiempo = chrono::steady_clock::now() - inicio;
+
+    cout << "Escena '" << sceneFile << "' cargada en " << tiempo.count() << " s: "
+         << scene.shapes.size() << " formas, " << scene.materials.size() - 1 << " materiales, "
+         << scene.lights.size() << " luces." << endl;
+
+    Camera camera(scene.camera, scene.settings.width, scene.settings.height);
+    RenderStats stats;
+    if (!distributed.worker.empty()) {
+        runWorker(scene, sceneFile, camera, distributed.worker, options, stats);
+        cout << "Trabajo de " << stats.seconds << " s: " << stats.primaryRays << " rayos primarios, "
+             << stats.secondaryRays << " rayos secundarios, " << stats.shadowRays << " rayos de sombra" << endl;
+        return 0;
+    }
+    TileScheduler scheduler(distributed.coordinator ? 1 : options.threads);
+
+    const string stem = renderStem(output.empty() ? scene.settings.output : output);
+    TiledPNGOutput png(stem + ".png", camera.width, camera.height, outputs.toneMap);
+    options.sink = [&png](const Tile& tile, const PixelRGB* pixels) { png.addTile(tile, pixels); };
+
+    unique_ptr<PreviewServer> preview;
+    if (outputs.previewPort >= 0) {
+        preview = make_unique<PreviewServer>(outputs.previewPort, camera.width, camera.height,
+                                             makeTiles(camera.width, camera.height, options.tileSize),
+                                             outputs.toneMap, outputs.previewCpu, scheduler.threadCount());
+        options.update = [&preview](const Tile& tile, const PixelRGB* pixels) { preview->update(tile, pixels); };
+        cout << "Vista previa en http://127.0.0.1:" << preview->port() << "/" << endl;
+    }
+
+    unique_ptr<RenderProfile> profile;
+    if (!outputs.stats.empty()) {
+        profile = make_unique<RenderProfile>(camera.width, camera.height, options.tileSize);
+        options.profile = profile.get();
+    }
+
+    Image image = distributed.coordinator
+                      ? renderDistributed(sceneFile, camera, options, progressive, primaryOnly, distributed.settings, stats)
+                  : primaryOnly ? renderPrimary(scene, camera, scheduler, options, stats)
+                                : renderPaths(scene, sceneFile, camera, scheduler, options, progressive, resume, stats);
+
+    cout << "Render " << camera.width << "x" << camera.height << " con " << scheduler.threadCount()
+         << " hilos en " << stats.seconds << " s: "
+         << stats.primaryRays << " rayos primarios, " << stats.secondaryRays << " rayos secundarios, "
+         << stats.shadowRays << " rayos de sombra (" << stats.raysPerSecond() / 1e6 << " Mrayos/s)" << endl;
+
+    if (preview) {
+        preview->finish();
+    }
+    saveHDRImage(image, stem + ".exr");
+    png.finish(image);
+    if (profile) {
+        const string heatmap = renderStem(outputs.stats) + "_heatmap.png";
+        profile->saveSummary(outputs.stats, sceneFile, stats, scheduler.threadCount());
+        profile->saveHeatmap(heatmap);
+        cout << "Estadisticas guardadas en '" << outputs.stats << "' y '" << heatmap << "'." << endl;
+    }
+    return 0;
+}
+
+int runInteractive() {
+    cout << "=== SISTEMA DE INTERSECCIÓN CON FORMAS GEOMÉTRICAS ===" << endl;
+    cout << "Configuración del rayo:" << endl;
+    
+    Direction rayDirection;
+    double rDx, rDy, rDz;
+
+    cout << "Dirección del rayo (dx, dy, dz): ";
+    cin >> rDx >> rDy >> rDz;
+    rayDirection = Direction(rDx, rDy, rDz);
+
+    Point rayOrigin = Point(0, 0, 0);
+    Ray ray(rayOrigin, rayDirection.normalized());
+    
+    // Escena con las formas creadas: cada alta, movimiento o baja actualiza
+    // su BVH en el sitio, sin reconstruirlo
+    Scene scene;
+    
+    int opcion;
+    do {
+        cout << "\n=== MENÚ PRINCIPAL ===" << endl;
+        cout << "1. Agregar Esfera" << endl;
+        cout << "2. Agregar Plano" << endl;
+        cout << "3. Listar Formas Creadas" << endl;
+        cout << "4. Investigar Intersecciones con Todas las Formas" << endl;
+        cout << "5. Cargar Malla (OBJ/PLY)" << endl;
+        cout << "6. Mover Forma" << endl;
+        cout << "7. Eliminar Forma" << endl;
+        cout << "0. Salir" << endl;
+        cout << "Selecciona una opción: ";
+        cin >> opcion;
+        
+        switch(opcion) {
+            case 1: {
+                string nombre;
+                cout << "\nNombre para la esfera: ";
+                cin >> nombre;
+                
+                if (scene.findShape(nombre) >= 0) {
+                    cout << "Error: Ya existe una forma con el nombre '" << nombre << "'" << endl;
+                    break;
+                }
+                
+                Point sphereCenter;
+                double spX, spY, spZ, sphereRadius;
+                
+                cout << "Centro de la esfera (x, y, z): ";
+                cin >> spX >> spY >> spZ;
+                sphereCenter = Point(spX, spY, spZ);
+                cout << "Radio: ";
+                cin >> sphereRadius;
+                
+                scene.insertShape(nombre, make_unique<Sphere>(sphereCenter, sphereRadius));
+                cout << "Esfera '" << nombre << "' agregada exitosamente." << endl;
+                break;
+            }
+            
+            case 2: {
+                string nombre;
+                cout << "\nNombre para el plano: ";
+                cin >> nombre;
+                
+                if (scene.findShape(nombre) >= 0) {
+                    cout << "Error: Ya existe una forma con el nombre '" << nombre << "'" << endl;
+                    break;
+                }
+                
+                Direction planeNormal;
+                double planeNormalX, planeNormalY, planeNormalZ;
+                Point planePoint;
+                double planePointX, planePointY, planePointZ;
+                
+                cout << "Normal del plano (dx, dy, dz): ";
+                cin >> planeNormalX >> planeNormalY >> planeNormalZ;
+                planeNormal = Direction(planeNormalX, planeNormalY, planeNormalZ);
+                cout << "Punto en el plano (x, y, z): ";
+                cin >> planePointX >> planePointY >> planePointZ;
+                planePoint = Point(planePointX, planePointY, planePointZ);
+                
+                scene.insertShape(nombre, make_unique<Plane>(planeNormal.normalized(), planePoint));
+                cout << "Plano '" << nombre << "' agregado exitosamente." << endl;
+                break;
+            }
+            
+            case 3: {
+                cout << "\n=== FORMAS GEOMÉTRICAS CREADAS ===" << endl;
+                if (scene.shapes.empty()) {
+                    cout << "No hay formas geométricas creadas." << endl;
+                } else {
+                    for (size_t i = 0; i < scene.shapes.size(); ++i) {
+                        cout << (i + 1) << ". Nombre: '" << scene.names[i] << "' - ";
+                        scene.shapes[i]->print();
+                    }
+                }
+                break;
+            }
+            
+            case 4: {
+                cout << "\n=== INVESTIGACIÓN DE INTERSECCIONES ===" << endl;
+                if (scene.shapes.empty()) {
+                    cout << "No hay formas geométricas para investigar." << endl;
+                    break;
+                }
+                
+                cout << "Rayo: origen=" << rayOrigin << ", dirección=" << rayDirection << endl;
+                cout << "\nResultados de intersecciones:" << endl;
+                
+                bool hayIntersecciones = false;
+                for (size_t i = 0; i < scene.shapes.size(); ++i) {
+                    vector<Point> intersections = ray.intersections(*scene.shapes[i]);
+                    
+                    cout << "\n• Forma: '" << scene.names[i] << "'" << endl;
+                    cout << "  Tipo: ";
+                    scene.shapes[i]->print();
+                    
+                    if (intersections.empty()) {
+                        cout << "  Intersecciones: Ninguna" << endl;
+                    } else {
+                        cout << "  Intersecciones encontradas: " << intersections.size() << endl;
+                        for (size_t i = 0; i < intersections.size(); ++i) {
+                            cout << "    " << (i+1) << ". " << intersections[i] << endl;
+                        }
+                        hayIntersecciones = true;
+                    }
+                }
+                
+                if (!hayIntersecciones) {
+                    cout << "\nEl rayo no intersecta con ninguna de las formas geométricas." << endl;
+                } else {
+                    cout << "\n¡Se encontraron intersecciones!" << endl;
+                }
+
+                HitRecord hit;
+                if (scene.closestHit(ray, 0.0, numeric_limits<double>::infinity(), hit)) {
+                    cout << "Intersección más cercana (BVH): '" << scene.names[hit.shape] << "' en " << hit.point
+                         << ", t=" << hit.t << endl;
+                }
+                break;
+            }
+            
+            case 5: {
+                string nombre;
+                cout << "\nNombre para la malla: ";
+                cin >> nombre;
+                
+                if (scene.findShape(nombre) >= 0) {
+                    cout << "Error: Ya existe una forma con el nombre '" << nombre << "'" << endl;
+                    break;
+                }
+                
+                string fichero;
+                cout << "Fichero de la malla (.obj o .ply): ";
+                cin >> fichero;
+                
+                try {
+                    auto inicio = chrono::steady_clock::now();
+                    unique_ptr<Mesh> mesh = loadMesh(fichero);
+                    chrono::duration<double> tiempo = chrono::steady_clock::now() - inicio;
+                    
+                    cout << "Malla '" << nombre << "' cargada en " << tiempo.count() << " s: "
+                         << mesh->vertices.size() << " vertices, " << mesh->faces.size() << " triangulos." << endl;
+                    // La malla se comparte como objeto y se coloca con una instancia,
+                    // que es lo que se mueve sin tocar su BVH
+                    int objeto = scene.addObject(nombre + "#" + to_string(scene.objects.size()), std::move(mesh));
+                    scene.insertShape(nombre, make_unique<Instance>(scene.objects[objeto], Matrix4d::Identity()));
+                } catch (const exception& e) {
+                    cout << "Error cargando la malla: " << e.what() << endl;
+                }
+                break;
+            }
+            
+            case 6: {
+                string nombre;
+                cout << "\nNombre de la forma a mover: ";
+                cin >> nombre;
+                
+                int forma = scene.findShape(nombre);
+                if (forma < 0) {
+                    cout << "Error: No existe una forma con el nombre '" << nombre << "'" << endl;
+                    break;
+                }
+                
+                double dX, dY, dZ;
+                cout << "Desplazamiento (dx, dy, dz): ";
+                cin >> dX >> dY >> dZ;
+                Vector3d desplazamiento(dX, dY, dZ);
+                
+                const GeometricShape* actual = scene.shapes[forma].get();
+                unique_ptr<GeometricShape> movida;
+                if (auto esfera = dynamic_cast<const Sphere*>(actual)) {
+                    movida = make_unique<Sphere>(Point(esfera->center.coords + desplazamiento), esfera->radius);
+                } else if (auto plano = dynamic_cast<const Plane*>(actual)) {
+                    movida = make_unique<Plane>(plano->normal, Point(plano->origin.coords + desplazamiento));
+                } else if (auto instancia = dynamic_cast<const Instance*>(actual)) {
+                    movida = make_unique<Instance>(instancia->object,
+                                                   translation(desplazamiento) * instancia->transformation_matrix);
+                }
+                
+                auto inicio = chrono::steady_clock::now();
+                scene.replaceShape(forma, std::move(movida));
+                chrono::duration<double> tiempo = chrono::steady_clock::now() - inicio;
+                cout << "Forma '" << nombre << "' movida en " << tiempo.count() << " s." << endl;
+                break;
+            }
+            
+            case 7: {
+                string nombre;
+                cout << "\nNombre de la forma a eliminar: ";
+                cin >> nombre;
+                
+                int forma = scene.findShape(nombre);
+                if (forma < 0) {
+                    cout << "Error: No existe una forma con el nombre '" << nombre << "'" << endl;
+                    break;
+                }
+                
+                scene.removeShape(forma);
+                cout << "Forma '" << nombre << "' eliminada exitosamente." << endl;
+                break;
+            }
+            
+            case 0:
+                cout << "Saliendo del programa..." << endl;
+                break;
+                
+            default:
+                cout << "Opción no válida. Por favor, selecciona una opción del menú." << endl;
+        }
+        
+    } while (opcion != 0);
+
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc == 1) {
+        return runInteractive();
+    }
+
+    string sceneFile, output;
+    bool useCache = true, primaryOnly = false, resume = false;
+    RenderOptions options;
+    ProgressiveOptions progressive;
+    OutputOptions outputs;
+    DistributedMode distributed;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            string arg = argv[i];
+            if (arg == "--no-cache") {
+                useCache = false;
+            } else if (arg == "-o" && i + 1 < argc) {
+                output = argv[++i];
+            } else if (arg == "-t" && i + 1 < argc) {
+                options.threads = static_cast<unsigned>(stoul(argv[++i]));
+            } else if (arg == "--tile" && i + 1 < argc) {
+                options.tileSize = stoi(argv[++i]);
+            } else if (arg == "--quiet") {
+                options.progress = false;
+            } else if (arg == "--no-packets") {
+                options.packets = false;
+            } else if (arg == "--precision" && i + 1 < argc) {
+                options.precision = parsePrecision(argv[++i]);
+            } else if (arg == "--tonemap" && i + 1 < argc) {
+                outputs.toneMap = ToneMap::parse(argv[++i]);
+            } else if (arg == "--preview" && i + 1 < argc) {
+                outputs.previewPort = stoi(argv[++i]);
+            } else if (arg == "--preview-cpu" && i + 1 < argc) {
+                outputs.previewCpu = stod(argv[++i]);
+            } else if (arg == "--stats" && i + 1 < argc) {
+                outputs.stats = argv[++i];
+            } else if (arg == "--coordinator" && i + 1 < argc) {
+                distributed.coordinator = true;
+                distributed.settings.port = stoi(argv[++i]);
+            } else if (arg == "--spawn" && i + 1 < argc) {
+                distributed.settings.spawn = stoi(argv[++i]);
+            } else if (arg == "--worker-timeout" && i + 1 < argc) {
+                distributed.settings.workerTimeout = stod(argv[++i]);
+            } else if (arg == "--worker" && i + 1 < argc) {
+                distributed.worker = argv[++i];
+            } else if (arg == "--primary") {
+                primaryOnly = true;
+            } else if (arg == "--spp" && i + 1 < argc) {
+                progressive.samplesPerPixel = stoi(argv[++i]);
+            } else if (arg == "--checkpoint" && i + 1 < argc) {
+                progressive.checkpoint = argv[++i];
+            } else if (arg == "--checkpoint-interval" && i + 1 < argc) {
+                progressive.checkpointInterval = stod(argv[++i]);
+            } else if (arg == "--resume") {
+                resume = true;
+            } else if (arg == "--sampler" && i + 1 < argc) {
+                progressive.sampler = parseSamplerType(argv[++i]);
+            } else if (arg == "--adaptive" && i + 1 < argc) {
+                progressive.adaptiveThreshold = stod(argv[++i]);
+            } else if (arg == "--min-spp" && i + 1 < argc) {
+                progressive.minSamples = stoi(argv[++i]);
+            } else if (arg == "--seed" && i + 1 < argc) {
+                progressive.seed = static_cast<uint32_t>(stoul(argv[++i]));
+            } else if (arg == "-h" || arg == "--help") {
+                printUsage(argv[0]);
+                return 0;
+            } else if (sceneFile.empty() && arg[0] != '-') {
+                sceneFile = arg;
+            } else {
+                printUsage(argv[0]);
+                return 1;
+            }
+        }
+        if (sceneFile.empty() || (resume && progressive.checkpoint.empty())) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        if (distributed.coordinator && (resume || !progressive.checkpoint.empty() || !outputs.stats.empty())) {
+            throw invalid_argument("El render distribuido no admite checkpoints ni estadisticas.");
+        }
+
+        // Local workers share the threads of this machine
+        if (distributed.settings.spawn > 0) {
+            unsigned threads = options.threads > 0 ? options.threads : max(1u, thread::hardware_concurrency());
+            unsigned perWorker = max(1u, threads / static_cast<unsigned>(distributed.settings.spawn));
+            distributed.settings.command = {"/proc/self/exe", sceneFile, "-t", to_string(perWorker), "--quiet"};
+            if (!useCache) {
+                distributed.settings.command.push_back("--no-cache");
+            }
+        }
+
+        return runScene(sceneFile, useCache, output, options, primaryOnly, progressive, resume, outputs, distributed);
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+}
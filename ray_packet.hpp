@@ -0,0 +1,132 @@
+#ifndef RAY_PACKET_HPP
+#define RAY_PACKET_HPP
+
+#include "ray.hpp"
+#include "geometry/bounding_box.hpp"
+#include <cstdint>
+
+// Bundle of coherent rays in structure-of-arrays layout, so the intersection
+// routines run the same instructions over every lane (SIMD friendly loops).
+// Each lane also carries its closest hit so far.
+struct RayPacket {
+    static const int SIZE = 8;
+    using Mask = uint32_t; // Bit i set = lane i
+    static const Mask ALL = (1u << SIZE) - 1;
+
+    // Rays
+    alignas(64) double ox[SIZE];
+    alignas(64) double oy[SIZE];
+    alignas(64) double oz[SIZE];
+    alignas(64) double dx[SIZE];
+    alignas(64) double dy[SIZE];
+    alignas(64) double dz[SIZE];
+    alignas(64) double invDx[SIZE];
+    alignas(64) double invDy[SIZE];
+    alignas(64) double invDz[SIZE];
+
+    // Closest hit of every lane: t is also the current far bound of the lane
+    alignas(64) double t[SIZE];
+    alignas(64) double nx[SIZE];
+    alignas(64) double ny[SIZE];
+    alignas(64) double nz[SIZE];
+    alignas(64) int shape[SIZE];
+
+    // Error bound of the hit along the normal and the hit point, for hits of
+    // the kernels that bound their error (float_kernels.hpp). offset 0 means
+    // the point is ray(t) and has no known bound.
+    alignas(64) double offset[SIZE];
+    alignas(64) double px[SIZE];
+    alignas(64) double py[SIZE];
+    alignas(64) double pz[SIZE];
+
+    Mask active; // Lanes holding a ray
+    double time; // Shared by every lane (Ray::time)
+
+    RayPacket() : active(0), time(0.0) {}
+
+    // Stores a ray in a lane and marks it active. The rays of a packet must
+    // have the same time, which the packet takes from the last one stored.
+    void set(int lane, const Ray& ray, double tMax);
+
+    Ray ray(int lane) const;
+
+    bool hit(int lane) const { return shape[lane] >= 0; }
+
+    // True when every active ray has the same direction signs, the condition
+    // for the packet traversal to be worth it
+    bool coherent() const;
+
+    // Lanes of mask whose ray enters box within [tMin, t[lane]]
+    Mask intersectBox(const BoundingBox& box, double tMin, Mask mask, double& leadEntry) const;
+};
+
+inline void RayPacket::set(int lane, const Ray& ray, double tMax) {
+    ox[lane] = ray.o.x();
+    oy[lane] = ray.o.y();
+    oz[lane] = ray.o.z();
+    dx[lane] = ray.d.x();
+    dy[lane] = ray.d.y();
+    dz[lane] = ray.d.z();
+    invDx[lane] = 1.0 / dx[lane];
+    invDy[lane] = 1.0 / dy[lane];
+    invDz[lane] = 1.0 / dz[lane];
+    t[lane] = tMax;
+    shape[lane] = -1;
+    offset[lane] = 0.0;
+    active |= 1u << lane;
+    time = ray.time;
+}
+
+inline Ray RayPacket::ray(int lane) const {
+    return Ray(Point(ox[lane], oy[lane], oz[lane]), Direction(dx[lane], dy[lane], dz[lane]), time);
+}
+
+inline bool RayPacket::coherent() const {
+    int signs = -1;
+    for (int i = 0; i < SIZE; ++i) {
+        if (!(active & (1u << i))) {
+            continue;
+        }
+        int s = (dx[i] < 0) | ((dy[i] < 0) << 1) | ((dz[i] < 0) << 2);
+        if (signs >= 0 && s != signs) {
+            return false;
+        }
+        signs = s;
+    }
+    return true;
+}
+
+inline RayPacket::Mask RayPacket::intersectBox(const BoundingBox& box, double tMin, Mask mask, double& leadEntry) const {
+    double entry[SIZE];
+    Mask result = 0;
+    for (int i = 0; i < SIZE; ++i) {
+        double tx0 = (box.min.x() - ox[i]) * invDx[i], tx1 = (box.max.x() - ox[i]) * invDx[i];
+        double ty0 = (box.min.y() - oy[i]) * invDy[i], ty1 = (box.max.y() - oy[i]) * invDy[i];
+        double tz0 = (box.min.z() - oz[i]) * invDz[i], tz1 = (box.max.z() - oz[i]) * invDz[i];
+        double tNear = tx0 < tx1 ? tx0 : tx1;
+        double tFar = tx0 < tx1 ? tx1 : tx0;
+        double yNear = ty0 < ty1 ? ty0 : ty1, yFar = ty0 < ty1 ? ty1 : ty0;
+        double zNear = tz0 < tz1 ? tz0 : tz1, zFar = tz0 < tz1 ? tz1 : tz0;
+        tNear = yNear > tNear ? yNear : tNear;
+        tNear = zNear > tNear ? zNear : tNear;
+        tNear = tMin > tNear ? tMin : tNear;
+        tFar = yFar < tFar ? yFar : tFar;
+        tFar = zFar < tFar ? zFar : tFar;
+        tFar = t[i] < tFar ? t[i] : tFar;
+        entry[i] = tNear;
+        result |= static_cast<Mask>(tNear <= tFar) << i;
+    }
+    result &= mask;
+
+    // Entry distance of the first lane, used to order the traversal
+    leadEntry = 0;
+    for (int i = 0; i < SIZE; ++i) {
+        if (result & (1u << i)) {
+            leadEntry = entry[i];
+            break;
+        }
+    }
+    return result;
+}
+
+#endif // RAY_PACKET_HPP
@@ -0,0 +1,156 @@
+#include "accumulator.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <fstream>
+#include <stdexcept>
+
+using namespace std;
+
+namespace {
+
+const char CHECKPOINT_MAGIC[8] = { 'I', 'N', 'F', 'G', 'R', 'A', 'C', 'C' };
+const uint32_t CHECKPOINT_VERSION = 2;
+// Written as is: reads back differently on a machine with another byte order
+const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+const uint64_t FNV_OFFSET = 1469598103934665603ull;
+const uint64_t FNV_PRIME = 1099511628211ull;
+
+uint64_t fnv1a(const char* data, size_t size, uint64_t hash) {
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+struct CheckpointHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint64_t fingerprint;
+    int32_t width;
+    int32_t height;
+    int32_t passes;
+    int32_t reserved;
+};
+
+} // namespace
+
+Accumulator::Accumulator(int width_, int height_)
+    : width(width_), height(height_), passes(0),
+      sum(3 * static_cast<size_t>(width_) * height_, 0.0f),
+      count(static_cast<size_t>(width_) * height_, 0),
+      m2(static_cast<size_t>(width_) * height_, 0.0f) {}
+
+double Accumulator::relativeError(int x, int y, double minLuminance) const {
+    size_t i = static_cast<size_t>(y) * width + x;
+    if (count[i] < 2) {
+        return numeric_limits<double>::infinity();
+    }
+    const float* p = &sum[3 * i];
+    double mean = luminance(PixelRGB(p[0], p[1], p[2])) / count[i];
+    double variance = m2[i] / (count[i] - 1.0);
+    return sqrt(max(0.0, variance) / count[i]) / max(mean, minLuminance);
+}
+
+double Accumulator::averageSamples() const {
+    uint64_t total = 0;
+    for (uint32_t n : count) {
+        total += n;
+    }
+    return count.empty() ? 0.0 : static_cast<double>(total) / count.size();
+}
+
+Image Accumulator::average() const {
+    Image image(width, height);
+    for (int i = 0; i < height; ++i) {
+        for (int j = 0; j < width; ++j) {
+            image.imagen[i][j] = mean(j, i);
+        }
+    }
+    return image;
+}
+
+void Accumulator::saveCheckpoint(const std::string& filename, uint64_t fingerprint) const {
+    CheckpointHeader header;
+    memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+    header.version = CHECKPOINT_VERSION;
+    header.byteOrder = BYTE_ORDER_MARK;
+    header.fingerprint = fingerprint;
+    header.width = width;
+    header.height = height;
+    header.passes = passes;
+    header.reserved = 0;
+
+    const string tmpFile = filename + ".tmp";
+    {
+        ofstream out(tmpFile, ios::binary);
+        if (!out) {
+            throw runtime_error("Cannot open file for writing: " + tmpFile);
+        }
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(sum.data()), sum.size() * sizeof(float));
+        out.write(reinterpret_cast<const char*>(count.data()), count.size() * sizeof(uint32_t));
+        out.write(reinterpret_cast<const char*>(m2.data()), m2.size() * sizeof(float));
+        out.flush();
+        if (!out) {
+            throw runtime_error("Error writing checkpoint: " + tmpFile);
+        }
+    }
+    if (rename(tmpFile.c_str(), filename.c_str()) != 0) {
+        remove(tmpFile.c_str());
+        throw runtime_error("Cannot write checkpoint: " + filename);
+    }
+}
+
+Accumulator Accumulator::loadCheckpoint(const std::string& filename, uint64_t fingerprint) {
+    ifstream in(filename, ios::binary);
+    if (!in) {
+        throw runtime_error("Cannot open checkpoint: " + filename);
+    }
+
+    CheckpointHeader header;
+    in.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!in || memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic)) != 0) {
+        throw runtime_error("Not a render checkpoint: " + filename);
+    }
+    if (header.version != CHECKPOINT_VERSION || header.byteOrder != BYTE_ORDER_MARK) {
+        throw runtime_error("Checkpoint written by an incompatible version or machine: " + filename);
+    }
+    if (header.fingerprint != fingerprint) {
+        throw runtime_error("Checkpoint belongs to another scene or resolution: " + filename);
+    }
+    if (header.width <= 0 || header.height <= 0 || header.passes < 0) {
+        throw runtime_error("Corrupted checkpoint: " + filename);
+    }
+
+    Accumulator acc(header.width, header.height);
+    acc.passes = header.passes;
+    in.read(reinterpret_cast<char*>(acc.sum.data()), acc.sum.size() * sizeof(float));
+    in.read(reinterpret_cast<char*>(acc.count.data()), acc.count.size() * sizeof(uint32_t));
+    in.read(reinterpret_cast<char*>(acc.m2.data()), acc.m2.size() * sizeof(float));
+    if (!in) {
+        throw runtime_error("Checkpoint is truncated: " + filename);
+    }
+    return acc;
+}
+
+uint64_t renderFingerprint(const std::string& sceneFile, int width, int height, uint64_t salt) {
+    ifstream in(sceneFile, ios::binary);
+    if (!in) {
+        throw runtime_error("Cannot open scene file: " + sceneFile);
+    }
+
+    uint64_t hash = FNV_OFFSET;
+    char buffer[1 << 16];
+    while (in.read(buffer, sizeof(buffer)) || in.gcount() > 0) {
+        hash = fnv1a(buffer, static_cast<size_t>(in.gcount()), hash);
+    }
+    int32_t resolution[2] = { width, height };
+    hash = fnv1a(reinterpret_cast<const char*>(resolution), sizeof(resolution), hash);
+    return fnv1a(reinterpret_cast<const char*>(&salt), sizeof(salt), hash);
+}
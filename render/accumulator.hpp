@@ -0,0 +1,76 @@
+#ifndef ACCUMULATOR_HPP
+#define ACCUMULATOR_HPP
+
+#include "../imaging/image.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Luminance of a linear RGB value (Rec. 709 weights)
+inline double luminance(const PixelRGB& c) {
+    return 0.2126 * c.R + 0.7152 * c.G + 0.0722 * c.B;
+}
+
+// Progressive HDR buffer: per pixel float RGB sums of every sample taken so
+// far, the sample count and the running variance of the luminance (Welford).
+// Tiles write disjoint pixels, so no synchronisation is needed.
+class Accumulator {
+    public:
+        int width;
+        int height;
+        int passes;                  // Passes completed so far
+        std::vector<float> sum;      // 3 floats (RGB) per pixel, row major
+        std::vector<uint32_t> count; // Samples of every pixel
+        std::vector<float> m2;       // Sum of squared deviations of the luminance
+
+        Accumulator(int width_, int height_);
+
+        // Merges a batch of n samples of pixel (x, y): their RGB sum and the
+        // mean and M2 of their luminance (Chan et al. parallel update)
+        void addBatch(int x, int y, const PixelRGB& batchSum, uint32_t n, double batchMean, double batchM2) {
+            size_t i = static_cast<size_t>(y) * width + x;
+            float* p = &sum[3 * i];
+            double mean = count[i] > 0 ? luminance(PixelRGB(p[0], p[1], p[2])) / count[i] : 0.0;
+            double total = static_cast<double>(count[i]) + n;
+            double delta = batchMean - mean;
+            m2[i] += static_cast<float>(batchM2 + delta * delta * count[i] * n / total);
+
+            p[0] += static_cast<float>(batchSum.R);
+            p[1] += static_cast<float>(batchSum.G);
+            p[2] += static_cast<float>(batchSum.B);
+            count[i] += n;
+        }
+
+        // Standard error of the mean luminance relative to the luminance itself
+        // (floored at minLuminance for dark pixels). Infinite below 2 samples.
+        double relativeError(int x, int y, double minLuminance) const;
+
+        // Mean samples per pixel
+        double averageSamples() const;
+
+        // Current estimate of pixel (x, y) (sum divided by the sample count)
+        PixelRGB mean(int x, int y) const {
+            size_t i = static_cast<size_t>(y) * width + x;
+            const float* p = &sum[3 * i];
+            double scale = count[i] > 0 ? 1.0 / count[i] : 0.0;
+            return PixelRGB(p[0] * scale, p[1] * scale, p[2] * scale);
+        }
+
+        // Current estimate of every pixel
+        Image average() const;
+
+        // Checkpoints carry a fingerprint of the scene they belong to, so a
+        // render is never resumed with a different scene or resolution.
+        // The file is replaced atomically.
+        void saveCheckpoint(const std::string& filename, uint64_t fingerprint) const;
+
+        // Throws if the file is unreadable or belongs to another scene
+        static Accumulator loadCheckpoint(const std::string& filename, uint64_t fingerprint);
+};
+
+// FNV-1a hash of a file's contents combined with a resolution and any other
+// setting that changes the samples (salt), used as the checkpoint
+// fingerprint (content based, so it holds across machines)
+uint64_t renderFingerprint(const std::string& sceneFile, int width, int height, uint64_t salt = 0);
+
+#endif // ACCUMULATOR_HPP
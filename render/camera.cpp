@@ -0,0 +1,34 @@
+#include "camera.hpp"
+#include <cmath>
+#include <stdexcept>
+
+using namespace std;
+
+Camera::Camera(const CameraSettings& settings, int width_, int height_)
+    : position(settings.position), width(width_), height(height_)
+{
+    if (width <= 0 || height <= 0) {
+        throw invalid_argument("La resolucion de la camara debe ser positiva.");
+    }
+
+    forward = (settings.lookAt - settings.position).normalized();
+    Direction rightDir = settings.up.cross(forward);
+    if (rightDir.norm() < 1e-12) {
+        throw invalid_argument("El vector 'up' de la camara es paralelo a la direccion de vision.");
+    }
+    rightDir = rightDir.normalized();
+    Direction upDir = forward.cross(rightDir);
+
+    double halfHeight = tan(settings.fov * M_PI / 360.0);
+    double halfWidth = halfHeight * width / height;
+    right = rightDir * halfWidth;
+    up = upDir * halfHeight;
+}
+
+Ray Camera::generateRay(double px, double py, double time) const {
+    // Map to [-1, 1] with +y pointing up
+    double sx = 2.0 * px / width - 1.0;
+    double sy = 1.0 - 2.0 * py / height;
+    Direction d = forward + right * sx + up * sy;
+    return Ray(position, d.normalized(), time);
+}
@@ -0,0 +1,26 @@
+#ifndef CAMERA_HPP
+#define CAMERA_HPP
+
+#include "../geometry/geometry.hpp"
+#include "../scene/scene.hpp"
+#include "../ray.hpp"
+
+// Pinhole camera. Image coordinates are in pixels, (0, 0) being the top left
+// corner of the image and (width, height) the bottom right one.
+class Camera {
+    public:
+        Point position;
+        Direction forward; // Unit view direction
+        Direction right;   // Half width of the image plane at distance 1
+        Direction up;      // Half height of the image plane at distance 1
+        int width;
+        int height;
+
+        Camera(const CameraSettings& settings, int width_, int height_);
+
+        // Normalized primary ray through the image point (px, py) at the
+        // given time of the exposure
+        Ray generateRay(double px, double py, double time = 0.0) const;
+};
+
+#endif // CAMERA_HPP
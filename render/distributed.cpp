@@ -0,0 +1,735 @@
+#include "distributed.hpp"
+#include "accumulator.hpp"
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <spawn.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <deque>
+#include <fcntl.h>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <unistd.h>
+
+extern char** environ;
+
+using namespace std;
+
+namespace {
+
+const uint32_t PROTOCOL_MAGIC = 0x57524749; // "IGRW"
+const uint32_t PROTOCOL_VERSION = 1;
+
+// Every message is a MessageHeader followed by bytes of payload
+enum MessageType : uint32_t {
+    HELLO = 1,  // Worker -> coordinator: Hello
+    JOB,        // Coordinator -> worker: Job
+    ASSIGN,     // Coordinator -> worker: int32 tile indices
+    RESULT,     // Worker -> coordinator: int32 tile index, float RGB per pixel
+    BATCH_DONE, // Worker -> coordinator: BatchDone, every tile of the batch was sent
+    STOP        // Coordinator -> worker: the frame is complete
+};
+
+struct MessageHeader {
+    uint32_t type;
+    uint32_t bytes;
+};
+
+struct Hello {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t threads;
+};
+
+// Everything that changes the samples of a tile
+struct Job {
+    uint64_t fingerprint; // renderFingerprint of the scene file and resolution
+    int32_t width, height, tileSize;
+    int32_t primaryOnly, packets, precision;
+    int32_t samplesPerPixel, minSamples, adaptiveBatch;
+    uint32_t sampler, seed;
+    double adaptiveThreshold;
+};
+
+struct BatchDone {
+    uint64_t primaryRays, shadowRays, secondaryRays;
+};
+
+// Batches hold this many tiles per worker thread, so the scheduler of the
+// worker can balance them while the next batch is on its way
+const int TILES_PER_THREAD = 2;
+
+// Longest wait of the coordinator loop for a message
+const int POLL_MILLISECONDS = 100;
+
+using Clock = chrono::steady_clock;
+
+bool sendAll(int socket, const void* data, size_t bytes) {
+    const char* p = static_cast<const char*>(data);
+    while (bytes > 0) {
+        ssize_t n = send(socket, p, bytes, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        bytes -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool receiveAll(int socket, void* data, size_t bytes) {
+    char* p = static_cast<char*>(data);
+    while (bytes > 0) {
+        ssize_t n = recv(socket, p, bytes, 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        bytes -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// Header and payload in a single write, so messages from several threads
+// never interleave as long as the caller serialises the calls
+bool sendMessage(int socket, uint32_t type, const void* payload, size_t bytes) {
+    MessageHeader header{type, static_cast<uint32_t>(bytes)};
+    const char* head = reinterpret_cast<const char*>(&header);
+    const char* body = static_cast<const char*>(payload);
+    vector<char> message;
+    message.reserve(sizeof(header) + bytes);
+    message.insert(message.end(), head, head + sizeof(header));
+    message.insert(message.end(), body, body + bytes);
+    return sendAll(socket, message.data(), message.size());
+}
+
+int connectTo(const string& address) {
+    size_t colon = address.rfind(':');
+    if (colon == string::npos || colon == 0 || colon + 1 == address.size()) {
+        throw invalid_argument("Direccion del coordinador no valida '" + address + "' (host:puerto).");
+    }
+    string host = address.substr(0, colon), port = address.substr(colon + 1);
+
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* found = nullptr;
+    int error = getaddrinfo(host.c_str(), port.c_str(), &hints, &found);
+    if (error != 0) {
+        throw runtime_error("No se pudo resolver '" + address + "': " + gai_strerror(error));
+    }
+
+    // The coordinator may still be starting: retry for a few seconds
+    int socketFd = -1;
+    for (int attempt = 0; attempt < 20 && socketFd < 0; ++attempt) {
+        if (attempt > 0) {
+            this_thread::sleep_for(chrono::milliseconds(500));
+        }
+        for (addrinfo* a = found; a && socketFd < 0; a = a->ai_next) {
+            socketFd = socket(a->ai_family, a->ai_socktype | SOCK_CLOEXEC, a->ai_protocol);
+            if (socketFd >= 0 && connect(socketFd, a->ai_addr, a->ai_addrlen) < 0) {
+                close(socketFd);
+                socketFd = -1;
+            }
+        }
+    }
+    freeaddrinfo(found);
+    if (socketFd < 0) {
+        throw runtime_error("No se pudo conectar con el coordinador en " + address + ".");
+    }
+    int yes = 1;
+    setsockopt(socketFd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+    return socketFd;
+}
+
+// Closes the socket however the function that owns it ends
+struct SocketGuard {
+    int fd;
+    ~SocketGuard() {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Coordinator
+// ---------------------------------------------------------------------------
+
+struct Worker {
+    int socket;
+    int id;
+    bool ready = false;        // Hello received and job sent
+    unsigned threads = 1;
+    string input;              // Bytes received and not parsed yet
+    vector<int> batch;         // Tiles in flight, empty when idle
+    Clock::time_point assigned;
+    Clock::time_point lastHeard;
+};
+
+class Coordinator {
+    public:
+        Coordinator(const string& sceneFile, const Camera& camera_, const RenderOptions& options_,
+                    const ProgressiveOptions& progressive, bool primaryOnly,
+                    const CoordinatorOptions& settings_, RenderStats& stats_)
+            : camera(camera_), options(options_), settings(settings_), stats(stats_),
+              tiles(makeTiles(camera_.width, camera_.height, options_.tileSize)),
+              image(camera_.width, camera_.height), done(tiles.size(), 0), triedBy(tiles.size()),
+              inFlightSince(tiles.size()), completed(0), nextId(1), batchSeconds(0.0), batches(0),
+              listener(-1) {
+            job = Job{};
+            job.fingerprint = renderFingerprint(sceneFile, camera.width, camera.height);
+            job.width = camera.width;
+            job.height = camera.height;
+            job.tileSize = max(1, options.tileSize); // makeTiles clamps it the same way
+            job.primaryOnly = primaryOnly;
+            job.packets = options.packets;
+            job.precision = static_cast<int32_t>(options.precision);
+            job.samplesPerPixel = progressive.samplesPerPixel;
+            job.minSamples = progressive.minSamples;
+            job.adaptiveBatch = progressive.adaptiveBatch;
+            job.sampler = static_cast<uint32_t>(progressive.sampler);
+            job.seed = progressive.seed;
+            job.adaptiveThreshold = progressive.adaptiveThreshold;
+
+            for (const Tile& tile : tiles) {
+                pending.push_back(tile.index);
+            }
+        }
+
+        ~Coordinator() {
+            for (const Worker& worker : workers) {
+                close(worker.socket);
+            }
+            if (listener >= 0) {
+                close(listener);
+            }
+            // Spawned workers still running at this point are stopped
+            for (pid_t child : children) {
+                kill(child, SIGTERM);
+                waitpid(child, nullptr, 0);
+            }
+        }
+
+        Image run();
+
+    private:
+        const Camera& camera;
+        const RenderOptions& options;
+        const CoordinatorOptions& settings;
+        RenderStats& stats;
+        Job job;
+
+        vector<Tile> tiles;
+        Image image;
+        vector<char> done;
+        vector<vector<int>> triedBy;                // Per tile: workers it was assigned to
+        vector<Clock::time_point> inFlightSince;    // Per tile: last assignment
+        deque<int> pending;                         // Tiles nobody is rendering
+        int completed;
+
+        vector<Worker> workers;
+        int nextId;
+        double batchSeconds;                        // Sum of the durations of the finished batches
+        int batches;
+
+        int listener;
+        vector<pid_t> children;                     // Spawned workers still running
+
+        void listen();
+        void spawnWorkers();
+        void acceptWorkers();
+        void exchange();           // One poll round: new workers, their messages, timeouts
+        bool receive(Worker& worker);
+        bool handle(Worker& worker, uint32_t type, const char* payload, uint32_t bytes);
+        void assign(Worker& worker);
+        void drop(size_t index, const string& reason);
+        void reapChildren();
+        void reportProgress(Clock::time_point start, bool last);
+};
+
+void Coordinator::listen() {
+    listener = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listener < 0) {
+        throw runtime_error("No se pudo crear el socket del coordinador: " + string(strerror(errno)));
+    }
+    int yes = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(static_cast<uint16_t>(settings.port));
+    socklen_t length = sizeof(address);
+    if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 ||
+        ::listen(listener, 64) < 0 ||
+        getsockname(listener, reinterpret_cast<sockaddr*>(&address), &length) < 0) {
+        throw runtime_error("No se pudo abrir el puerto " + to_string(settings.port) + " del coordinador: " +
+                            strerror(errno));
+    }
+    fcntl(listener, F_SETFL, fcntl(listener, F_GETFL) | O_NONBLOCK);
+    cout << "Coordinador escuchando en el puerto " << ntohs(address.sin_port) << ": "
+         << tiles.size() << " tiles." << endl;
+}
+
+void Coordinator::spawnWorkers() {
+    if (settings.spawn <= 0) {
+        return;
+    }
+    if (settings.command.empty()) {
+        throw invalid_argument("No hay orden para lanzar los trabajadores.");
+    }
+    sockaddr_in address{};
+    socklen_t length = sizeof(address);
+    getsockname(listener, reinterpret_cast<sockaddr*>(&address), &length);
+
+    vector<string> arguments = settings.command;
+    arguments.push_back("--worker");
+    arguments.push_back("127.0.0.1:" + to_string(ntohs(address.sin_port)));
+    vector<char*> argv;
+    for (string& argument : arguments) {
+        argv.push_back(&argument[0]);
+    }
+    argv.push_back(nullptr);
+
+    for (int i = 0; i < settings.spawn; ++i) {
+        pid_t child;
+        int error = posix_spawn(&child, argv[0], nullptr, nullptr, argv.data(), environ);
+        if (error != 0) {
+            throw runtime_error("No se pudo lanzar el trabajador '" + arguments[0] + "': " + strerror(error));
+        }
+        children.push_back(child);
+    }
+}
+
+void Coordinator::acceptWorkers() {
+    while (true) {
+        int socketFd = accept4(listener, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK);
+        if (socketFd < 0) {
+            return;
+        }
+        int yes = 1;
+        setsockopt(socketFd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+        Worker worker;
+        worker.socket = socketFd;
+        worker.id = nextId++;
+        worker.lastHeard = Clock::now();
+        workers.push_back(move(worker));
+    }
+}
+
+// Reads what the worker sent and handles every complete message; false once
+// the worker has to be dropped
+bool Coordinator::receive(Worker& worker) {
+    char buffer[1 << 16];
+    while (true) {
+        ssize_t n = recv(worker.socket, buffer, sizeof(buffer), 0);
+        if (n > 0) {
+            worker.input.append(buffer, static_cast<size_t>(n));
+            continue;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        return false; // Closed or failed
+    }
+
+    // Largest message a worker sends: its hello, a batch report or a tile
+    const size_t maxPayload = max({ sizeof(Hello), sizeof(BatchDone),
+                                    sizeof(int32_t) + static_cast<size_t>(job.tileSize) * job.tileSize * 3 * sizeof(float) });
+    size_t offset = 0;
+    while (worker.input.size() - offset >= sizeof(MessageHeader)) {
+        MessageHeader header;
+        memcpy(&header, worker.input.data() + offset, sizeof(header));
+        if (header.bytes > maxPayload) {
+            return false;
+        }
+        if (worker.input.size() - offset - sizeof(header) < header.bytes) {
+            break;
+        }
+        if (!handle(worker, header.type, worker.input.data() + offset + sizeof(header), header.bytes)) {
+            return false;
+        }
+        offset += sizeof(header) + header.bytes;
+    }
+    worker.input.erase(0, offset);
+    return true;
+}
+
+bool Coordinator::handle(Worker& worker, uint32_t type, const char* payload, uint32_t bytes) {
+    worker.lastHeard = Clock::now();
+    if (!worker.ready) {
+        Hello hello;
+        if (type != HELLO || bytes != sizeof(hello)) {
+            return false;
+        }
+        memcpy(&hello, payload, sizeof(hello));
+        if (hello.magic != PROTOCOL_MAGIC || hello.version != PROTOCOL_VERSION) {
+            return false;
+        }
+        worker.threads = max(1u, hello.threads);
+        worker.ready = sendMessage(worker.socket, JOB, &job, sizeof(job));
+        return worker.ready;
+    }
+
+    if (type == RESULT) {
+        int32_t index;
+        if (bytes < sizeof(index)) {
+            return false;
+        }
+        memcpy(&index, payload, sizeof(index));
+        if (index < 0 || index >= static_cast<int>(tiles.size())) {
+            return false;
+        }
+        const Tile& tile = tiles[index];
+        if (bytes != sizeof(index) + static_cast<size_t>(tile.pixels()) * 3 * sizeof(float)) {
+            return false;
+        }
+        if (done[index]) {
+            return true; // A faster copy already arrived
+        }
+
+        // The copy keeps the floats aligned whatever the offset in the stream
+        vector<float> rgb(static_cast<size_t>(tile.pixels()) * 3);
+        memcpy(rgb.data(), payload + sizeof(index), rgb.size() * sizeof(float));
+        vector<PixelRGB> pixels(tile.pixels());
+        for (int i = 0; i < tile.pixels(); ++i) {
+            pixels[i] = PixelRGB(rgb[3 * i], rgb[3 * i + 1], rgb[3 * i + 2]);
+        }
+        for (int y = tile.y0; y < tile.y1; ++y) {
+            copy_n(pixels.data() + (y - tile.y0) * tile.width(), tile.width(), image.imagen[y] + tile.x0);
+        }
+        done[index] = 1;
+        completed++;
+        if (options.update) {
+            options.update(tile, pixels.data());
+        }
+        if (options.sink) {
+            options.sink(tile, pixels.data());
+        }
+        return true;
+    }
+
+    if (type == BATCH_DONE) {
+        BatchDone batch;
+        if (bytes != sizeof(batch) || worker.batch.empty()) {
+            return false;
+        }
+        memcpy(&batch, payload, sizeof(batch));
+        stats.primaryRays += batch.primaryRays;
+        stats.shadowRays += batch.shadowRays;
+        stats.secondaryRays += batch.secondaryRays;
+
+        // A batch counts as done only if its tiles really came back
+        for (int index : worker.batch) {
+            if (!done[index]) {
+                return false;
+            }
+        }
+        batchSeconds += chrono::duration<double>(Clock::now() - worker.assigned).count();
+        batches++;
+        worker.batch.clear();
+        return true;
+    }
+    return false;
+}
+
+void Coordinator::assign(Worker& worker) {
+    const size_t batchSize = static_cast<size_t>(TILES_PER_THREAD) * worker.threads;
+    vector<int> batch;
+    while (!pending.empty() && batch.size() < batchSize) {
+        int index = pending.front();
+        pending.pop_front();
+        if (!done[index]) {
+            batch.push_back(index);
+        }
+    }
+
+    // Nothing new left: repeat the tiles other workers have held for more than
+    // twice the usual batch time, the oldest first
+    auto now = Clock::now();
+    if (batch.empty() && batches > 0) {
+        const double slow = 2.0 * batchSeconds / batches;
+        vector<int> late;
+        for (const Worker& other : workers) {
+            for (int index : other.batch) {
+                if (!done[index] && chrono::duration<double>(now - inFlightSince[index]).count() > slow &&
+                    find(triedBy[index].begin(), triedBy[index].end(), worker.id) == triedBy[index].end() &&
+                    find(late.begin(), late.end(), index) == late.end()) {
+                    late.push_back(index);
+                }
+            }
+        }
+        sort(late.begin(), late.end(), [this](int a, int b) { return inFlightSince[a] < inFlightSince[b]; });
+        late.resize(min(late.size(), batchSize));
+        batch = move(late);
+    }
+    if (batch.empty()) {
+        return;
+    }
+
+    if (!sendMessage(worker.socket, ASSIGN, batch.data(), batch.size() * sizeof(int32_t))) {
+        pending.insert(pending.begin(), batch.begin(), batch.end());
+        return; // The failed socket is noticed when it is read
+    }
+    for (int index : batch) {
+        triedBy[index].push_back(worker.id);
+        inFlightSince[index] = now;
+    }
+    worker.batch = move(batch);
+    worker.assigned = now;
+    worker.lastHeard = now;
+}
+
+void Coordinator::drop(size_t index, const string& reason) {
+    Worker worker = move(workers[index]);
+    workers.erase(workers.begin() + index);
+    close(worker.socket);
+
+    // Tiles another worker is also rendering stay with it
+    int returned = 0;
+    for (int tile : worker.batch) {
+        bool elsewhere = false;
+        for (const Worker& other : workers) {
+            elsewhere = elsewhere || find(other.batch.begin(), other.batch.end(), tile) != other.batch.end();
+        }
+        if (!done[tile] && !elsewhere) {
+            pending.push_front(tile);
+            returned++;
+        }
+    }
+    if (worker.ready) {
+        if (options.progress) {
+            cerr << endl;
+        }
+        cout << "Trabajador " << worker.id << " " << reason << "; " << returned << " tiles se reasignan." << endl;
+    }
+}
+
+void Coordinator::reapChildren() {
+    for (size_t i = 0; i < children.size();) {
+        int status;
+        if (waitpid(children[i], &status, WNOHANG) == children[i]) {
+            children.erase(children.begin() + i);
+        } else {
+            ++i;
+        }
+    }
+}
+
+void Coordinator::reportProgress(Clock::time_point start, bool last) {
+    double seconds = chrono::duration<double>(Clock::now() - start).count();
+    cerr << "\rProgreso: " << fixed << setprecision(1) << 100.0 * completed / tiles.size() << "% ("
+         << completed << "/" << tiles.size() << " tiles), " << workers.size() << " trabajadores, "
+         << (seconds > 0 ? stats.totalRays() / seconds / 1e6 : 0.0) << " Mrayos/s" << defaultfloat << flush;
+    if (last) {
+        cerr << endl;
+    }
+}
+
+void Coordinator::exchange() {
+    vector<pollfd> fds;
+    fds.push_back({listener, POLLIN, 0});
+    for (const Worker& worker : workers) {
+        fds.push_back({worker.socket, POLLIN, 0});
+    }
+    if (poll(fds.data(), fds.size(), POLL_MILLISECONDS) < 0 && errno != EINTR) {
+        throw runtime_error("Error esperando a los trabajadores: " + string(strerror(errno)));
+    }
+
+    // Workers accepted now are polled in the next round
+    const size_t polled = fds.size() - 1;
+    if (fds[0].revents & POLLIN) {
+        acceptWorkers();
+    }
+    for (size_t i = polled; i-- > 0;) {
+        if (fds[i + 1].revents && !receive(workers[i])) {
+            drop(i, "desconectado");
+        }
+    }
+
+    auto now = Clock::now();
+    for (size_t i = workers.size(); i-- > 0;) {
+        if (settings.workerTimeout > 0 && !workers[i].batch.empty() &&
+            chrono::duration<double>(now - workers[i].lastHeard).count() > settings.workerTimeout) {
+            drop(i, "sin respuesta");
+        }
+    }
+}
+
+Image Coordinator::run() {
+    auto start = Clock::now();
+    listen();
+    spawnWorkers();
+
+    auto lastReport = start;
+    while (completed < static_cast<int>(tiles.size())) {
+        exchange();
+        for (Worker& worker : workers) {
+            if (worker.ready && worker.batch.empty()) {
+                assign(worker);
+            }
+        }
+
+        reapChildren();
+        if (settings.spawn > 0 && children.empty() && workers.empty()) {
+            throw runtime_error("Los trabajadores han terminado sin completar el render.");
+        }
+        auto now = Clock::now();
+        if (options.progress && chrono::duration<double>(now - lastReport).count() >= 0.5) {
+            reportProgress(start, false);
+            lastReport = now;
+        }
+    }
+    stats.seconds += chrono::duration<double>(Clock::now() - start).count();
+    if (options.progress) {
+        reportProgress(start, true);
+    }
+
+    // The ray counts of a batch arrive after its tiles: wait a little for the
+    // last ones (repeated batches still running are not worth waiting for)
+    auto busy = [this] {
+        return any_of(workers.begin(), workers.end(), [](const Worker& worker) { return !worker.batch.empty(); });
+    };
+    const double grace = max(1.0, batches > 0 ? 2.0 * batchSeconds / batches : 0.0);
+    const auto deadline = Clock::now() + chrono::duration_cast<Clock::duration>(chrono::duration<double>(grace));
+    while (busy() && Clock::now() < deadline) {
+        exchange();
+    }
+
+    for (const Worker& worker : workers) {
+        if (worker.ready) {
+            sendMessage(worker.socket, STOP, nullptr, 0);
+        }
+        close(worker.socket);
+    }
+    workers.clear();
+
+    // Spawned workers exit on STOP or once their socket closes; the ones
+    // still busy after a while are stopped by the destructor
+    for (int wait = 0; wait < 50 && !children.empty(); ++wait) {
+        this_thread::sleep_for(chrono::milliseconds(POLL_MILLISECONDS));
+        reapChildren();
+    }
+    return move(image);
+}
+
+} // namespace
+
+Image renderDistributed(const std::string& sceneFile, const Camera& camera, const RenderOptions& options,
+                        const ProgressiveOptions& progressive, bool primaryOnly,
+                        const CoordinatorOptions& coordinator, RenderStats& stats) {
+    Coordinator server(sceneFile, camera, options, progressive, primaryOnly, coordinator, stats);
+    return server.run();
+}
+
+// ---------------------------------------------------------------------------
+// Worker
+// ---------------------------------------------------------------------------
+
+void runWorker(Scene& scene, const std::string& sceneFile, const Camera& camera,
+               const std::string& address, const RenderOptions& options, RenderStats& stats) {
+    SocketGuard connection{connectTo(address)};
+    TileScheduler scheduler(options.threads);
+
+    Hello hello{PROTOCOL_MAGIC, PROTOCOL_VERSION, scheduler.threadCount()};
+    MessageHeader header;
+    Job job;
+    if (!sendMessage(connection.fd, HELLO, &hello, sizeof(hello)) ||
+        !receiveAll(connection.fd, &header, sizeof(header)) || header.type != JOB || header.bytes != sizeof(job) ||
+        !receiveAll(connection.fd, &job, sizeof(job))) {
+        throw runtime_error("El coordinador en " + address + " no ha aceptado al trabajador.");
+    }
+    if (job.width != camera.width || job.height != camera.height ||
+        job.fingerprint != renderFingerprint(sceneFile, camera.width, camera.height)) {
+        throw runtime_error("La escena '" + sceneFile + "' no es la del coordinador.");
+    }
+
+    RenderOptions local;
+    local.tileSize = job.tileSize;
+    local.progress = false;
+    local.packets = job.packets != 0;
+    local.precision = static_cast<PrimitiveStore::Precision>(job.precision);
+    scene.primitives.precision = local.precision;
+
+    ProgressiveOptions progressive;
+    progressive.samplesPerPixel = job.samplesPerPixel;
+    progressive.minSamples = job.minSamples;
+    progressive.adaptiveBatch = job.adaptiveBatch;
+    progressive.sampler = static_cast<SamplerType>(job.sampler);
+    progressive.seed = job.seed;
+    progressive.adaptiveThreshold = job.adaptiveThreshold;
+
+    // Tiles are sent from the render threads as they become final
+    mutex sending;
+    local.sink = [&](const Tile& tile, const PixelRGB* pixels) {
+        vector<char> payload(sizeof(int32_t) + static_cast<size_t>(tile.pixels()) * 3 * sizeof(float));
+        int32_t index = tile.index;
+        memcpy(payload.data(), &index, sizeof(index));
+        float* rgb = reinterpret_cast<float*>(payload.data() + sizeof(index));
+        for (int i = 0; i < tile.pixels(); ++i) {
+            rgb[3 * i] = static_cast<float>(pixels[i].R);
+            rgb[3 * i + 1] = static_cast<float>(pixels[i].G);
+            rgb[3 * i + 2] = static_cast<float>(pixels[i].B);
+        }
+        lock_guard<mutex> lock(sending);
+        if (!sendMessage(connection.fd, RESULT, payload.data(), payload.size())) {
+            throw runtime_error("Conexion con el coordinador perdida.");
+        }
+    };
+
+    // The accumulator outlives the batches: a worker never gets a tile twice
+    Accumulator acc(job.primaryOnly ? 0 : camera.width, job.primaryOnly ? 0 : camera.height);
+    int tilesRendered = 0;
+    while (true) {
+        if (!receiveAll(connection.fd, &header, sizeof(header))) {
+            throw runtime_error("Conexion con el coordinador perdida.");
+        }
+        if (header.type == STOP) {
+            break;
+        }
+        if (header.type != ASSIGN || header.bytes % sizeof(int32_t) != 0) {
+            throw runtime_error("Mensaje inesperado del coordinador.");
+        }
+        local.onlyTiles.resize(header.bytes / sizeof(int32_t));
+        if (!receiveAll(connection.fd, local.onlyTiles.data(), header.bytes)) {
+            throw runtime_error("Conexion con el coordinador perdida.");
+        }
+
+        RenderStats batch;
+        if (job.primaryOnly) {
+            renderPrimaryTiles(scene, camera, scheduler, local, batch);
+        } else {
+            renderProgressive(scene, camera, scheduler, local, progressive, acc, batch);
+        }
+        tilesRendered += static_cast<int>(local.onlyTiles.size());
+
+        BatchDone counts{batch.primaryRays, batch.shadowRays, batch.secondaryRays};
+        if (!sendMessage(connection.fd, BATCH_DONE, &counts, sizeof(counts))) {
+            throw runtime_error("Conexion con el coordinador perdida.");
+        }
+        stats.merge(batch);
+        stats.seconds += batch.seconds;
+    }
+    cout << "Trabajador: " << tilesRendered << " tiles renderizadas para " << address << "." << endl;
+}
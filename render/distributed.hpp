@@ -0,0 +1,49 @@
+#ifndef DISTRIBUTED_HPP
+#define DISTRIBUTED_HPP
+
+#include "camera.hpp"
+#include "path_tracer.hpp"
+#include "renderer.hpp"
+#include "../scene/scene.hpp"
+#include <string>
+#include <vector>
+
+// One frame rendered by several processes. The coordinator splits the image
+// in the tiles of makeTiles and hands them out in ranges; every worker loads
+// the same scene file, renders the tiles it is given with its own threads and
+// streams each one back as float RGB as soon as it is final. The coordinator
+// merges them into the image and the sinks of the options.
+// A worker that disconnects or stays silent for longer than the timeout loses
+// its tiles to the others, and once nothing is left to hand out, idle workers
+// repeat the tiles that have been pending elsewhere for more than twice the
+// usual batch time, so a slow or hung worker never holds up the frame: the
+// first copy of a tile to arrive wins.
+// Samples only depend on the pixel and sample index, so the image is the
+// same whatever worker renders each tile.
+// Messages use the byte order of the host, so every process must run on the
+// same architecture.
+
+struct CoordinatorOptions {
+    int port = 0;                      // 0 picks a free one
+    int spawn = 0;                     // Worker processes started on this host
+    std::vector<std::string> command;  // Program and arguments of a spawned worker, without --worker
+    double workerTimeout = 0.0;        // Seconds a worker with tiles may stay silent, 0 = no limit
+};
+
+// Renders the frame (path traced, or primary visibility only) on the workers
+// that connect to the coordinator port and returns the HDR image. The ray
+// counts of the workers are added to stats. Throws runtime_error if every
+// spawned worker exits and no other worker is connected.
+Image renderDistributed(const std::string& sceneFile, const Camera& camera, const RenderOptions& options,
+                        const ProgressiveOptions& progressive, bool primaryOnly,
+                        const CoordinatorOptions& coordinator, RenderStats& stats);
+
+// Connects to the coordinator at "host:port" and renders the tiles it assigns
+// until it says the frame is done. The render settings come from the
+// coordinator; only the thread count of options is used.
+// Throws runtime_error if the scene does not match the coordinator's or the
+// connection fails.
+void runWorker(Scene& scene, const std::string& sceneFile, const Camera& camera,
+               const std::string& address, const RenderOptions& options, RenderStats& stats);
+
+#endif // DISTRIBUTED_HPP
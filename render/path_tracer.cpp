@@ -0,0 +1,455 @@
+#include "path_tracer.hpp"
+#include "render_profile.hpp"
+#include "../geometry/sphere.hpp"
+#include "../geometry/triangle.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+
+using namespace std;
+
+namespace {
+
+// Depth from which Russian roulette may end a path
+const int ROULETTE_DEPTH = 3;
+
+// Shadow rays towards a sampled point stop this fraction short of it
+const double SHADOW_SHORTEN = 1e-4;
+
+// Luminance below which the adaptive error is measured in absolute terms,
+// so black pixels are not sampled forever
+const double ADAPTIVE_MIN_LUMINANCE = 0.05;
+
+struct alignas(64) PaddedStats {
+    RenderStats stats;
+};
+
+// Samples a pixel took during one pass: RGB sum and luminance statistics
+struct PixelBatch {
+    PixelRGB sum;
+    double mean = 0.0;
+    double m2 = 0.0;
+    uint32_t n = 0;
+};
+
+// Orthonormal basis (t, b) completing the unit vector n (Duff et al. 2017)
+void makeBasis(const Direction& n, Direction& t, Direction& b) {
+    double sign = copysign(1.0, n.z());
+    double a = -1.0 / (sign + n.z());
+    double c = n.x() * n.y() * a;
+    t = Direction(1.0 + sign * n.x() * n.x() * a, sign * c, -sign * n.x());
+    b = Direction(c, sign + n.y() * n.y() * a, -n.y());
+}
+
+// Direction around axis from its local spherical coordinates
+Direction aroundAxis(const Direction& axis, double cosTheta, double phi) {
+    Direction t, b;
+    makeBasis(axis, t, b);
+    double sinTheta = sqrt(max(0.0, 1.0 - cosTheta * cosTheta));
+    return t * (sinTheta * cos(phi)) + b * (sinTheta * sin(phi)) + axis * cosTheta;
+}
+
+// Cosine weighted hemisphere around n (pdf = cos / pi)
+Direction sampleCosine(const Direction& n, double u, double v) {
+    return aroundAxis(n, sqrt(1.0 - u), 2.0 * M_PI * v);
+}
+
+Direction reflect(const Direction& d, const Direction& n) {
+    return d - n * (2.0 * d.dot(n));
+}
+
+// Fresnel reflectance of an unpolarised ray between media n1 -> n2
+double fresnel(double cosI, double cosT, double n1, double n2) {
+    double rs = (n1 * cosI - n2 * cosT) / (n1 * cosI + n2 * cosT);
+    double rp = (n1 * cosT - n2 * cosI) / (n1 * cosT + n2 * cosI);
+    return 0.5 * (rs * rs + rp * rp);
+}
+
+double maxComponent(const PixelRGB& c) {
+    return max(c.R, max(c.G, c.B));
+}
+
+bool isBlack(const PixelRGB& c) {
+    return c.R <= 0 && c.G <= 0 && c.B <= 0;
+}
+
+} // namespace
+
+PathTracer::PathTracer(const Scene& scene_, int maxDepth_)
+    : scene(scene_), maxDepth(maxDepth_), sampledEmitter(scene_.shapes.size(), 0)
+{
+    for (size_t i = 0; i < scene.shapes.size(); ++i) {
+        const Material& material = scene.materials[scene.shapeMaterials[i]];
+        if (isBlack(material.emission)) {
+            continue;
+        }
+        // Other emitters (meshes, planes, boxes, quadrics...) are only found by the paths themselves
+        const GeometricShape* shape = scene.shapes[i].get();
+        if (dynamic_cast<const Sphere*>(shape) || dynamic_cast<const Triangle*>(shape)) {
+            emitters.push_back(static_cast<int>(i));
+            sampledEmitter[i] = 1;
+        }
+    }
+}
+
+PixelRGB PathTracer::radiance(Ray ray, Sampler& sampler, ShadowCache& shadows, RenderStats& stats) const {
+    PixelRGB result;
+    PixelRGB throughput(1.0, 1.0, 1.0);
+    bool afterDiffuse = false; // Emission already accounted for by next event estimation
+
+    for (int depth = 0; depth < maxDepth; ++depth) {
+        if (depth > 0) {
+            stats.secondaryRays++;
+        }
+
+        // Dimensions of this bounce: light choice, point on the light,
+        // scattering direction (or Fresnel choice) and Russian roulette
+        double lightPick = sampler.get1D();
+        double lightU, lightV, scatterU, scatterV;
+        sampler.get2D(lightU, lightV);
+        sampler.get2D(scatterU, scatterV);
+        double roulette = sampler.get1D();
+
+        HitRecord hit;
+        if (!scene.closestHit(ray, 0.0, numeric_limits<double>::infinity(), hit)) {
+            break; // Black background
+        }
+
+        const Material& material = scene.materialOf(hit);
+        if (!afterDiffuse || !sampledEmitter[hit.shape]) {
+            result += throughput * material.emission;
+        }
+
+        bool entering = hit.normal.dot(ray.d) < 0;
+        Direction n = entering ? hit.normal : hit.normal * -1.0;
+
+        switch (material.type) {
+            case MaterialType::Diffuse: {
+                result += throughput * directLighting(hit, ray.time, n, material.albedo, lightPick, lightU, lightV, shadows, stats);
+                // Cosine sampling cancels the cosine and the 1/pi of the BRDF
+                ray = Ray(offsetOrigin(hit, n), sampleCosine(n, scatterU, scatterV), ray.time);
+                throughput = throughput * material.albedo;
+                afterDiffuse = true;
+                break;
+            }
+            case MaterialType::Specular: {
+                ray = Ray(offsetOrigin(hit, n), reflect(ray.d, n), ray.time);
+                throughput = throughput * material.albedo;
+                afterDiffuse = false;
+                break;
+            }
+            case MaterialType::Dielectric: {
+                double n1 = entering ? 1.0 : material.ior;
+                double n2 = entering ? material.ior : 1.0;
+                double eta = n1 / n2;
+                double cosI = -ray.d.dot(n);
+                double sin2T = eta * eta * (1.0 - cosI * cosI);
+
+                // Pick reflection or refraction with the Fresnel probability
+                bool reflected = sin2T >= 1.0; // Total internal reflection
+                double cosT = 0.0;
+                if (!reflected) {
+                    cosT = sqrt(1.0 - sin2T);
+                    reflected = scatterU < fresnel(cosI, cosT, n1, n2);
+                }
+                if (reflected) {
+                    ray = Ray(offsetOrigin(hit, n), reflect(ray.d, n), ray.time);
+                } else {
+                    Direction refracted = ray.d * eta + n * (eta * cosI - cosT);
+                    ray = Ray(offsetOrigin(hit, n * -1.0), refracted.normalized(), ray.time);
+                }
+                throughput = throughput * material.albedo;
+                afterDiffuse = false;
+                break;
+            }
+        }
+
+        if (depth + 1 >= ROULETTE_DEPTH) {
+            double survive = min(0.95, max(0.05, maxComponent(throughput)));
+            if (roulette >= survive) {
+                break;
+            }
+            throughput = throughput * (1.0 / survive);
+        }
+    }
+    return result;
+}
+
+PixelRGB PathTracer::directLighting(const HitRecord& hit, double time, const Direction& n, const PixelRGB& albedo,
+                                    double pick, double u, double v, ShadowCache& shadows,
+                                    RenderStats& stats) const {
+    Point origin = offsetOrigin(hit, n);
+    PixelRGB light;
+
+    // Point lights: same estimate as the primary renderer
+    for (size_t i = 0; i < scene.lights.size(); ++i) {
+        const PointLight& pointLight = scene.lights[i];
+        Direction toLight = pointLight.position - origin;
+        double distance = toLight.norm();
+        Direction l = toLight / distance;
+        double cosTheta = n.dot(l);
+        if (cosTheta <= 0) {
+            continue;
+        }
+
+        stats.shadowRays++;
+        if (shadows.occluded(scene, static_cast<int>(i), Ray(origin, l, time), 0.0, distance)) {
+            continue;
+        }
+        light += pointLight.power * (cosTheta / (distance * distance));
+    }
+
+    if (!emitters.empty()) {
+        light += sampleEmitter(hit, time, origin, n, pick, u, v, shadows, stats);
+    }
+
+    // Lambertian BRDF
+    return albedo * light * (1.0 / M_PI);
+}
+
+PixelRGB PathTracer::sampleEmitter(const HitRecord& hit, double time, const Point& origin, const Direction& n,
+                                   double pick, double u, double v, ShadowCache& shadows,
+                                   RenderStats& stats) const {
+    int picked = min(static_cast<int>(emitters.size()) - 1, static_cast<int>(pick * emitters.size()));
+    int shape = emitters[picked];
+    if (shape == hit.shape) {
+        return PixelRGB(); // Neither a sphere nor a triangle lights itself
+    }
+
+    const PixelRGB& emission = scene.materials[scene.shapeMaterials[shape]].emission;
+    const double pickPdf = 1.0 / emitters.size();
+    const GeometricShape* geometry = scene.shapes[shape].get();
+    const int slot = static_cast<int>(scene.lights.size()) + picked;
+
+    if (auto sphere = dynamic_cast<const Sphere*>(geometry)) {
+        Direction toCenter = sphere->center - origin;
+        double dist2 = toCenter.dot(toCenter);
+        double r2 = sphere->radius * sphere->radius;
+
+        Direction l;
+        double pdf; // Solid angle
+        if (dist2 > r2) {
+            // Uniform over the cone of directions subtended by the sphere
+            double cosMax = sqrt(1.0 - r2 / dist2);
+            double cosTheta = 1.0 - u * (1.0 - cosMax);
+            l = aroundAxis(toCenter / sqrt(dist2), cosTheta, 2.0 * M_PI * v);
+            pdf = 1.0 / (2.0 * M_PI * (1.0 - cosMax));
+        } else {
+            // Inside the sphere: uniform over its area
+            double z = 1.0 - 2.0 * u;
+            Direction normal = aroundAxis(Direction(0, 0, 1), z, 2.0 * M_PI * v);
+            Direction toPoint = (sphere->center + normal * sphere->radius) - origin;
+            double distance = toPoint.norm();
+            l = toPoint / distance;
+            double cosLight = fabs(normal.dot(l));
+            if (cosLight <= 0) {
+                return PixelRGB();
+            }
+            pdf = distance * distance / (cosLight * 4.0 * M_PI * r2);
+        }
+
+        double cosTheta = n.dot(l);
+        if (cosTheta <= 0) {
+            return PixelRGB();
+        }
+
+        // Visible when nothing blocks l before it reaches the emitter
+        stats.shadowRays++;
+        Ray shadowRay(origin, l, time);
+        HitRecord onLight;
+        if (!sphere->closestHit(shadowRay, 0.0, numeric_limits<double>::infinity(), onLight) ||
+            shadows.occluded(scene, slot, shadowRay, 0.0, onLight.t * (1.0 - SHADOW_SHORTEN))) {
+            return PixelRGB();
+        }
+        return emission * (cosTheta / (pdf * pickPdf));
+    }
+
+    auto triangle = static_cast<const Triangle*>(geometry);
+    double su = sqrt(u);
+    double b1 = v * su;
+    double b2 = su - b1; // 1 - b0 - b1 with b0 = 1 - su
+    Direction e1 = triangle->v1 - triangle->v0;
+    Direction e2 = triangle->v2 - triangle->v0;
+    Point sample = triangle->v0 + (e1 * b1 + e2 * b2);
+    Direction cross = e1.cross(e2);
+    double area = 0.5 * cross.norm();
+
+    Direction toPoint = sample - origin;
+    double distance = toPoint.norm();
+    Direction l = toPoint / distance;
+    double cosTheta = n.dot(l);
+    double cosLight = fabs(cross.dot(l)) / (2.0 * area);
+    if (cosTheta <= 0 || cosLight <= 0) {
+        return PixelRGB();
+    }
+
+    stats.shadowRays++;
+    if (shadows.occluded(scene, slot, Ray(origin, l, time), 0.0, distance * (1.0 - SHADOW_SHORTEN))) {
+        return PixelRGB();
+    }
+    double pdf = distance * distance / (cosLight * area);
+    return emission * (cosTheta / (pdf * pickPdf));
+}
+
+void renderProgressive(const Scene& scene, const Camera& camera, TileScheduler& scheduler,
+                       const RenderOptions& options, const ProgressiveOptions& progressive,
+                       Accumulator& acc, RenderStats& stats) {
+    if (acc.width != camera.width || acc.height != camera.height) {
+        throw invalid_argument("El acumulador no tiene la resolucion de la camara.");
+    }
+
+    const uint32_t target = static_cast<uint32_t>(max(1, progressive.samplesPerPixel > 0
+                                                             ? progressive.samplesPerPixel
+                                                             : scene.settings.samplesPerPixel));
+    const bool adaptive = progressive.adaptiveThreshold > 0;
+    const uint32_t minSamples = static_cast<uint32_t>(max(2, progressive.minSamples));
+    const uint32_t batch = static_cast<uint32_t>(max(1, progressive.adaptiveBatch));
+
+    // Samples pixel (x, y) takes in the next pass
+    auto budget = [&](int x, int y) -> uint32_t {
+        uint32_t n = acc.count[static_cast<size_t>(y) * acc.width + x];
+        if (n >= target) {
+            return 0;
+        }
+        if (!adaptive) {
+            return 1;
+        }
+        if (n >= minSamples && acc.relativeError(x, y, ADAPTIVE_MIN_LUMINANCE) < progressive.adaptiveThreshold) {
+            return 0;
+        }
+        return min(batch, target - n);
+    };
+
+    PathTracer tracer(scene, scene.settings.maxDepth);
+    const vector<Tile> tiles = selectTiles(camera.width, camera.height, options);
+    vector<Tile> active;
+    vector<PaddedStats> threadStats(scheduler.threadCount());
+
+    auto start = chrono::steady_clock::now();
+    auto lastCheckpoint = start;
+    const int firstPass = acc.passes;
+    while (!(progressive.stop && progressive.stop->load())) {
+        // Tiles with some pixel still short of samples
+        active.clear();
+        for (const Tile& tile : tiles) {
+            bool needed = false;
+            for (int y = tile.y0; y < tile.y1 && !needed; ++y) {
+                for (int x = tile.x0; x < tile.x1 && !needed; ++x) {
+                    needed = budget(x, y) > 0;
+                }
+            }
+            if (needed) {
+                active.push_back(tile);
+            }
+        }
+        if (active.empty()) {
+            break;
+        }
+
+        scheduler.run(active, [&](const Tile& tile, TileContext& context) {
+            RenderStats& local = threadStats[context.thread].stats;
+            const auto tileStart = chrono::steady_clock::now();
+            const uint64_t raysBefore = local.totalRays();
+            const TraceCounters countersBefore = TraceCounters::local();
+            Sampler sampler(progressive.sampler, progressive.seed);
+            ShadowCache shadows(tracer.lightCount());
+
+            // Welford statistics of this pass in a tile-local buffer, merged
+            // into the accumulator once the tile is done
+            PixelBatch* pixels = context.arena.allocateArray<PixelBatch>(tile.pixels());
+            PixelBatch* pixel = pixels;
+            for (int y = tile.y0; y < tile.y1; ++y) {
+                for (int x = tile.x0; x < tile.x1; ++x, ++pixel) {
+                    *pixel = PixelBatch();
+                    uint32_t first = acc.count[static_cast<size_t>(y) * acc.width + x];
+                    uint32_t n = budget(x, y);
+                    for (uint32_t s = 0; s < n; ++s) {
+                        sampler.startPixel(x, y, first + s);
+                        double jx, jy;
+                        sampler.get2D(jx, jy);
+                        // Static scenes skip the time dimension and keep their samples
+                        double time = scene.motion ? sampler.get1D() : 0.0;
+                        local.primaryRays++;
+                        PixelRGB value = tracer.radiance(camera.generateRay(x + jx, y + jy, time), sampler, shadows, local);
+
+                        double l = luminance(value);
+                        pixel->n++;
+                        double delta = l - pixel->mean;
+                        pixel->mean += delta / pixel->n;
+                        pixel->m2 += delta * (l - pixel->mean);
+                        pixel->sum += value;
+                    }
+                }
+            }
+
+            if (options.profile) {
+                options.profile->addTile(tile, chrono::duration<double>(chrono::steady_clock::now() - tileStart).count(),
+                                         local.totalRays() - raysBefore, TraceCounters::local().since(countersBefore));
+            }
+
+            pixel = pixels;
+            bool final = true;
+            for (int y = tile.y0; y < tile.y1; ++y) {
+                for (int x = tile.x0; x < tile.x1; ++x, ++pixel) {
+                    if (pixel->n > 0) {
+                        acc.addBatch(x, y, pixel->sum, pixel->n, pixel->mean, pixel->m2);
+                    }
+                    final = final && budget(x, y) == 0;
+                }
+            }
+
+            // The budget of a pixel only changes with its own samples, so a
+            // tile without budget left is not rendered again
+            if (options.update || (final && options.sink)) {
+                PixelRGB* estimate = context.arena.allocateArray<PixelRGB>(tile.pixels());
+                for (int y = tile.y0; y < tile.y1; ++y) {
+                    for (int x = tile.x0; x < tile.x1; ++x) {
+                        estimate[(y - tile.y0) * tile.width() + (x - tile.x0)] = acc.mean(x, y);
+                    }
+                }
+                if (options.update) {
+                    options.update(tile, estimate);
+                }
+                if (final && options.sink) {
+                    options.sink(tile, estimate);
+                }
+            }
+        });
+        acc.passes++;
+
+        auto now = chrono::steady_clock::now();
+        if (options.progress) {
+            uint64_t rays = 0;
+            for (const auto& local : threadStats) {
+                rays += local.stats.totalRays();
+            }
+            double seconds = chrono::duration<double>(now - start).count();
+            cerr << "\rMuestras: " << fixed << setprecision(1) << acc.averageSamples() << "/" << target
+                 << " por pixel (" << active.size() << "/" << tiles.size() << " tiles activas), "
+                 << (seconds > 0 ? rays / seconds / 1e6 : 0.0) << " Mrayos/s" << defaultfloat << flush;
+        }
+
+        if (!progressive.checkpoint.empty() &&
+            chrono::duration<double>(now - lastCheckpoint).count() >= progressive.checkpointInterval) {
+            acc.saveCheckpoint(progressive.checkpoint, progressive.fingerprint);
+            lastCheckpoint = now;
+        }
+    }
+    if (options.progress && acc.passes > firstPass) {
+        cerr << endl;
+    }
+
+    // Final state (complete or interrupted) so the render can always be resumed
+    if (!progressive.checkpoint.empty() && acc.passes > firstPass) {
+        acc.saveCheckpoint(progressive.checkpoint, progressive.fingerprint);
+    }
+
+    stats.seconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    for (const auto& local : threadStats) {
+        stats.merge(local.stats);
+    }
+}
@@ -0,0 +1,81 @@
+#ifndef PATH_TRACER_HPP
+#define PATH_TRACER_HPP
+
+#include "accumulator.hpp"
+#include "camera.hpp"
+#include "renderer.hpp"
+#include "sampler.hpp"
+#include "scheduler.hpp"
+#include "../scene/scene.hpp"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Unidirectional Monte Carlo path tracer. Diffuse surfaces use next event
+// estimation towards the point lights and one sampled emitter (spheres and
+// triangles with emission); specular and dielectric surfaces are perfect
+// mirrors and glass. Paths are cut by the scene depth and Russian roulette.
+class PathTracer {
+    public:
+        PathTracer(const Scene& scene_, int maxDepth_);
+
+        // Radiance arriving along ray (one path sample). Every bounce draws
+        // the same dimensions from the sampler, hit or miss, so dimension d
+        // always plays the same role in every path. Every ray of the path
+        // has the time of ray.
+        // Shadow rays go through shadows, which needs lightCount() slots.
+        PixelRGB radiance(Ray ray, Sampler& sampler, ShadowCache& shadows, RenderStats& stats) const;
+
+        // Point lights followed by the sampled emitters
+        size_t lightCount() const { return scene.lights.size() + emitters.size(); }
+
+    private:
+        const Scene& scene;
+        int maxDepth;
+        std::vector<int> emitters;       // Emissive shapes that can be sampled directly
+        std::vector<char> sampledEmitter; // Per shape: covered by next event estimation
+
+        // Reflected direct light at a diffuse point with normal n (facing the
+        // incoming ray of the given time). pick chooses the emitter, (u, v)
+        // the point on it.
+        PixelRGB directLighting(const HitRecord& hit, double time, const Direction& n, const PixelRGB& albedo,
+                                double pick, double u, double v, ShadowCache& shadows,
+                                RenderStats& stats) const;
+
+        // Light from one emitter picked uniformly, before the BRDF
+        PixelRGB sampleEmitter(const HitRecord& hit, double time, const Point& origin, const Direction& n,
+                               double pick, double u, double v, ShadowCache& shadows,
+                               RenderStats& stats) const;
+};
+
+struct ProgressiveOptions {
+    int samplesPerPixel = 0;          // Samples per pixel to reach, 0 = scene setting
+    std::string checkpoint;           // Checkpoint file, empty for none
+    double checkpointInterval = 60.0; // Seconds between checkpoints
+    SamplerType sampler = SamplerType::Sobol;
+    uint32_t seed = 0;                // Sampler seed
+    uint64_t fingerprint = 0;         // Identifies the scene in the checkpoint
+    double adaptiveThreshold = 0.0;   // Relative error at which a pixel stops, 0 = uniform sampling
+    int minSamples = 16;              // Samples a pixel takes before it may stop
+    int adaptiveBatch = 4;            // Samples per pass of a pixel above the threshold
+    const std::atomic<bool>* stop = nullptr; // Checked between passes
+};
+
+// Adds passes of samples to acc until every pixel holds the requested
+// samples (or has converged) or stop is raised.
+// Uniform sampling adds one sample to every pixel per pass. Adaptive sampling
+// adds adaptiveBatch samples to the pixels whose relative error is still above
+// the threshold, and skips tiles with none left, so the work concentrates
+// where the image is noisy. The k-th sample of a pixel always uses sample
+// index k, so a resumed render gives the same image as an uninterrupted one.
+// The checkpoint is written every checkpointInterval seconds and at the end.
+// A tile goes to the sink of the options once none of its pixels takes more
+// samples; tiles that never get there (interrupted or resumed complete) don't.
+// Every tile rendered in a pass goes to the update of the options with the
+// estimate so far.
+void renderProgressive(const Scene& scene, const Camera& camera, TileScheduler& scheduler,
+                       const RenderOptions& options, const ProgressiveOptions& progressive,
+                       Accumulator& acc, RenderStats& stats);
+
+#endif // PATH_TRACER_HPP
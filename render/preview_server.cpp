@@ -0,0 +1,313 @@
+#include "preview_server.hpp"
+#include "../imaging/png_writer.hpp"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <stdexcept>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+
+// Shortest pause between two rounds of the server, in seconds
+const double PREVIEW_INTERVAL = 0.25;
+
+// Bytes of an HTTP request the server reads; it only needs the first line
+const size_t MAX_REQUEST = 4096;
+
+// Seconds a connection may take to send its request before it is closed
+const double REQUEST_TIMEOUT = 5.0;
+
+double threadCpuSeconds() {
+    timespec t;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+string base64(const vector<uint8_t>& data) {
+    static const char digits[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    string out;
+    out.reserve((data.size() + 2) / 3 * 4);
+    size_t i = 0;
+    for (; i + 2 < data.size(); i += 3) {
+        uint32_t v = data[i] << 16 | data[i + 1] << 8 | data[i + 2];
+        out += digits[v >> 18];
+        out += digits[v >> 12 & 63];
+        out += digits[v >> 6 & 63];
+        out += digits[v & 63];
+    }
+    if (i < data.size()) {
+        uint32_t v = data[i] << 16 | (i + 1 < data.size() ? data[i + 1] << 8 : 0);
+        out += digits[v >> 18];
+        out += digits[v >> 12 & 63];
+        out += i + 1 < data.size() ? digits[v >> 6 & 63] : '=';
+        out += '=';
+    }
+    return out;
+}
+
+// Writes all of data, false once the browser has gone away
+bool sendAll(int socket, const string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(socket, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+string page(int width, int height) {
+    return "<!DOCTYPE html>\n<html><head><meta charset=\"utf-8\"><title>InfGr</title></head>\n"
+           "<body style=\"background:#222;color:#ccc;font-family:sans-serif\">\n"
+           "<p id=\"estado\">Renderizando...</p>\n"
+           "<canvas id=\"imagen\" width=\"" + to_string(width) + "\" height=\"" + to_string(height) + "\"></canvas>\n"
+           "<script>\n"
+           "const canvas = document.getElementById('imagen').getContext('2d');\n"
+           "const source = new EventSource('/events');\n"
+           "source.onmessage = e => {\n"
+           "  const tile = JSON.parse(e.data);\n"
+           "  const img = new Image();\n"
+           "  img.onload = () => canvas.drawImage(img, tile.x, tile.y);\n"
+           "  img.src = 'data:image/png;base64,' + tile.png;\n"
+           "};\n"
+           "source.addEventListener('done', () => {\n"
+           "  source.close();\n"
+           "  document.getElementById('estado').textContent = 'Render terminado';\n"
+           "});\n"
+           "</script>\n</body></html>\n";
+}
+
+} // namespace
+
+PreviewServer::PreviewServer(int port_, int width_, int height_, const vector<Tile>& tiles_,
+                             const ToneMap& toneMap_, double cpuShare_, unsigned renderThreads_)
+    : width(width_), height(height_), tiles(tiles_), toneMap(toneMap_.local() ? toneMap_ : ToneMap()),
+      cpuShare(cpuShare_), renderThreads(max(1u, renderThreads_)), listener(-1), boundPort(0),
+      hdr(static_cast<size_t>(width_) * height_), version(tiles_.size(), 0), stopping(false),
+      encodedVersion(tiles_.size(), 0), events(tiles_.size()) {
+    if (cpuShare <= 0 || cpuShare > 1) {
+        throw invalid_argument("La fraccion de CPU de la vista previa debe estar en (0, 1].");
+    }
+
+    listener = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listener < 0) {
+        throw runtime_error("No se pudo crear el socket de la vista previa: " + string(strerror(errno)));
+    }
+    int yes = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(static_cast<uint16_t>(port_));
+    socklen_t length = sizeof(address);
+    if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 ||
+        listen(listener, 8) < 0 ||
+        getsockname(listener, reinterpret_cast<sockaddr*>(&address), &length) < 0) {
+        string reason = strerror(errno);
+        close(listener);
+        throw runtime_error("No se pudo abrir el puerto " + to_string(port_) + " de la vista previa: " + reason);
+    }
+    boundPort = ntohs(address.sin_port);
+    fcntl(listener, F_SETFL, fcntl(listener, F_GETFL) | O_NONBLOCK);
+
+    server = thread(&PreviewServer::serve, this);
+}
+
+PreviewServer::~PreviewServer() {
+    finish();
+    close(listener);
+}
+
+void PreviewServer::update(const Tile& tile, const PixelRGB* pixels) {
+    lock_guard<std::mutex> lock(mutex);
+    for (int y = tile.y0; y < tile.y1; ++y) {
+        copy_n(pixels + (y - tile.y0) * tile.width(), tile.width(), &hdr[static_cast<size_t>(y) * width + tile.x0]);
+    }
+    version[tile.index]++;
+}
+
+void PreviewServer::finish() {
+    {
+        lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    if (server.joinable()) {
+        server.join();
+    }
+}
+
+void PreviewServer::serve() {
+    const double cpuStart = threadCpuSeconds();
+    const auto start = chrono::steady_clock::now();
+
+    unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        const bool last = stopping;
+        lock.unlock();
+        acceptClients();
+        if (!clients.empty()) {
+            encodeDirtyTiles();
+            sendEvents();
+        }
+        lock.lock();
+        if (last) {
+            break;
+        }
+
+        // Waits until the CPU time used so far fits in the share of the
+        // render threads over the time elapsed
+        double cpu = threadCpuSeconds() - cpuStart;
+        double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        double pause = max(PREVIEW_INTERVAL, cpu / (cpuShare * renderThreads) - elapsed);
+        wake.wait_for(lock, chrono::duration<double>(pause), [this] { return stopping; });
+    }
+    lock.unlock();
+    closeClients();
+}
+
+void PreviewServer::acceptClients() {
+    // Connections are read without blocking: a browser that connects and
+    // sends nothing must not hold up the rounds, so partial requests wait
+    // here for the next one
+    const auto now = chrono::steady_clock::now();
+    while (true) {
+        int client = accept4(listener, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK);
+        if (client < 0) {
+            break; // EAGAIN: nobody else is waiting
+        }
+        requests.push_back({client, string(), now});
+    }
+
+    for (size_t r = 0; r < requests.size();) {
+        Request& request = requests[r];
+        bool closed = false;
+        char buffer[512];
+        while (request.received.size() < MAX_REQUEST && request.received.find("\r\n\r\n") == string::npos) {
+            ssize_t n = recv(request.socket, buffer, sizeof(buffer), 0);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                closed = n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK);
+                break;
+            }
+            request.received.append(buffer, static_cast<size_t>(n));
+        }
+
+        const bool complete = request.received.size() >= MAX_REQUEST ||
+                              request.received.find("\r\n\r\n") != string::npos;
+        if (complete) {
+            answer(request.socket, request.received);
+        } else if (closed || chrono::duration<double>(now - request.since).count() > REQUEST_TIMEOUT) {
+            close(request.socket);
+        } else {
+            ++r;
+            continue;
+        }
+        requests.erase(requests.begin() + r);
+    }
+}
+
+void PreviewServer::answer(int socket, const string& request) {
+    // Replies block again, bounded by the send timeout
+    fcntl(socket, F_SETFL, fcntl(socket, F_GETFL) & ~O_NONBLOCK);
+    timeval timeout{1, 0};
+    setsockopt(socket, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    string line = request.substr(0, request.find("\r\n"));
+    if (line.rfind("GET /events ", 0) == 0) {
+        if (sendAll(socket, "HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\n"
+                            "Cache-Control: no-cache\r\nConnection: keep-alive\r\n\r\n")) {
+            clients.push_back({socket, vector<uint32_t>(tiles.size(), 0)});
+            return;
+        }
+    } else if (line.rfind("GET / ", 0) == 0) {
+        string body = page(width, height);
+        sendAll(socket, "HTTP/1.1 200 OK\r\nContent-Type: text/html; charset=utf-8\r\nContent-Length: " +
+                        to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body);
+    } else {
+        sendAll(socket, "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+    }
+    close(socket);
+}
+
+void PreviewServer::encodeDirtyTiles() {
+    // Copy the dirty tiles out so the renderer is never kept waiting on the
+    // compression
+    vector<int> dirty;
+    vector<uint32_t> versions;
+    vector<PixelRGB> pixels;
+    {
+        lock_guard<std::mutex> lock(mutex);
+        for (size_t i = 0; i < tiles.size(); ++i) {
+            if (version[i] != encodedVersion[i]) {
+                const Tile& tile = tiles[i];
+                dirty.push_back(static_cast<int>(i));
+                versions.push_back(version[i]);
+                for (int y = tile.y0; y < tile.y1; ++y) {
+                    const PixelRGB* row = &hdr[static_cast<size_t>(y) * width + tile.x0];
+                    pixels.insert(pixels.end(), row, row + tile.width());
+                }
+            }
+        }
+    }
+
+    vector<uint8_t> rgb;
+    const PixelRGB* pixel = pixels.data();
+    for (size_t n = 0; n < dirty.size(); ++n) {
+        const Tile& tile = tiles[dirty[n]];
+        rgb.resize(static_cast<size_t>(tile.pixels()) * 3);
+        for (int i = 0; i < tile.pixels(); ++i, ++pixel) {
+            toneMap.mapPixel(*pixel, &rgb[3 * i]);
+        }
+        events[dirty[n]] = "data: {\"x\":" + to_string(tile.x0) + ",\"y\":" + to_string(tile.y0) +
+                           ",\"png\":\"" + base64(encodePNG(rgb.data(), tile.width(), tile.height())) + "\"}\n\n";
+        encodedVersion[dirty[n]] = versions[n];
+    }
+}
+
+void PreviewServer::sendEvents() {
+    for (size_t c = 0; c < clients.size();) {
+        Client& client = clients[c];
+        string delta;
+        for (size_t i = 0; i < tiles.size(); ++i) {
+            if (client.sent[i] != encodedVersion[i]) {
+                delta += events[i];
+            }
+        }
+        if (delta.empty() || sendAll(client.socket, delta)) {
+            client.sent = encodedVersion;
+            ++c;
+        } else {
+            close(client.socket);
+            clients.erase(clients.begin() + c);
+        }
+    }
+}
+
+void PreviewServer::closeClients() {
+    for (const Client& client : clients) {
+        sendAll(client.socket, "event: done\ndata: fin\n\n");
+        close(client.socket);
+    }
+    clients.clear();
+    for (const Request& request : requests) {
+        close(request.socket);
+    }
+    requests.clear();
+}
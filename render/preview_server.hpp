@@ -0,0 +1,87 @@
+#ifndef PREVIEW_SERVER_HPP
+#define PREVIEW_SERVER_HPP
+
+#include "scheduler.hpp"
+#include "../imaging/image.hpp"
+#include "../imaging/tone_map.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Live preview of a render for a browser on the same machine. An HTTP server
+// bound to 127.0.0.1 serves a page at / that listens to /events, a stream of
+// server-sent events: one event per tile that changed since the last one the
+// browser got, with the tile tone mapped and compressed as a PNG.
+// The renderer only copies tiles in (update); mapping, compression and the
+// sockets run on the server thread, which sleeps as long as needed to keep
+// its CPU time under cpuShare of the render threads.
+class PreviewServer {
+    public:
+        // Listens on port (0 picks a free one). Global tone maps cannot be
+        // applied to single tiles, the preview uses the display one for them.
+        // Throws runtime_error if the socket cannot be opened.
+        PreviewServer(int port_, int width_, int height_, const std::vector<Tile>& tiles_,
+                      const ToneMap& toneMap_, double cpuShare_, unsigned renderThreads_);
+        ~PreviewServer();
+
+        PreviewServer(const PreviewServer&) = delete;
+        PreviewServer& operator=(const PreviewServer&) = delete;
+
+        // Current HDR pixels of a tile, row major with tile.width() per row.
+        // Thread safe and cheap: the tile is only copied and marked dirty.
+        void update(const Tile& tile, const PixelRGB* pixels);
+
+        // Sends the tiles still pending, tells the browsers the render is
+        // over and closes the server
+        void finish();
+
+        int port() const { return boundPort; }
+
+    private:
+        struct Client {
+            int socket;
+            std::vector<uint32_t> sent; // Per tile: version the browser has
+        };
+
+        // Connection whose request has not fully arrived yet
+        struct Request {
+            int socket;
+            std::string received;
+            std::chrono::steady_clock::time_point since;
+        };
+
+        int width, height;
+        std::vector<Tile> tiles;
+        ToneMap toneMap;
+        double cpuShare;
+        unsigned renderThreads;
+        int listener;
+        int boundPort;
+
+        // Shared with the renderer
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::vector<PixelRGB> hdr;      // Latest pixels, row major
+        std::vector<uint32_t> version;  // Per tile: updates received
+        bool stopping;
+
+        // Server thread only
+        std::vector<uint32_t> encodedVersion; // Per tile: version of events[i]
+        std::vector<std::string> events;      // Per tile: last encoded event
+        std::vector<Client> clients;
+        std::vector<Request> requests;
+        std::thread server;
+
+        void serve();
+        void acceptClients();
+        void answer(int socket, const std::string& request);
+        void encodeDirtyTiles();
+        void sendEvents();
+        void closeClients();
+};
+
+#endif // PREVIEW_SERVER_HPP
@@ -0,0 +1,147 @@
+#include "render_profile.hpp"
+#include "../imaging/png_writer.hpp"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <numeric>
+#include <stdexcept>
+
+using namespace std;
+
+namespace {
+
+// Slowest tiles listed in the summary
+const size_t SLOWEST_TILES = 10;
+
+// Names of the PrimitiveStore kinds, in order
+const char* const KIND_NAMES[TraceCounters::KINDS] = { "sphere", "triangle", "plane", "generic" };
+
+string jsonString(const string& text) {
+    string quoted = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+        }
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+void writeKinds(ostream& out, const uint64_t (&values)[TraceCounters::KINDS]) {
+    out << "{";
+    for (int kind = 0; kind < TraceCounters::KINDS; ++kind) {
+        out << (kind ? ", " : "") << "\"" << KIND_NAMES[kind] << "\": " << values[kind];
+    }
+    out << "}";
+}
+
+void writeTile(ostream& out, const Tile& tile, const TileCost& cost) {
+    out << "{\"index\": " << tile.index << ", \"x\": " << tile.x0 << ", \"y\": " << tile.y0
+        << ", \"width\": " << tile.width() << ", \"height\": " << tile.height()
+        << ", \"seconds\": " << cost.seconds << ", \"rays\": " << cost.rays
+        << ", \"nodesVisited\": " << cost.counters.nodesVisited
+        << ", \"primitiveTests\": " << cost.counters.totalTests() << "}";
+}
+
+// Black, blue, red, yellow and white at even steps of t in [0, 1]
+void falseColour(double t, uint8_t rgb[3]) {
+    static const double stops[5][3] = {
+        { 0, 0, 0 }, { 0, 0, 255 }, { 255, 0, 0 }, { 255, 255, 0 }, { 255, 255, 255 }
+    };
+    t = min(max(t, 0.0), 1.0) * 4.0;
+    int i = min(static_cast<int>(t), 3);
+    double f = t - i;
+    for (int c = 0; c < 3; ++c) {
+        rgb[c] = static_cast<uint8_t>(stops[i][c] + (stops[i + 1][c] - stops[i][c]) * f + 0.5);
+    }
+}
+
+} // namespace
+
+RenderProfile::RenderProfile(int width_, int height_, int tileSize)
+    : width(width_), height(height_), tiles(makeTiles(width_, height_, tileSize)), costs(tiles.size()) {}
+
+void RenderProfile::saveSummary(const std::string& filename, const std::string& sceneFile,
+                                const RenderStats& stats, unsigned threads) const {
+    ofstream out(filename);
+    if (!out) {
+        throw runtime_error("No se pudo abrir el fichero de estadisticas '" + filename + "'.");
+    }
+
+    TraceCounters total;
+    double tileSeconds = 0.0;
+    for (const TileCost& cost : costs) {
+        total.merge(cost.counters);
+        tileSeconds += cost.seconds;
+    }
+    vector<size_t> order(tiles.size());
+    iota(order.begin(), order.end(), 0);
+    sort(order.begin(), order.end(), [this](size_t a, size_t b) { return costs[a].seconds > costs[b].seconds; });
+
+    out << setprecision(9);
+    out << "{\n";
+    out << "  \"scene\": " << jsonString(sceneFile) << ",\n";
+    out << "  \"width\": " << width << ",\n";
+    out << "  \"height\": " << height << ",\n";
+    out << "  \"threads\": " << threads << ",\n";
+    out << "  \"seconds\": " << stats.seconds << ",\n";
+    out << "  \"rays\": {\"primary\": " << stats.primaryRays << ", \"secondary\": " << stats.secondaryRays
+        << ", \"shadow\": " << stats.shadowRays << ", \"total\": " << stats.totalRays() << "},\n";
+#ifdef INFGR_COUNTERS
+    out << "  \"traversalCounters\": true,\n";
+#else
+    out << "  \"traversalCounters\": false,\n";
+#endif
+    out << "  \"nodesVisited\": " << total.nodesVisited << ",\n";
+    out << "  \"primitiveTests\": ";
+    writeKinds(out, total.primitiveTests);
+    out << ",\n  \"primitiveHits\": ";
+    writeKinds(out, total.primitiveHits);
+    out << ",\n";
+    out << "  \"tileSeconds\": {\"total\": " << tileSeconds
+        << ", \"mean\": " << (tiles.empty() ? 0.0 : tileSeconds / tiles.size())
+        << ", \"min\": " << (tiles.empty() ? 0.0 : costs[order.back()].seconds)
+        << ", \"max\": " << (tiles.empty() ? 0.0 : costs[order.front()].seconds) << "},\n";
+    out << "  \"slowestTiles\": [";
+    for (size_t i = 0; i < min(SLOWEST_TILES, order.size()); ++i) {
+        out << (i ? ",\n    " : "\n    ");
+        writeTile(out, tiles[order[i]], costs[order[i]]);
+    }
+    out << "\n  ],\n";
+    out << "  \"tiles\": [";
+    for (size_t i = 0; i < tiles.size(); ++i) {
+        out << (i ? ",\n    " : "\n    ");
+        writeTile(out, tiles[i], costs[i]);
+    }
+    out << "\n  ]\n}\n";
+
+    if (!out) {
+        throw runtime_error("Error escribiendo el fichero de estadisticas '" + filename + "'.");
+    }
+}
+
+void RenderProfile::saveHeatmap(const std::string& filename) const {
+    // Time per pixel, so the smaller tiles of the last row and column compare fairly
+    vector<double> cost(tiles.size());
+    double maxCost = 0.0;
+    for (size_t i = 0; i < tiles.size(); ++i) {
+        cost[i] = costs[i].seconds / tiles[i].pixels();
+        maxCost = max(maxCost, cost[i]);
+    }
+
+    vector<uint8_t> rgb(static_cast<size_t>(width) * height * 3);
+    for (size_t i = 0; i < tiles.size(); ++i) {
+        const Tile& tile = tiles[i];
+        uint8_t colour[3];
+        falseColour(maxCost > 0 ? cost[i] / maxCost : 0.0, colour);
+        for (int y = tile.y0; y < tile.y1; ++y) {
+            for (int x = tile.x0; x < tile.x1; ++x) {
+                copy_n(colour, 3, &rgb[(static_cast<size_t>(y) * width + x) * 3]);
+            }
+        }
+    }
+
+    PNGWriter png(filename, width, height);
+    png.writeRows(rgb.data(), height);
+    png.finish();
+}
@@ -0,0 +1,49 @@
+#ifndef RENDER_PROFILE_HPP
+#define RENDER_PROFILE_HPP
+
+#include "renderer.hpp"
+#include "scheduler.hpp"
+#include "../geometry/trace_counters.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Work spent on one tile, summed over the passes of a progressive render
+struct TileCost {
+    double seconds = 0.0;
+    uint64_t rays = 0;
+    TraceCounters counters; // Zero unless built with INFGR_COUNTERS
+};
+
+// Cost of every tile of a render, to find the geometry that makes it slow.
+// The render threads add to the slot of the tile they are rendering, which
+// no other thread touches meanwhile, so nothing is synchronised; totals are
+// only summed when the summary is written.
+class RenderProfile {
+    public:
+        RenderProfile(int width_, int height_, int tileSize);
+
+        // One pass of the renderer over a tile
+        void addTile(const Tile& tile, double seconds, uint64_t rays, const TraceCounters& counters) {
+            TileCost& cost = costs[tile.index];
+            cost.seconds += seconds;
+            cost.rays += rays;
+            cost.counters.merge(counters);
+        }
+
+        // JSON with the ray counts of stats, the traversal counters, the
+        // tile times and the slowest tiles. Throws runtime_error
+        void saveSummary(const std::string& filename, const std::string& sceneFile,
+                         const RenderStats& stats, unsigned threads) const;
+
+        // False colour image of the time per pixel of every tile, from black
+        // (cheapest) through blue, red and yellow to white. Throws runtime_error
+        void saveHeatmap(const std::string& filename) const;
+
+    private:
+        int width, height;
+        std::vector<Tile> tiles;
+        std::vector<TileCost> costs;
+};
+
+#endif // RENDER_PROFILE_HPP
@@ -0,0 +1,222 @@
+#include "renderer.hpp"
+#include "render_profile.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+// Per-thread counters, padded so two threads never share a cache line
+struct alignas(64) ThreadStats {
+    RenderStats stats;
+    atomic<uint64_t> published{0}; // Rays done at the end of the last tile
+};
+
+// Progress line with the throughput of every thread so far
+TileScheduler::ProgressCallback progressReporter(const vector<ThreadStats>& threadStats,
+                                                 chrono::steady_clock::time_point start) {
+    return [&threadStats, start](int done, int total) {
+        uint64_t rays = 0;
+        for (const auto& local : threadStats) {
+            rays += local.published.load(memory_order_relaxed);
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cerr << "\rProgreso: " << fixed << setprecision(1) << 100.0 * done / total << "% ("
+             << done << "/" << total << " tiles), " << (seconds > 0 ? rays / seconds / 1e6 : 0.0)
+             << " Mrayos/s" << defaultfloat << flush;
+        if (done == total) {
+            cerr << endl;
+        }
+    };
+}
+
+// Pixel block covered by one primary ray packet
+const int PACKET_WIDTH = 4;
+const int PACKET_HEIGHT = RayPacket::SIZE / PACKET_WIDTH;
+
+// Primary visibility of a tile in packets of PACKET_WIDTH x PACKET_HEIGHT
+// pixels. Shading (and its shadow rays) stays per ray.
+void tracePrimaryPackets(const Scene& scene, const Camera& camera, const Tile& tile,
+                         PixelRGB* buffer, ShadowCache& shadows, RenderStats& stats) {
+    for (int by = tile.y0; by < tile.y1; by += PACKET_HEIGHT) {
+        for (int bx = tile.x0; bx < tile.x1; bx += PACKET_WIDTH) {
+            RayPacket packet;
+            for (int lane = 0; lane < RayPacket::SIZE; ++lane) {
+                int x = bx + lane % PACKET_WIDTH, y = by + lane / PACKET_WIDTH;
+                if (x < tile.x1 && y < tile.y1) {
+                    packet.set(lane, camera.generateRay(x + 0.5, y + 0.5), numeric_limits<double>::infinity());
+                    stats.primaryRays++;
+                }
+            }
+
+            scene.intersectPacket(packet, 0.0);
+
+            for (int lane = 0; lane < RayPacket::SIZE; ++lane) {
+                if (!(packet.active & (1u << lane)) || !packet.hit(lane)) {
+                    continue;
+                }
+                int x = bx + lane % PACKET_WIDTH, y = by + lane / PACKET_WIDTH;
+                Ray ray = packet.ray(lane);
+                HitRecord hit;
+                hit.t = packet.t[lane];
+                hit.offset = packet.offset[lane];
+                hit.point = hit.offset > 0 ? Point(packet.px[lane], packet.py[lane], packet.pz[lane])
+                                           : ray.o + ray.d * hit.t;
+                hit.normal = Direction(packet.nx[lane], packet.ny[lane], packet.nz[lane]);
+                hit.shape = packet.shape[lane];
+                buffer[(y - tile.y0) * tile.width() + (x - tile.x0)] = shadePrimaryHit(scene, ray, hit, shadows, stats);
+            }
+        }
+    }
+}
+
+} // namespace
+
+PixelRGB shadePrimaryHit(const Scene& scene, const Ray& ray, const HitRecord& hit, ShadowCache& shadows,
+                         RenderStats& stats) {
+    const Material& material = scene.materialOf(hit);
+
+    // Normal on the side the ray comes from
+    Direction n = hit.normal.dot(ray.d) < 0 ? hit.normal : hit.normal * -1.0;
+
+    PixelRGB color = material.emission;
+    if (scene.lights.empty()) {
+        return color + material.albedo * fabs(n.dot(ray.d));
+    }
+
+    Point origin = offsetOrigin(hit, n);
+    for (size_t i = 0; i < scene.lights.size(); ++i) {
+        const PointLight& light = scene.lights[i];
+        Direction toLight = light.position - origin;
+        double distance = toLight.norm();
+        Direction l = toLight / distance;
+        double cosTheta = n.dot(l);
+        if (cosTheta <= 0) {
+            continue;
+        }
+
+        stats.shadowRays++;
+        if (shadows.occluded(scene, static_cast<int>(i), Ray(origin, l, ray.time), 0.0, distance)) {
+            continue;
+        }
+
+        // Lambertian BRDF (albedo / pi) lit by a point light of the given intensity
+        color += material.albedo * light.power * (cosTheta / (M_PI * distance * distance));
+    }
+    return color;
+}
+
+void renderPrimaryTiles(const Scene& scene, const Camera& camera, TileScheduler& scheduler,
+                        const RenderOptions& options, RenderStats& stats) {
+    vector<Tile> tiles = selectTiles(camera.width, camera.height, options);
+
+    // Each thread counts into its own slot, published once per tile for the progress report
+    vector<ThreadStats> threadStats(scheduler.threadCount());
+
+    auto start = chrono::steady_clock::now();
+    scheduler.run(tiles, [&](const Tile& tile, TileContext& context) {
+        ThreadStats& local = threadStats[context.thread];
+        const auto tileStart = chrono::steady_clock::now();
+        const uint64_t raysBefore = local.stats.totalRays();
+        const TraceCounters countersBefore = TraceCounters::local();
+
+        // Render into a tile-local buffer so threads never write next to each other
+        PixelRGB* buffer = context.arena.allocateArray<PixelRGB>(tile.pixels());
+        uninitialized_fill_n(buffer, tile.pixels(), PixelRGB());
+        ShadowCache shadows(scene.lights.size());
+
+        if (options.packets) {
+            tracePrimaryPackets(scene, camera, tile, buffer, shadows, local.stats);
+        } else {
+            for (int y = tile.y0; y < tile.y1; ++y) {
+                PixelRGB* row = buffer + (y - tile.y0) * tile.width();
+                for (int x = tile.x0; x < tile.x1; ++x) {
+                    Ray ray = camera.generateRay(x + 0.5, y + 0.5);
+                    local.stats.primaryRays++;
+
+                    HitRecord hit;
+                    if (scene.closestHit(ray, 0.0, numeric_limits<double>::infinity(), hit)) {
+                        row[x - tile.x0] = shadePrimaryHit(scene, ray, hit, shadows, local.stats);
+                    }
+                }
+            }
+        }
+
+        if (options.profile) {
+            options.profile->addTile(tile, chrono::duration<double>(chrono::steady_clock::now() - tileStart).count(),
+                                     local.stats.totalRays() - raysBefore, TraceCounters::local().since(countersBefore));
+        }
+        if (options.update) {
+            options.update(tile, buffer);
+        }
+        if (options.sink) {
+            options.sink(tile, buffer);
+        }
+        local.published.store(local.stats.totalRays(), memory_order_relaxed);
+    }, options.progress ? progressReporter(threadStats, start) : TileScheduler::ProgressCallback());
+
+    stats.seconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    for (const auto& local : threadStats) {
+        stats.merge(local.stats);
+    }
+}
+
+Image renderPrimary(const Scene& scene, const Camera& camera, TileScheduler& scheduler,
+                    const RenderOptions& options, RenderStats& stats) {
+    Image image(camera.width, camera.height);
+    RenderOptions collect = options;
+    collect.sink = [&image, &options](const Tile& tile, const PixelRGB* pixels) {
+        for (int y = tile.y0; y < tile.y1; ++y) {
+            copy_n(pixels + (y - tile.y0) * tile.width(), tile.width(), image.imagen[y] + tile.x0);
+        }
+        if (options.sink) {
+            options.sink(tile, pixels);
+        }
+    };
+    renderPrimaryTiles(scene, camera, scheduler, collect, stats);
+    return image;
+}
+
+vector<Tile> selectTiles(int width, int height, const RenderOptions& options) {
+    if (options.onlyTiles.empty()) {
+        return makeTiles(width, height, options.tileSize);
+    }
+
+    // Built from the index alone (same layout as makeTiles): a worker gets a
+    // few tiles per batch, and listing the whole image every time made small
+    // tiles quadratic
+    const int size = max(1, options.tileSize);
+    const int columns = (width + size - 1) / size;
+    const int count = columns * ((height + size - 1) / size);
+    vector<Tile> selected;
+    selected.reserve(options.onlyTiles.size());
+    for (int index : options.onlyTiles) {
+        if (index < 0 || index >= count) {
+            throw out_of_range("Tile " + to_string(index) + " fuera de la imagen.");
+        }
+        Tile tile;
+        tile.x0 = (index % columns) * size;
+        tile.y0 = (index / columns) * size;
+        tile.x1 = min(width, tile.x0 + size);
+        tile.y1 = min(height, tile.y0 + size);
+        tile.index = index;
+        selected.push_back(tile);
+    }
+    return selected;
+}
+
+std::string renderStem(const std::string& output) {
+    size_t dot = output.find_last_of('.');
+    size_t slash = output.find_last_of('/');
+    return (dot != string::npos && (slash == string::npos || dot > slash)) ? output.substr(0, dot) : output;
+}
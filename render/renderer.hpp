@@ -0,0 +1,106 @@
+#ifndef RENDERER_HPP
+#define RENDERER_HPP
+
+#include "camera.hpp"
+#include "scheduler.hpp"
+#include "../scene/scene.hpp"
+#include "../imaging/image.hpp"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Offset applied along the normal to secondary ray origins to avoid self
+// intersections, when the hit has no error bound of its own
+const double RAY_EPSILON = 1e-6;
+
+// Origin for rays leaving hit on the side n points to
+inline Point offsetOrigin(const HitRecord& hit, const Direction& n) {
+    return hit.point + n * (hit.offset > 0 ? hit.offset : RAY_EPSILON);
+}
+
+struct RenderStats {
+    uint64_t primaryRays = 0;
+    uint64_t shadowRays = 0;
+    uint64_t secondaryRays = 0; // Path continuation rays
+    double seconds = 0.0;
+
+    uint64_t totalRays() const { return primaryRays + shadowRays + secondaryRays; }
+    double raysPerSecond() const { return seconds > 0 ? totalRays() / seconds : 0.0; }
+
+    // Adds the ray counts of another thread (seconds are wall clock, not added)
+    void merge(const RenderStats& other) {
+        primaryRays += other.primaryRays;
+        shadowRays += other.shadowRays;
+        secondaryRays += other.secondaryRays;
+    }
+};
+
+// Last shape found blocking each light, kept while one tile is rendered.
+// Neighbouring pixels tend to be shadowed by the same shape, so it is tested
+// first and a shadow ray in a shadowed area usually ends after one primitive.
+// Built per tile (and thread); lights are numbered by the caller.
+class ShadowCache {
+    public:
+        explicit ShadowCache(size_t lights) : lastOccluder(lights, -1) {}
+
+        // Whether anything blocks ray in [tMin, tMax] on its way to light
+        bool occluded(const Scene& scene, int light, const Ray& ray, double tMin, double tMax) {
+            int& last = lastOccluder[light];
+            if (last >= 0 && scene.occludedBy(last, ray, tMin, tMax)) {
+                return true;
+            }
+            int blocker;
+            if (!scene.occluded(ray, tMin, tMax, &blocker)) {
+                return false; // The last occluder is kept for the next penumbra
+            }
+            last = blocker;
+            return true;
+        }
+
+    private:
+        std::vector<int> lastOccluder; // Shape index, -1 for none
+};
+
+class RenderProfile;
+
+// Receives every tile whose pixels are final, from the worker threads: its
+// HDR values, row major with tile.width() per row (e.g. TiledPNGOutput)
+using TileSink = std::function<void(const Tile&, const PixelRGB*)>;
+
+struct RenderOptions {
+    unsigned threads = 0;   // 0 = every hardware thread
+    int tileSize = 32;      // Tile side in pixels
+    bool progress = true;   // Report progress and throughput on stderr
+    bool packets = true;    // Trace primary rays in packets of RayPacket::SIZE
+    PrimitiveStore::Precision precision = PrimitiveStore::Precision::Double; // Of the analytic shape kernels
+    TileSink sink;          // Optional
+    TileSink update;        // Optional: every tile each time its pixels change (e.g. PreviewServer)
+    std::vector<int> onlyTiles; // Indices in makeTiles order of the tiles to render, empty = all
+    RenderProfile* profile = nullptr; // Optional: receives the cost of every tile
+};
+
+// Tiles of a width x height image the options ask for
+std::vector<Tile> selectTiles(int width, int height, const RenderOptions& options);
+
+// Direct lighting at a primary hit: emission plus the unoccluded point lights
+// (Lambertian reflection). Without lights a headlight shading is used instead.
+// Light i of the scene uses slot i of shadows.
+PixelRGB shadePrimaryHit(const Scene& scene, const Ray& ray, const HitRecord& hit, ShadowCache& shadows,
+                         RenderStats& stats);
+
+// Casts one primary ray through the centre of each pixel of the tiles of the
+// options, at shutter open (moving shapes are not blurred). Tiles are
+// distributed over the scheduler threads and only handed to the sinks of the
+// options as they finish; no image is kept.
+void renderPrimaryTiles(const Scene& scene, const Camera& camera, TileScheduler& scheduler,
+                        const RenderOptions& options, RenderStats& stats);
+
+// renderPrimaryTiles collected in the HDR image it returns
+Image renderPrimary(const Scene& scene, const Camera& camera, TileScheduler& scheduler,
+                    const RenderOptions& options, RenderStats& stats);
+
+// output without its extension: renders are saved as <stem>.exr and <stem>.png
+std::string renderStem(const std::string& output);
+
+#endif // RENDERER_HPP
@@ -0,0 +1,236 @@
+#include "sampler.hpp"
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+// Bases of the Halton dimensions; later dimensions fall back to Philox
+const uint32_t PRIMES[] = {
+    2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53,
+    59, 61, 67, 71, 73, 79, 83, 89, 97, 101, 103, 107, 109, 113, 127, 131
+};
+const uint32_t NUM_PRIMES = sizeof(PRIMES) / sizeof(PRIMES[0]);
+
+// Philox blocks evaluated together by philoxUniformBatch
+const int PHILOX_LANES = 8;
+
+// Key of the Philox stream used by the samplers (second word)
+const uint32_t SAMPLER_KEY = 0x5A3C17E9u;
+
+// Width of the Gaussian used to measure clusters and voids of the mask
+const double BLUE_NOISE_SIGMA = 1.5;
+
+double wrapUnit(double x) {
+    return x >= 1.0 ? x - 1.0 : x;
+}
+
+// Power of two, so offsets wrap with a mask
+static_assert((BLUE_NOISE_SIZE & (BLUE_NOISE_SIZE - 1)) == 0, "BLUE_NOISE_SIZE must be a power of two");
+
+// Void and cluster (Ulichney 1993), progressive part: every pixel is ranked
+// by repeatedly taking the largest void, i.e. the free pixel with the least
+// Gaussian energy from the pixels already ranked (on a torus, so the mask tiles).
+vector<float> buildBlueNoise() {
+    const int size = BLUE_NOISE_SIZE;
+    const int count = size * size;
+
+    // Toroidal Gaussian by offset
+    vector<double> kernel(count);
+    for (int dy = 0; dy < size; ++dy) {
+        for (int dx = 0; dx < size; ++dx) {
+            int wx = min(dx, size - dx), wy = min(dy, size - dy);
+            kernel[dy * size + dx] = exp(-(wx * wx + wy * wy) / (2.0 * BLUE_NOISE_SIGMA * BLUE_NOISE_SIGMA));
+        }
+    }
+
+    // A tiny random energy breaks the ties of the first, empty, steps
+    Pcg32 rng(0xB1E5EEDull);
+    vector<double> energy(count);
+    for (double& e : energy) {
+        e = 1e-9 * rng.nextDouble();
+    }
+
+    vector<float> mask(count);
+    vector<char> ranked(count, 0);
+    for (int rank = 0; rank < count; ++rank) {
+        int best = -1;
+        double bestEnergy = numeric_limits<double>::infinity();
+        for (int i = 0; i < count; ++i) {
+            if (!ranked[i] && energy[i] < bestEnergy) {
+                bestEnergy = energy[i];
+                best = i;
+            }
+        }
+
+        ranked[best] = 1;
+        mask[best] = static_cast<float>((rank + 0.5) / count);
+
+        int bx = best % size, by = best / size;
+        for (int y = 0; y < size; ++y) {
+            const double* row = &kernel[((y - by) & (size - 1)) * size];
+            for (int x = 0; x < size; ++x) {
+                energy[y * size + x] += row[(x - bx) & (size - 1)];
+            }
+        }
+    }
+    return mask;
+}
+
+} // namespace
+
+void philoxUniformBatch(uint64_t key, uint64_t counter, int count, double* out) {
+    const uint32_t key0 = static_cast<uint32_t>(key), key1 = static_cast<uint32_t>(key >> 32);
+
+    for (int done = 0; done < count; done += 4 * PHILOX_LANES) {
+        uint32_t c0[PHILOX_LANES], c1[PHILOX_LANES], c2[PHILOX_LANES], c3[PHILOX_LANES];
+        for (int lane = 0; lane < PHILOX_LANES; ++lane) {
+            uint64_t c = counter + done / 4 + lane;
+            c0[lane] = static_cast<uint32_t>(c);
+            c1[lane] = static_cast<uint32_t>(c >> 32);
+            c2[lane] = 0;
+            c3[lane] = 0;
+        }
+
+        // Same rounds as philox4x32, lane by lane
+        uint32_t k0 = key0, k1 = key1;
+        for (int round = 0; round < 10; ++round) {
+            for (int lane = 0; lane < PHILOX_LANES; ++lane) {
+                uint64_t p0 = static_cast<uint64_t>(0xD2511F53u) * c0[lane];
+                uint64_t p1 = static_cast<uint64_t>(0xCD9E8D57u) * c2[lane];
+                uint32_t n0 = static_cast<uint32_t>(p1 >> 32) ^ c1[lane] ^ k0;
+                uint32_t n2 = static_cast<uint32_t>(p0 >> 32) ^ c3[lane] ^ k1;
+                c1[lane] = static_cast<uint32_t>(p1);
+                c3[lane] = static_cast<uint32_t>(p0);
+                c0[lane] = n0;
+                c2[lane] = n2;
+            }
+            k0 += 0x9E3779B9u;
+            k1 += 0xBB67AE85u;
+        }
+
+        for (int lane = 0; lane < PHILOX_LANES; ++lane) {
+            const uint32_t words[4] = { c0[lane], c1[lane], c2[lane], c3[lane] };
+            for (int w = 0; w < 4; ++w) {
+                int i = done + 4 * lane + w;
+                if (i < count) {
+                    out[i] = toUnit(words[w]);
+                }
+            }
+        }
+    }
+}
+
+double radicalInverse(uint32_t base, uint32_t index) {
+    const double invBase = 1.0 / base;
+    double result = 0.0, scale = invBase;
+    while (index > 0) {
+        result += (index % base) * scale;
+        index /= base;
+        scale *= invBase;
+    }
+    return result;
+}
+
+const float* blueNoiseMask() {
+    static const vector<float> mask = buildBlueNoise();
+    return mask.data();
+}
+
+SamplerType parseSamplerType(const std::string& name) {
+    if (name == "random") {
+        return SamplerType::Random;
+    } else if (name == "sobol") {
+        return SamplerType::Sobol;
+    } else if (name == "halton") {
+        return SamplerType::Halton;
+    } else if (name == "bluenoise") {
+        return SamplerType::BlueNoise;
+    }
+    throw invalid_argument("Muestreador desconocido '" + name + "' (random, sobol, halton o bluenoise).");
+}
+
+const char* samplerName(SamplerType type) {
+    switch (type) {
+        case SamplerType::Random: return "random";
+        case SamplerType::Sobol: return "sobol";
+        case SamplerType::Halton: return "halton";
+        case SamplerType::BlueNoise: return "bluenoise";
+    }
+    return "?";
+}
+
+double Sampler::randomUniform() {
+    // Dimensions are generated RANDOM_BATCH at a time, keyed by the pixel
+    // and counted by (sample index, dimension)
+    if (dimension % RANDOM_BATCH == 0) {
+        uint64_t key = static_cast<uint64_t>(pixelSeed) << 32 | seed;
+        uint64_t counter = static_cast<uint64_t>(index) << 32 | dimension / 4;
+        philoxUniformBatch(key, counter, RANDOM_BATCH, batch);
+    }
+    return batch[dimension++ % RANDOM_BATCH];
+}
+
+double Sampler::blueNoise(uint32_t dimensionSeed) const {
+    const uint32_t wrap = BLUE_NOISE_SIZE - 1;
+    uint32_t offset = hashCombine(dimensionSeed, 3);
+    uint32_t x = (px + offset) & wrap, y = (py + (offset >> 16)) & wrap;
+    return blueNoiseMask()[y * BLUE_NOISE_SIZE + x];
+}
+
+double Sampler::get1D() {
+    switch (type) {
+        case SamplerType::Random:
+            return randomUniform();
+
+        case SamplerType::Sobol:
+        case SamplerType::BlueNoise: {
+            // Blue noise shares the sequence between pixels (see get2D)
+            uint32_t dimensionSeed = hashCombine(type == SamplerType::Sobol ? pixelSeed : seed, dimension++);
+            uint32_t i = owenScramble(index, dimensionSeed);
+            double u = toUnit(owenScramble(reverseBits(i), hashCombine(dimensionSeed, 1)));
+            return type == SamplerType::Sobol ? u : wrapUnit(u + blueNoise(dimensionSeed));
+        }
+
+        case SamplerType::Halton: {
+            uint32_t d = dimension++;
+            if (d >= NUM_PRIMES) {
+                uint32_t ctr[4] = { px, py, index, 0x80000000u | d };
+                philox4x32(ctr, seed, SAMPLER_KEY);
+                return toUnit(ctr[0]);
+            }
+            return wrapUnit(radicalInverse(PRIMES[d], index) + toUnit(hashCombine(pixelSeed, d)));
+        }
+    }
+    return 0.0;
+}
+
+void Sampler::get2D(double& u, double& v) {
+    switch (type) {
+        case SamplerType::Random:
+        case SamplerType::Halton:
+            u = get1D();
+            v = get1D();
+            return;
+
+        case SamplerType::Sobol:
+        case SamplerType::BlueNoise: {
+            // Each pair of dimensions gets its own index shuffle and scrambling.
+            // Blue noise uses the same sequence in every pixel, offset by the
+            // mask so the error of neighbouring pixels is decorrelated.
+            uint32_t pairSeed = hashCombine(type == SamplerType::Sobol ? pixelSeed : seed, dimension);
+            dimension += 2;
+            uint32_t i = owenScramble(index, pairSeed);
+            u = toUnit(owenScramble(reverseBits(i), hashCombine(pairSeed, 1)));
+            v = toUnit(owenScramble(sobolSecond(i), hashCombine(pairSeed, 2)));
+            if (type == SamplerType::BlueNoise) {
+                u = wrapUnit(u + blueNoise(pairSeed));
+                v = wrapUnit(v + blueNoise(hashCombine(pairSeed, 4)));
+            }
+            return;
+        }
+    }
+}
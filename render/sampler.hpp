@@ -0,0 +1,191 @@
+#ifndef SAMPLER_HPP
+#define SAMPLER_HPP
+
+#include <cstdint>
+#include <string>
+
+// Random numbers and low discrepancy sequences for the path tracer. The
+// generators are small and called for every path vertex, so the hot parts
+// are implemented inline.
+
+// 32 bit integer hash with good avalanche (lowbias32, C. Wellons)
+inline uint32_t mixBits(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+inline uint32_t hashCombine(uint32_t seed, uint32_t value) {
+    return mixBits(seed ^ mixBits(value + 0x9e3779b9u));
+}
+
+// [0, 1) from the 32 bits of x (never returns 1)
+inline double toUnit(uint32_t x) {
+    return x * 0x1p-32;
+}
+
+// PCG32 (O'Neill): 16 bytes of state, for sequential streams
+class Pcg32 {
+    public:
+        explicit Pcg32(uint64_t seed = 0, uint64_t stream = 0) : state(0), inc((stream << 1) | 1) {
+            next();
+            state += seed;
+            next();
+        }
+
+        uint32_t next() {
+            uint64_t old = state;
+            state = old * 6364136223846793005ull + inc;
+            uint32_t xorShifted = static_cast<uint32_t>(((old >> 18) ^ old) >> 27);
+            uint32_t rot = static_cast<uint32_t>(old >> 59);
+            return (xorShifted >> rot) | (xorShifted << ((32 - rot) & 31));
+        }
+
+        double nextDouble() { return toUnit(next()); }
+
+    private:
+        uint64_t state;
+        uint64_t inc;
+};
+
+// Philox4x32-10 (Salmon et al. 2011): counter based, so any (counter, key)
+// can be evaluated directly without sequential state. ctr is replaced by
+// the four output words.
+inline void philox4x32(uint32_t ctr[4], uint32_t key0, uint32_t key1) {
+    for (int round = 0; round < 10; ++round) {
+        uint64_t p0 = static_cast<uint64_t>(0xD2511F53u) * ctr[0];
+        uint64_t p1 = static_cast<uint64_t>(0xCD9E8D57u) * ctr[2];
+        uint32_t hi0 = static_cast<uint32_t>(p0 >> 32), lo0 = static_cast<uint32_t>(p0);
+        uint32_t hi1 = static_cast<uint32_t>(p1 >> 32), lo1 = static_cast<uint32_t>(p1);
+        ctr[0] = hi1 ^ ctr[1] ^ key0;
+        ctr[1] = lo1;
+        ctr[2] = hi0 ^ ctr[3] ^ key1;
+        ctr[3] = lo0;
+        key0 += 0x9E3779B9u;
+        key1 += 0xBB67AE85u;
+    }
+}
+
+// Fills out[0..count) with uniforms from the Philox blocks at counters
+// (counter, counter + 1, ...) under key. Blocks are evaluated several at a
+// time in structure of arrays form so the rounds vectorise.
+void philoxUniformBatch(uint64_t key, uint64_t counter, int count, double* out);
+
+// Reverses the 32 bits of x
+inline uint32_t reverseBits(uint32_t x) {
+    x = (x << 16) | (x >> 16);
+    x = ((x & 0x00ff00ffu) << 8) | ((x & 0xff00ff00u) >> 8);
+    x = ((x & 0x0f0f0f0fu) << 4) | ((x & 0xf0f0f0f0u) >> 4);
+    x = ((x & 0x33333333u) << 2) | ((x & 0xccccccccu) >> 2);
+    x = ((x & 0x55555555u) << 1) | ((x & 0xaaaaaaaau) >> 1);
+    return x;
+}
+
+// Generator matrix of the second Sobol dimension applied to every byte
+// value at every byte position, built at compile time
+struct SobolTables {
+    uint32_t values[4][256] = {};
+
+    constexpr SobolTables() {
+        // Direction numbers of the dimension: v0 = 1/2, v(k+1) = vk ^ (vk >> 1)
+        uint32_t directions[32] = {};
+        uint32_t v = 1u << 31;
+        for (int bit = 0; bit < 32; ++bit, v ^= v >> 1) {
+            directions[bit] = v;
+        }
+        for (int byte = 0; byte < 4; ++byte) {
+            for (uint32_t bits = 0; bits < 256; ++bits) {
+                uint32_t result = 0;
+                for (int k = 0; k < 8; ++k) {
+                    if (bits & (1u << k)) {
+                        result ^= directions[8 * byte + k];
+                    }
+                }
+                values[byte][bits] = result;
+            }
+        }
+    }
+};
+
+inline constexpr SobolTables SOBOL_SECOND_TABLES;
+
+// Second dimension of the Sobol sequence (the first one is reverseBits).
+// The matrix is linear over GF(2), so it is applied a byte at a time.
+inline uint32_t sobolSecond(uint32_t index) {
+    const auto& t = SOBOL_SECOND_TABLES.values;
+    return t[0][index & 0xff] ^ t[1][(index >> 8) & 0xff] ^ t[2][(index >> 16) & 0xff] ^ t[3][index >> 24];
+}
+
+// Hash based Owen scrambling of a 32 bit fixed point value (Burley 2020)
+inline uint32_t owenScramble(uint32_t x, uint32_t seed) {
+    x = reverseBits(x);
+    x += seed;
+    x ^= x * 0x6c50b47cu;
+    x ^= x * 0xb82f1e52u;
+    x ^= x * 0xc7afe638u;
+    x ^= x * 0x8d22f6e6u;
+    return reverseBits(x);
+}
+
+// Radical inverse of index in the given prime base
+double radicalInverse(uint32_t base, uint32_t index);
+
+// 64x64 tileable blue noise mask with values in (0, 1), built once on first use
+const float* blueNoiseMask();
+const int BLUE_NOISE_SIZE = 64;
+
+enum class SamplerType {
+    Random,    // Philox, independent per pixel, sample and dimension
+    Sobol,     // Padded 2D Sobol with per pixel Owen scrambling
+    Halton,    // Halton with per pixel Cranley-Patterson rotation
+    BlueNoise  // Sobol shared by every pixel, rotated by a blue noise mask
+};
+
+// Throws invalid_argument for unknown names
+SamplerType parseSamplerType(const std::string& name);
+const char* samplerName(SamplerType type);
+
+// Samples of one pixel sample, drawn dimension by dimension. The values only
+// depend on (seed, pixel, sample index, dimension), never on the tile or the
+// thread rendering it, so renders are reproducible with any thread count.
+// Sample indices are consecutive per pixel: index i of a progressive render
+// continues the sequence of the previous i samples.
+class Sampler {
+    public:
+        explicit Sampler(SamplerType type_ = SamplerType::Sobol, uint32_t seed_ = 0) : type(type_), seed(seed_) {}
+
+        void startPixel(int x, int y, uint32_t sampleIndex) {
+            px = static_cast<uint32_t>(x);
+            py = static_cast<uint32_t>(y);
+            index = sampleIndex;
+            dimension = 0;
+            pixelSeed = hashCombine(hashCombine(seed, px), py);
+        }
+
+        double get1D();
+        void get2D(double& u, double& v);
+
+        SamplerType getType() const { return type; }
+
+    private:
+        SamplerType type;
+        uint32_t seed;
+        uint32_t px = 0, py = 0;
+        uint32_t index = 0;
+        uint32_t dimension = 0;
+        uint32_t pixelSeed = 0;
+
+        // Random: uniforms for dimensions [dimension - dimension % RANDOM_BATCH, + RANDOM_BATCH)
+        static const int RANDOM_BATCH = 32;
+        double batch[RANDOM_BATCH];
+
+        double randomUniform();
+
+        // Mask value of this pixel for a dimension (toroidal offset per dimension)
+        double blueNoise(uint32_t dimensionSeed) const;
+};
+
+#endif // SAMPLER_HPP
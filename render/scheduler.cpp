@@ -0,0 +1,247 @@
+#include "scheduler.hpp"
+#include <algorithm>
+
+using namespace std;
+
+vector<Tile> makeTiles(int width, int height, int tileSize) {
+    tileSize = max(1, tileSize);
+    vector<Tile> tiles;
+    for (int y = 0; y < height; y += tileSize) {
+        for (int x = 0; x < width; x += tileSize) {
+            Tile tile;
+            tile.x0 = x;
+            tile.y0 = y;
+            tile.x1 = min(width, x + tileSize);
+            tile.y1 = min(height, y + tileSize);
+            tile.index = static_cast<int>(tiles.size());
+            tiles.push_back(tile);
+        }
+    }
+    return tiles;
+}
+
+// ---------------------------------------------------------------------------
+// ScratchArena
+// ---------------------------------------------------------------------------
+
+ScratchArena::ScratchArena(size_t blockSize_) : offset(0), blockSize(blockSize_) {
+    blocks.emplace_back(new unsigned char[blockSize]);
+    blockSizes.push_back(blockSize);
+}
+
+void* ScratchArena::allocate(size_t bytes, size_t alignment) {
+    uintptr_t base = reinterpret_cast<uintptr_t>(blocks.back().get());
+    uintptr_t address = (base + offset + alignment - 1) / alignment * alignment;
+    if (address + bytes > base + blockSizes.back()) {
+        // New block big enough for this request (plus worst case alignment)
+        size_t size = max(blockSize, bytes + alignment);
+        blocks.emplace_back(new unsigned char[size]);
+        blockSizes.push_back(size);
+        base = reinterpret_cast<uintptr_t>(blocks.back().get());
+        address = (base + alignment - 1) / alignment * alignment;
+    }
+
+    offset = address + bytes - base;
+    return reinterpret_cast<void*>(address);
+}
+
+void ScratchArena::reset() {
+    if (blocks.size() > 1) {
+        size_t total = 0;
+        for (size_t size : blockSizes) {
+            total += size;
+        }
+        blocks.clear();
+        blockSizes.clear();
+        blocks.emplace_back(new unsigned char[total]);
+        blockSizes.push_back(total);
+    }
+    offset = 0;
+}
+
+// ---------------------------------------------------------------------------
+// TileScheduler
+// ---------------------------------------------------------------------------
+
+TileScheduler::TileScheduler(unsigned numThreads, double progressInterval_)
+    : generation(0), running(0), stopping(false), tiles(nullptr), task(nullptr), progress(nullptr),
+      tilesDone(0), cancelled(false), progressInterval(progressInterval_)
+{
+    if (numThreads == 0) {
+        numThreads = max(1u, thread::hardware_concurrency());
+    }
+    for (unsigned i = 0; i < numThreads; ++i) {
+        workers.emplace_back(new Worker());
+        workers.back()->rngState = 0x9E3779B97F4A7C15ull * (i + 1);
+    }
+    // Worker 0 is the thread calling run()
+    for (unsigned i = 1; i < numThreads; ++i) {
+        threads.emplace_back(&TileScheduler::workerLoop, this, i);
+    }
+}
+
+TileScheduler::~TileScheduler() {
+    {
+        lock_guard<mutex> lock(poolMutex);
+        stopping = true;
+    }
+    wakeUp.notify_all();
+    for (auto& t : threads) {
+        t.join();
+    }
+}
+
+void TileScheduler::run(const vector<Tile>& tiles_, const TileTask& task_, const ProgressCallback& progress_) {
+    if (tiles_.empty()) {
+        return;
+    }
+
+    // Seed every deque with a contiguous block of tiles, so neighbouring
+    // tiles (and their geometry) tend to stay on the same core
+    const size_t numWorkers = workers.size();
+    for (size_t w = 0; w < numWorkers; ++w) {
+        size_t first = tiles_.size() * w / numWorkers;
+        size_t last = tiles_.size() * (w + 1) / numWorkers;
+        lock_guard<mutex> lock(workers[w]->mutex);
+        workers[w]->queue.clear();
+        for (size_t t = first; t < last; ++t) {
+            workers[w]->queue.push_back(static_cast<int>(t));
+        }
+    }
+
+    tiles = &tiles_;
+    task = &task_;
+    progress = progress_ ? &progress_ : nullptr;
+    tilesDone = 0;
+    cancelled = false;
+    error = nullptr;
+    lastProgress = chrono::steady_clock::now();
+
+    {
+        lock_guard<mutex> lock(poolMutex);
+        running = static_cast<unsigned>(threads.size());
+        generation++;
+    }
+    wakeUp.notify_all();
+
+    work(0);
+
+    {
+        unique_lock<mutex> lock(poolMutex);
+        finished.wait(lock, [this]() { return running == 0; });
+    }
+    if (progress && !cancelled) {
+        reportProgress(true);
+    }
+
+    tiles = nullptr;
+    task = nullptr;
+    progress = nullptr;
+    if (error) {
+        rethrow_exception(error);
+    }
+}
+
+void TileScheduler::workerLoop(unsigned index) {
+    uint64_t seen = 0;
+    while (true) {
+        {
+            unique_lock<mutex> lock(poolMutex);
+            wakeUp.wait(lock, [&]() { return stopping || generation != seen; });
+            if (stopping) {
+                return;
+            }
+            seen = generation;
+        }
+
+        work(index);
+
+        {
+            lock_guard<mutex> lock(poolMutex);
+            running--;
+        }
+        finished.notify_one();
+    }
+}
+
+void TileScheduler::work(unsigned index) {
+    Worker& worker = *workers[index];
+    TileContext context{ index, worker.arena };
+
+    int tile;
+    while (!cancelled && (popTile(index, tile) || stealTile(index, tile))) {
+        worker.arena.reset();
+        try {
+            (*task)((*tiles)[tile], context);
+        } catch (...) {
+            lock_guard<mutex> lock(poolMutex);
+            if (!error) {
+                error = current_exception();
+            }
+            cancelled = true;
+            return;
+        }
+
+        tilesDone.fetch_add(1, memory_order_relaxed);
+        if (progress) {
+            reportProgress(false);
+        }
+    }
+}
+
+bool TileScheduler::popTile(unsigned index, int& tile) {
+    Worker& worker = *workers[index];
+    lock_guard<mutex> lock(worker.mutex);
+    if (worker.queue.empty()) {
+        return false;
+    }
+    tile = worker.queue.front();
+    worker.queue.pop_front();
+    return true;
+}
+
+bool TileScheduler::stealTile(unsigned index, int& tile) {
+    const unsigned numWorkers = threadCount();
+    if (numWorkers < 2) {
+        return false;
+    }
+
+    // Start at a random victim and try everybody once. Tiles are never
+    // added during a run, so finding every queue empty means we are done.
+    uint64_t& state = workers[index]->rngState;
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    unsigned start = static_cast<unsigned>(state % numWorkers);
+
+    for (unsigned k = 0; k < numWorkers; ++k) {
+        unsigned victim = (start + k) % numWorkers;
+        if (victim == index) {
+            continue;
+        }
+        Worker& other = *workers[victim];
+        lock_guard<mutex> lock(other.mutex);
+        if (!other.queue.empty()) {
+            tile = other.queue.back();
+            other.queue.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
+
+void TileScheduler::reportProgress(bool force) {
+    // Only one thread reports at a time; the others just keep rendering
+    unique_lock<mutex> lock(progressMutex, defer_lock);
+    if (force) {
+        lock.lock();
+    } else if (!lock.try_lock()) {
+        return;
+    }
+
+    auto now = chrono::steady_clock::now();
+    if (force || chrono::duration<double>(now - lastProgress).count() >= progressInterval) {
+        lastProgress = now;
+        (*progress)(tilesDone.load(memory_order_relaxed), static_cast<int>(tiles->size()));
+    }
+}
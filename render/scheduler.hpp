@@ -0,0 +1,119 @@
+#ifndef SCHEDULER_HPP
+#define SCHEDULER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Rectangle of pixels [x0, x1) x [y0, y1)
+struct Tile {
+    int x0, y0, x1, y1;
+    int index;
+
+    int width() const { return x1 - x0; }
+    int height() const { return y1 - y0; }
+    int pixels() const { return width() * height(); }
+};
+
+// Splits an image in square tiles (the last row/column may be smaller)
+std::vector<Tile> makeTiles(int width, int height, int tileSize);
+
+// Bump allocator owned by one thread. Memory is released all at once with
+// reset(), typically after each tile, so the hot path never calls malloc.
+class ScratchArena {
+    public:
+        explicit ScratchArena(size_t blockSize = 1 << 20);
+
+        void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+
+        // Uninitialized array of n trivially constructible values
+        template <typename T>
+        T* allocateArray(size_t n) { return static_cast<T*>(allocate(n * sizeof(T), alignof(T))); }
+
+        // Frees everything. If several blocks were needed, they are merged in a
+        // single bigger one so the next round fits without extra allocations.
+        void reset();
+
+    private:
+        std::vector<std::unique_ptr<unsigned char[]>> blocks;
+        std::vector<size_t> blockSizes;
+        size_t offset;
+        size_t blockSize;
+};
+
+// Per-thread context handed to every tile task
+struct TileContext {
+    unsigned thread;      // Worker index in [0, threadCount())
+    ScratchArena& arena;  // Reset before every tile
+};
+
+// Persistent thread pool that renders tiles with work stealing. Every worker
+// owns a deque seeded with a contiguous range of tiles; it pops its own work
+// from the front and, once empty, steals from the back of a random victim.
+// The calling thread takes part as worker 0.
+class TileScheduler {
+    public:
+        using TileTask = std::function<void(const Tile&, TileContext&)>;
+        // Called at most every progressInterval seconds with (tiles done, total)
+        using ProgressCallback = std::function<void(int, int)>;
+
+        // threads = 0 uses every hardware thread
+        explicit TileScheduler(unsigned threads = 0, double progressInterval_ = 0.5);
+        ~TileScheduler();
+
+        TileScheduler(const TileScheduler&) = delete;
+        TileScheduler& operator=(const TileScheduler&) = delete;
+
+        unsigned threadCount() const { return static_cast<unsigned>(workers.size()); }
+
+        // Runs task on every tile and blocks until all are done. The first
+        // exception thrown by a task cancels the remaining tiles and is rethrown.
+        void run(const std::vector<Tile>& tiles, const TileTask& task, const ProgressCallback& progress = nullptr);
+
+    private:
+        struct alignas(64) Worker {
+            std::mutex mutex;
+            std::deque<int> queue;
+            ScratchArena arena;
+            uint64_t rngState;
+        };
+
+        std::vector<std::unique_ptr<Worker>> workers;
+        std::vector<std::thread> threads;
+
+        // Pool synchronisation
+        std::mutex poolMutex;
+        std::condition_variable wakeUp;
+        std::condition_variable finished;
+        uint64_t generation;
+        unsigned running;
+        bool stopping;
+
+        // Current job
+        const std::vector<Tile>* tiles;
+        const TileTask* task;
+        const ProgressCallback* progress;
+        std::atomic<int> tilesDone;
+        std::atomic<bool> cancelled;
+        std::exception_ptr error;
+        std::mutex progressMutex;
+        std::chrono::steady_clock::time_point lastProgress;
+        double progressInterval;
+
+        void workerLoop(unsigned index);
+        void work(unsigned index);
+        bool popTile(unsigned index, int& tile);
+        bool stealTile(unsigned index, int& tile);
+        void reportProgress(bool force);
+};
+
+#endif // SCHEDULER_HPP
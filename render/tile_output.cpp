@@ -0,0 +1,82 @@
+#include "tile_output.hpp"
+#include <algorithm>
+#include <iostream>
+
+using namespace std;
+
+TiledPNGOutput::TiledPNGOutput(const std::string& filename_, int width_, int height_, const ToneMap& toneMap_)
+    : filename(filename_), width(width_), height(height_), toneMap(toneMap_),
+      ldr(static_cast<size_t>(width_) * height_ * 3), mapped(static_cast<size_t>(width_) * height_),
+      rowPixels(height_), png(filename_, width_, height_) {}
+
+void TiledPNGOutput::addTile(const Tile& tile, const PixelRGB* pixels) {
+    if (!toneMap.local()) {
+        return;
+    }
+
+    // Tiles never overlap, so mapping needs no lock; only the bookkeeping does
+    {
+        lock_guard<std::mutex> lock(mutex);
+        if (mapped[static_cast<size_t>(tile.y0) * width + tile.x0]) {
+            return;
+        }
+        for (int y = tile.y0; y < tile.y1; ++y) {
+            fill_n(mapped.begin() + static_cast<size_t>(y) * width + tile.x0, tile.width(), 1);
+        }
+    }
+    for (int y = tile.y0; y < tile.y1; ++y) {
+        const PixelRGB* row = pixels + (y - tile.y0) * tile.width();
+        uint8_t* out = &ldr[(static_cast<size_t>(y) * width + tile.x0) * 3];
+        for (int x = 0; x < tile.width(); ++x) {
+            toneMap.mapPixel(row[x], out + 3 * x);
+        }
+    }
+
+    lock_guard<std::mutex> lock(mutex);
+    for (int y = tile.y0; y < tile.y1; ++y) {
+        rowPixels[y] += tile.width();
+    }
+    flushRows();
+}
+
+void TiledPNGOutput::finish(const Image& hdr) {
+    lock_guard<std::mutex> lock(mutex);
+    if (toneMap.local()) {
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                size_t i = static_cast<size_t>(y) * width + x;
+                if (!mapped[i]) {
+                    toneMap.mapPixel(hdr.imagen[y][x], &ldr[3 * i]);
+                    mapped[i] = 1;
+                    rowPixels[y]++;
+                }
+            }
+        }
+    } else {
+        Image result = toneMap.apply(hdr);
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                const PixelRGB& pixel = result.imagen[y][x];
+                uint8_t* out = &ldr[(static_cast<size_t>(y) * width + x) * 3];
+                out[0] = static_cast<uint8_t>(pixel.R);
+                out[1] = static_cast<uint8_t>(pixel.G);
+                out[2] = static_cast<uint8_t>(pixel.B);
+            }
+            rowPixels[y] = width;
+        }
+    }
+    flushRows();
+    png.finish();
+
+    cout << "LDR image saved successfully as: " << filename << endl;
+}
+
+void TiledPNGOutput::flushRows() {
+    int first = png.rowsWritten(), end = first;
+    while (end < height && rowPixels[end] == width) {
+        ++end;
+    }
+    if (end > first) {
+        png.writeRows(&ldr[static_cast<size_t>(first) * width * 3], end - first);
+    }
+}
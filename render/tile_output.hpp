@@ -0,0 +1,47 @@
+#ifndef TILE_OUTPUT_HPP
+#define TILE_OUTPUT_HPP
+
+#include "scheduler.hpp"
+#include "../imaging/image.hpp"
+#include "../imaging/png_writer.hpp"
+#include "../imaging/tone_map.hpp"
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// PNG preview of a render built while the tiles finish. With a local tone
+// map every tile is mapped to 8 bits as soon as its pixels are final, and
+// each image row is compressed and written once all the tiles crossing it
+// are in, so the file is complete right after the last tile. Operators that
+// need statistics of the whole image map everything in finish().
+class TiledPNGOutput {
+    public:
+        // Creates the file (removed again if finish() is never reached)
+        TiledPNGOutput(const std::string& filename_, int width_, int height_, const ToneMap& toneMap_);
+
+        // Final HDR pixels of a tile, row major with tile.width() per row.
+        // Thread safe; tiles may arrive in any order, repeated ones are ignored.
+        void addTile(const Tile& tile, const PixelRGB* pixels);
+
+        // Maps the pixels no tile delivered (every pixel for a global tone
+        // map) from the full image and completes the file
+        void finish(const Image& hdr);
+
+        const std::string& path() const { return filename; }
+
+    private:
+        std::string filename;
+        int width, height;
+        ToneMap toneMap;
+        std::vector<uint8_t> ldr;        // 8 bit RGB framebuffer, row major
+        std::vector<uint8_t> mapped;     // Per pixel: written to ldr by a tile
+        std::vector<int> rowPixels;      // Per row: pixels mapped so far
+        PNGWriter png;
+        std::mutex mutex;
+
+        // Writes the complete rows that follow the last written one (mutex held)
+        void flushRows();
+};
+
+#endif // TILE_OUTPUT_HPP
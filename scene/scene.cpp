@@ -0,0 +1,298 @@
+#include "scene.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+
+Scene::Scene() {
+    Material defaultMaterial;
+    defaultMaterial.name = "default";
+    addMaterial(defaultMaterial);
+}
+
+int Scene::addShape(const string& name, unique_ptr<GeometricShape> shape, int material) {
+    if (shapeIndex.count(name)) {
+        throw invalid_argument("Ya existe una forma con el nombre '" + name + "'");
+    }
+    if (material < 0 || material >= static_cast<int>(materials.size())) {
+        throw invalid_argument("Material inexistente para la forma '" + name + "'");
+    }
+
+    int index = static_cast<int>(shapes.size());
+    shapes.push_back(std::move(shape));
+    names.push_back(name);
+    shapeMaterials.push_back(material);
+    shapeIndex[name] = index;
+    return index;
+}
+
+int Scene::addMaterial(const Material& material) {
+    if (materialIndex.count(material.name)) {
+        throw invalid_argument("Ya existe un material con el nombre '" + material.name + "'");
+    }
+
+    int index = static_cast<int>(materials.size());
+    materials.push_back(material);
+    materialIndex[material.name] = index;
+    return index;
+}
+
+int Scene::addObject(const string& name, shared_ptr<const GeometricShape> object) {
+    if (objectIndex.count(name)) {
+        throw invalid_argument("Ya existe un objeto con el nombre '" + name + "'");
+    }
+
+    int index = static_cast<int>(objects.size());
+    objects.push_back(std::move(object));
+    objectNames.push_back(name);
+    objectIndex[name] = index;
+    return index;
+}
+
+int Scene::findShape(const string& name) const {
+    auto it = shapeIndex.find(name);
+    return it == shapeIndex.end() ? -1 : it->second;
+}
+
+int Scene::findMaterial(const string& name) const {
+    auto it = materialIndex.find(name);
+    return it == materialIndex.end() ? -1 : it->second;
+}
+
+int Scene::findObject(const string& name) const {
+    auto it = objectIndex.find(name);
+    return it == objectIndex.end() ? -1 : it->second;
+}
+
+void Scene::build() {
+    boundedShapes.clear();
+    unboundedShapes.clear();
+
+    vector<BoundingBox> shapeBounds, closeBounds;
+    bool moving = false;
+    for (size_t i = 0; i < shapes.size(); ++i) {
+        if (shapes[i]->isBounded()) {
+            boundedShapes.push_back(static_cast<int>(i));
+            BoundingBox open, close;
+            shapes[i]->motionBounds(open, close);
+            shapeBounds.push_back(open);
+            closeBounds.push_back(close);
+            moving = moving || shapes[i]->isMoving();
+        } else {
+            unboundedShapes.push_back(static_cast<int>(i));
+        }
+    }
+    // Static scenes keep the plain hierarchy and its traversal
+    if (moving) {
+        bvh.build(shapeBounds, closeBounds, 1);
+    } else {
+        bvh.build(shapeBounds, 1);
+    }
+    buildPrimitives();
+}
+
+void Scene::buildPrimitives() {
+    primitives.clear();
+    boundedPrimitives.clear();
+    unboundedPrimitives.clear();
+    shapePrimitives.assign(shapes.size(), 0);
+    boundedOf.assign(shapes.size(), -1);
+    boundedBounds.clear();
+    motion = false;
+    for (const auto& shape : shapes) {
+        motion = motion || shape->isMoving();
+    }
+    for (int shape : boundedShapes) {
+        boundedOf[shape] = static_cast<int>(boundedPrimitives.size());
+        boundedBounds.push_back(shapes[shape]->bounds());
+        boundedPrimitives.push_back(primitives.add(*shapes[shape], shape));
+        shapePrimitives[shape] = boundedPrimitives.back();
+    }
+    for (int shape : unboundedShapes) {
+        unboundedPrimitives.push_back(primitives.add(*shapes[shape], shape));
+        shapePrimitives[shape] = unboundedPrimitives.back();
+    }
+}
+
+int Scene::insertShape(const string& name, unique_ptr<GeometricShape> shape, int material) {
+    const int index = addShape(name, std::move(shape), material);
+    const GeometricShape& added = *shapes[index];
+    if (shapePrimitives.size() + 1 != shapes.size() || bvh.moving() || added.isMoving()) {
+        build();
+        return index;
+    }
+
+    const PrimitiveStore::Ref ref = primitives.add(added, index);
+    shapePrimitives.push_back(ref);
+    if (!added.isBounded()) {
+        boundedOf.push_back(-1);
+        unboundedShapes.push_back(index);
+        unboundedPrimitives.push_back(ref);
+        return index;
+    }
+
+    const int prim = static_cast<int>(boundedShapes.size());
+    boundedOf.push_back(prim);
+    boundedShapes.push_back(index);
+    boundedPrimitives.push_back(ref);
+    boundedBounds.push_back(added.bounds());
+    bvh.insert(prim, boundedBounds);
+    return index;
+}
+
+void Scene::replaceShape(int shape, unique_ptr<GeometricShape> geometry) {
+    if (shape < 0 || shape >= static_cast<int>(shapes.size()) || !geometry) {
+        throw invalid_argument("Forma inexistente");
+    }
+    if (bvh.moving() || geometry->isMoving() || geometry->isBounded() != shapes[shape]->isBounded()) {
+        shapes[shape] = std::move(geometry);
+        build();
+        return;
+    }
+
+    // The store points to the new geometry before the old one goes
+    const PrimitiveStore::Ref ref = primitives.replace(shapePrimitives[shape], *geometry);
+    shapes[shape] = std::move(geometry);
+    shapePrimitives[shape] = ref;
+
+    const int prim = boundedOf[shape];
+    if (prim < 0) {
+        size_t position = find(unboundedShapes.begin(), unboundedShapes.end(), shape) - unboundedShapes.begin();
+        unboundedPrimitives[position] = ref;
+        return;
+    }
+    boundedPrimitives[prim] = ref;
+    boundedBounds[prim] = shapes[shape]->bounds();
+    bvh.refit(prim, boundedBounds);
+}
+
+void Scene::removeShape(int shape) {
+    if (shape < 0 || shape >= static_cast<int>(shapes.size())) {
+        throw invalid_argument("Forma inexistente");
+    }
+    const bool rebuild = bvh.moving();
+
+    // Out of the BVH, where the last primitive takes its number
+    const int prim = boundedOf[shape];
+    if (prim >= 0) {
+        const int lastPrim = static_cast<int>(boundedShapes.size()) - 1;
+        if (!rebuild) {
+            bvh.remove(prim, boundedBounds);
+            bvh.renumber(lastPrim, prim);
+        }
+        boundedShapes[prim] = boundedShapes[lastPrim];
+        boundedPrimitives[prim] = boundedPrimitives[lastPrim];
+        boundedBounds[prim] = boundedBounds[lastPrim];
+        boundedOf[boundedShapes[prim]] = prim;
+        boundedShapes.pop_back();
+        boundedPrimitives.pop_back();
+        boundedBounds.pop_back();
+    } else {
+        size_t position = find(unboundedShapes.begin(), unboundedShapes.end(), shape) - unboundedShapes.begin();
+        unboundedShapes.erase(unboundedShapes.begin() + position);
+        unboundedPrimitives.erase(unboundedPrimitives.begin() + position);
+    }
+
+    // The last shape moves to the freed index
+    shapeIndex.erase(names[shape]);
+    const int last = static_cast<int>(shapes.size()) - 1;
+    if (shape != last) {
+        shapes[shape] = std::move(shapes[last]);
+        names[shape] = std::move(names[last]);
+        shapeMaterials[shape] = shapeMaterials[last];
+        shapePrimitives[shape] = shapePrimitives[last];
+        boundedOf[shape] = boundedOf[last];
+        shapeIndex[names[shape]] = shape;
+        primitives.setShape(shapePrimitives[shape], shape);
+        if (boundedOf[shape] >= 0) {
+            boundedShapes[boundedOf[shape]] = shape;
+        } else {
+            *find(unboundedShapes.begin(), unboundedShapes.end(), last) = shape;
+        }
+    }
+    shapes.pop_back();
+    names.pop_back();
+    shapeMaterials.pop_back();
+    shapePrimitives.pop_back();
+    boundedOf.pop_back();
+
+    if (rebuild) {
+        build();
+    }
+}
+
+bool Scene::closestHit(const Ray& ray, double tMin, double tMax, HitRecord& hit) const {
+    if (primitives.precision == PrimitiveStore::Precision::Float) {
+        const FloatRay floatRay(ray.o.x(), ray.o.y(), ray.o.z(), ray.d.x(), ray.d.y(), ray.d.z());
+        return closestHitWith(ray, tMin, tMax, hit, [&](PrimitiveStore::Ref ref, double tFar) {
+            return primitives.closestHit(ref, ray, floatRay, tMin, tFar, hit);
+        });
+    }
+    return closestHitWith(ray, tMin, tMax, hit, [&](PrimitiveStore::Ref ref, double tFar) {
+        return primitives.closestHit(ref, ray, tMin, tFar, hit);
+    });
+}
+
+bool Scene::occluded(const Ray& ray, double tMin, double tMax, int* occluder) const {
+    int blocker = -1;
+    for (PrimitiveStore::Ref ref : unboundedPrimitives) {
+        if (primitives.occludes(ref, ray, tMin, tMax)) {
+            blocker = primitives.shapeOf(ref);
+            break;
+        }
+    }
+    if (blocker < 0) {
+        bvh.traverseAny(ray, tMin, tMax, [&](int prim) {
+            if (!primitives.occludes(boundedPrimitives[prim], ray, tMin, tMax)) {
+                return false;
+            }
+            blocker = primitives.shapeOf(boundedPrimitives[prim]);
+            return true;
+        });
+    }
+    if (occluder) {
+        *occluder = blocker;
+    }
+    return blocker >= 0;
+}
+
+void Scene::intersectPacket(RayPacket& packet, double tMin) const {
+    // Incoherent rays would drag each other through unrelated nodes: trace them one by one
+    if (!packet.coherent()) {
+        for (int i = 0; i < RayPacket::SIZE; ++i) {
+            HitRecord hit;
+            if ((packet.active & (1u << i)) && closestHit(packet.ray(i), tMin, packet.t[i], hit)) {
+                packet.t[i] = hit.t;
+                packet.nx[i] = hit.normal.x();
+                packet.ny[i] = hit.normal.y();
+                packet.nz[i] = hit.normal.z();
+                packet.shape[i] = hit.shape;
+                packet.offset[i] = hit.offset;
+                packet.px[i] = hit.point.x();
+                packet.py[i] = hit.point.y();
+                packet.pz[i] = hit.point.z();
+            }
+        }
+        return;
+    }
+
+    if (primitives.precision == PrimitiveStore::Precision::Float) {
+        FloatRayPacket floatRays(packet);
+        bvh.traversePacket(packet, packet.active, tMin, [&](int prim, RayPacket::Mask lanes) {
+            primitives.intersectPacket(boundedPrimitives[prim], floatRays, packet, lanes, tMin);
+        });
+        for (PrimitiveStore::Ref ref : unboundedPrimitives) {
+            primitives.intersectPacket(ref, floatRays, packet, packet.active, tMin);
+        }
+        floatRays.merge(packet);
+        return;
+    }
+
+    bvh.traversePacket(packet, packet.active, tMin, [&](int prim, RayPacket::Mask lanes) {
+        primitives.intersectPacket(boundedPrimitives[prim], packet, lanes, tMin);
+    });
+
+    for (PrimitiveStore::Ref ref : unboundedPrimitives) {
+        primitives.intersectPacket(ref, packet, packet.active, tMin);
+    }
+}
@@ -0,0 +1,168 @@
+#ifndef SCENE_HPP
+#define SCENE_HPP
+
+#include "../geometry/geometry.hpp"
+#include "../geometry/geometric_shape.hpp"
+#include "../geometry/bvh.hpp"
+#include "../geometry/primitive_store.hpp"
+#include "../imaging/image.hpp"
+#include "../ray.hpp"
+#include "../ray_packet.hpp"
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+enum class MaterialType { Diffuse, Specular, Dielectric };
+
+struct Material {
+    std::string name;
+    MaterialType type = MaterialType::Diffuse;
+    PixelRGB albedo = PixelRGB(0.8, 0.8, 0.8);
+    PixelRGB emission;  // Non black for emitters (area lights)
+    double ior = 1.5;   // Index of refraction, only used by dielectrics
+};
+
+struct PointLight {
+    Point position;
+    PixelRGB power;
+};
+
+struct CameraSettings {
+    Point position = Point(0, 0, -5);
+    Point lookAt = Point(0, 0, 0);
+    Direction up = Direction(0, 1, 0);
+    double fov = 60.0; // Vertical field of view in degrees
+};
+
+struct RenderSettings {
+    int width = 640;
+    int height = 480;
+    int samplesPerPixel = 1;
+    int maxDepth = 8;
+    std::string output = "render.exr";
+};
+
+class Scene {
+    public:
+        std::vector<std::unique_ptr<GeometricShape>> shapes;
+        std::vector<std::string> names;      // Unique name of every shape
+        std::vector<int> shapeMaterials;     // Material index of every shape
+        std::vector<Material> materials;     // materials[0] is the default material
+        std::vector<PointLight> lights;
+        CameraSettings camera;
+        RenderSettings settings;
+
+        // Geometry shared by instances, not rendered on its own
+        std::vector<std::shared_ptr<const GeometricShape>> objects;
+        std::vector<std::string> objectNames;
+
+        // Files the scene was built from (scene file first, then meshes)
+        std::vector<std::string> sources;
+
+        // Acceleration structure over the bounded shapes
+        BVH bvh;
+        std::vector<int> boundedShapes;   // BVH primitive -> shape index
+        std::vector<int> unboundedShapes; // Shapes tested outside the BVH (planes)
+        std::vector<int> boundedOf;       // Shape index -> BVH primitive, -1 for unbounded shapes
+        std::vector<BoundingBox> boundedBounds; // BVH primitive -> bounds, for the incremental updates
+
+        // Copy of the shapes sorted by type, which is what the traversal
+        // intersects (shapes stays the owner and the public view)
+        PrimitiveStore primitives;
+        std::vector<PrimitiveStore::Ref> boundedPrimitives;   // BVH primitive -> store
+        std::vector<PrimitiveStore::Ref> unboundedPrimitives; // Same order as unboundedShapes
+        std::vector<PrimitiveStore::Ref> shapePrimitives;     // Shape index -> store
+
+        // Some shape moves during the exposure, so rays need a time (Ray::time)
+        bool motion = false;
+
+        Scene();
+
+        // Returns the index of the new shape. Throws if the name is already in use
+        int addShape(const std::string& name, std::unique_ptr<GeometricShape> shape, int material = 0);
+
+        // Returns the index of the new material. Throws if the name is already in use
+        int addMaterial(const Material& material);
+
+        // Returns the index of the new object. Throws if the name is already in use
+        int addObject(const std::string& name, std::shared_ptr<const GeometricShape> object);
+
+        // -1 if not found
+        int findShape(const std::string& name) const;
+        int findMaterial(const std::string& name) const;
+        int findObject(const std::string& name) const;
+
+        // Builds the acceleration structure. Must be called after adding shapes
+        void build();
+
+        // Fills primitives from shapes, boundedShapes and unboundedShapes, and
+        // sets motion. Called by build(), and by the scene cache after loading a built BVH.
+        void buildPrimitives();
+
+        // Changes to a built scene that update the BVH in place (BVH::insert,
+        // remove and refit) instead of rebuilding it, so they cost in
+        // proportion to the change and not to the size of the scene. Scenes
+        // with moving shapes are rebuilt instead. Primitives replaced or
+        // removed leave an unused slot in the store until the next build().
+
+        // addShape on a built scene, which stays built. Throws if the name is already in use
+        int insertShape(const std::string& name, std::unique_ptr<GeometricShape> shape, int material = 0);
+
+        // Puts new geometry (typically the same shape moved) in place of a shape
+        void replaceShape(int shape, std::unique_ptr<GeometricShape> geometry);
+
+        // Removes a shape; the last shape takes its index
+        void removeShape(int shape);
+
+        // Closest hit among all shapes with t in [tMin, tMax]; hit.shape is set
+        bool closestHit(const Ray& ray, double tMin, double tMax, HitRecord& hit) const;
+
+        // Closest hit of every active lane of the packet with t in [tMin, packet.t[lane]].
+        // Incoherent packets fall back to single ray traversal.
+        void intersectPacket(RayPacket& packet, double tMin) const;
+
+        // Whether any shape blocks the ray with t in [tMin, tMax]. The traversal
+        // stops at the first blocker found, not the closest one; its shape
+        // index goes to occluder when given.
+        bool occluded(const Ray& ray, double tMin, double tMax, int* occluder = nullptr) const;
+
+        // Same query against a single shape
+        bool occludedBy(int shape, const Ray& ray, double tMin, double tMax) const {
+            return primitives.occludes(shapePrimitives[shape], ray, tMin, tMax);
+        }
+
+        const Material& materialOf(const HitRecord& hit) const { return materials[shapeMaterials[hit.shape]]; }
+
+    private:
+        // BVH traversal and unbounded shapes of closestHit, with the primitive
+        // test intersect(ref, tFar) of the chosen precision
+        template <typename Intersect>
+        bool closestHitWith(const Ray& ray, double tMin, double tMax, HitRecord& hit, const Intersect& intersect) const {
+            bool found = false;
+
+            bvh.traverse(ray, tMin, tMax, [&](int prim, double& tFar) {
+                if (intersect(boundedPrimitives[prim], tFar)) {
+                    tFar = hit.t;
+                    found = true;
+                    return true;
+                }
+                return false;
+            });
+
+            for (PrimitiveStore::Ref ref : unboundedPrimitives) {
+                if (intersect(ref, tMax)) {
+                    tMax = hit.t;
+                    found = true;
+                }
+            }
+
+            return found;
+        }
+
+        std::map<std::string, int> shapeIndex;
+        std::map<std::string, int> materialIndex;
+        std::map<std::string, int> objectIndex;
+};
+
+#endif // SCENE_HPP
@@ -0,0 +1,545 @@
+#include "scene_cache.hpp"
+#include "../geometry/sphere.hpp"
+#include "../geometry/plane.hpp"
+#include "../geometry/triangle.hpp"
+#include "../geometry/box.hpp"
+#include "../geometry/cylinder.hpp"
+#include "../geometry/disc.hpp"
+#include "../geometry/quadric.hpp"
+#include "../geometry/mesh.hpp"
+#include "../geometry/instance.hpp"
+#include "../geometry/moving_shape.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <type_traits>
+#include <sys/stat.h>
+
+using namespace std;
+
+namespace {
+
+const char CACHE_MAGIC[8] = { 'I', 'N', 'F', 'G', 'R', 'S', 'C', 'N' };
+const uint32_t CACHE_VERSION = 3;
+
+// New kinds go at the end, so older caches keep their meaning
+enum class ShapeKind : uint8_t { Sphere, Plane, Triangle, Mesh, Instance, Box, Cone, Cylinder, Disc, Quadric, Moving };
+
+// Size and modification time identify the version of a source file
+struct FileStamp {
+    int64_t size = -1;
+    int64_t mtime = -1; // Nanoseconds
+
+    bool operator==(const FileStamp& other) const { return size == other.size && mtime == other.mtime; }
+};
+
+FileStamp stampOf(const string& path) {
+    FileStamp stamp;
+    struct stat st;
+    if (stat(path.c_str(), &st) == 0) {
+        stamp.size = st.st_size;
+        stamp.mtime = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+    }
+    return stamp;
+}
+
+class Writer {
+    public:
+        Writer(const string& filename) : out(filename, ios::binary) {
+            if (!out) {
+                throw runtime_error("Cannot open file for writing: " + filename);
+            }
+        }
+
+        template <typename T>
+        void pod(const T& value) {
+            static_assert(is_trivially_copyable<T>::value, "POD values only");
+            out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+
+        template <typename T>
+        void array(const vector<T>& values) {
+            static_assert(is_trivially_copyable<T>::value, "POD values only");
+            pod<uint64_t>(values.size());
+            out.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+        }
+
+        void str(const string& value) {
+            pod<uint64_t>(value.size());
+            out.write(value.data(), value.size());
+        }
+
+        void vec(const Vector3d& v) { pod(v.x()); pod(v.y()); pod(v.z()); }
+        void matrix(const Matrix4d& m) {
+            for (int i = 0; i < 16; ++i) {
+                pod(m(i / 4, i % 4));
+            }
+        }
+        void color(const PixelRGB& c) { pod(c.R); pod(c.G); pod(c.B); }
+
+        void box(const BoundingBox& b) { vec(b.min); vec(b.max); }
+
+        void bvh(const BVH& tree) {
+            pod<uint64_t>(tree.nodes.size());
+            for (const auto& node : tree.nodes) {
+                box(node.box);
+                pod<int32_t>(node.leftFirst);
+                pod<int32_t>(node.count);
+            }
+            array(tree.primIndices);
+            pod<uint64_t>(tree.closeBoxes.size());
+            for (const auto& b : tree.closeBoxes) {
+                box(b);
+            }
+        }
+
+        void finish() {
+            out.flush();
+            if (!out) {
+                throw runtime_error("Error writing scene cache");
+            }
+        }
+
+    private:
+        ofstream out;
+};
+
+class Reader {
+    public:
+        Reader(const string& filename) : in(filename, ios::binary) {}
+
+        bool ok() const { return static_cast<bool>(in); }
+
+        template <typename T>
+        T pod() {
+            T value{};
+            in.read(reinterpret_cast<char*>(&value), sizeof(T));
+            check();
+            return value;
+        }
+
+        template <typename T>
+        vector<T> array() {
+            uint64_t size = pod<uint64_t>();
+            checkSize(size * sizeof(T));
+            vector<T> values(size);
+            in.read(reinterpret_cast<char*>(values.data()), size * sizeof(T));
+            check();
+            return values;
+        }
+
+        string str() {
+            uint64_t size = pod<uint64_t>();
+            checkSize(size);
+            string value(size, '\0');
+            in.read(&value[0], size);
+            check();
+            return value;
+        }
+
+        Vector3d vec() {
+            double x = pod<double>(), y = pod<double>(), z = pod<double>();
+            return Vector3d(x, y, z);
+        }
+
+        PixelRGB color() {
+            double r = pod<double>(), g = pod<double>(), b = pod<double>();
+            return PixelRGB(r, g, b);
+        }
+
+        Matrix4d matrix() {
+            Matrix4d m;
+            for (int i = 0; i < 16; ++i) {
+                m(i / 4, i % 4) = pod<double>();
+            }
+            return m;
+        }
+
+        BoundingBox box() {
+            Vector3d lo = vec();
+            Vector3d hi = vec();
+            return BoundingBox(lo, hi);
+        }
+
+        BVH bvh() {
+            BVH tree;
+            uint64_t numNodes = pod<uint64_t>();
+            checkSize(numNodes * 56);
+            tree.nodes.resize(numNodes);
+            for (auto& node : tree.nodes) {
+                node.box = box();
+                node.leftFirst = pod<int32_t>();
+                node.count = pod<int32_t>();
+            }
+            tree.primIndices = array<int>();
+            uint64_t numCloseBoxes = pod<uint64_t>();
+            if (numCloseBoxes != 0 && numCloseBoxes != numNodes) {
+                throw runtime_error("Scene cache is corrupted");
+            }
+            tree.closeBoxes.resize(numCloseBoxes);
+            for (auto& b : tree.closeBoxes) {
+                b = box();
+            }
+            return tree;
+        }
+
+        // Guards against allocating absurd sizes out of a corrupted file
+        void checkSize(uint64_t bytes) {
+            streampos here = in.tellg();
+            in.seekg(0, ios::end);
+            streampos end = in.tellg();
+            in.seekg(here);
+            if (bytes > static_cast<uint64_t>(end - here)) {
+                throw runtime_error("Scene cache is corrupted");
+            }
+        }
+
+    private:
+        ifstream in;
+
+        void check() {
+            if (!in) {
+                throw runtime_error("Scene cache is truncated");
+            }
+        }
+};
+
+void writeShape(Writer& w, const GeometricShape* shape, const string& name,
+                const map<const GeometricShape*, int>& objectIndex) {
+    if (auto sphere = dynamic_cast<const Sphere*>(shape)) {
+        w.pod(ShapeKind::Sphere);
+        w.vec(sphere->center.coords);
+        w.pod(sphere->radius);
+    } else if (auto plane = dynamic_cast<const Plane*>(shape)) {
+        w.pod(ShapeKind::Plane);
+        w.vec(plane->normal.d);
+        w.vec(plane->origin.coords);
+    } else if (auto triangle = dynamic_cast<const Triangle*>(shape)) {
+        w.pod(ShapeKind::Triangle);
+        w.vec(triangle->v0.coords);
+        w.vec(triangle->v1.coords);
+        w.vec(triangle->v2.coords);
+    } else if (auto box = dynamic_cast<const Box*>(shape)) {
+        w.pod(ShapeKind::Box);
+        w.vec(box->frame.origin().coords);
+        w.vec(box->frame.u().d);
+        w.vec(box->frame.v().d);
+        w.vec(box->half);
+    } else if (auto cylinder = dynamic_cast<const Cylinder*>(shape)) {
+        // Before Cone, which it derives from
+        w.pod(ShapeKind::Cylinder);
+        w.vec(cylinder->base.coords);
+        w.vec(cylinder->top.coords);
+        w.pod(cylinder->radius());
+    } else if (auto cone = dynamic_cast<const Cone*>(shape)) {
+        w.pod(ShapeKind::Cone);
+        w.vec(cone->base.coords);
+        w.vec(cone->top.coords);
+        w.pod(cone->baseRadius);
+        w.pod(cone->topRadius);
+    } else if (auto disc = dynamic_cast<const Disc*>(shape)) {
+        w.pod(ShapeKind::Disc);
+        w.vec(disc->center.coords);
+        w.vec(disc->normal.d);
+        w.pod(disc->radius);
+    } else if (auto quadric = dynamic_cast<const Quadric*>(shape)) {
+        w.pod(ShapeKind::Quadric);
+        w.pod(quadric->coefficients);
+        w.vec(quadric->clip.min);
+        w.vec(quadric->clip.max);
+    } else if (auto mesh = dynamic_cast<const Mesh*>(shape)) {
+        w.pod(ShapeKind::Mesh);
+        w.pod<uint64_t>(mesh->vertices.size());
+        for (const auto& v : mesh->vertices) {
+            w.vec(v.coords);
+        }
+        w.array(mesh->faces);
+        w.bvh(mesh->bvh);
+    } else if (auto instance = dynamic_cast<const Instance*>(shape)) {
+        // Objects are written before the shapes, so they are referenced by index
+        auto it = objectIndex.find(instance->object.get());
+        if (it == objectIndex.end()) {
+            throw runtime_error("Shape '" + name + "' instances an object outside the scene");
+        }
+        w.pod(ShapeKind::Instance);
+        w.pod<int32_t>(it->second);
+        w.matrix(instance->transformation_matrix);
+    } else if (auto moving = dynamic_cast<const MovingShape*>(shape)) {
+        w.pod(ShapeKind::Moving);
+        w.vec(moving->motion.offset);
+        w.vec(moving->motion.center);
+        w.vec(moving->motion.axis);
+        w.pod(moving->motion.angle);
+        writeShape(w, moving->shape.get(), name, objectIndex);
+    } else {
+        throw runtime_error("Shape '" + name + "' cannot be cached");
+    }
+}
+
+// Null for an unknown kind
+unique_ptr<GeometricShape> readShape(Reader& r, const vector<shared_ptr<const GeometricShape>>& objects) {
+    switch (r.pod<ShapeKind>()) {
+        case ShapeKind::Sphere: {
+            Point center(r.vec());
+            double radius = r.pod<double>();
+            return make_unique<Sphere>(center, radius);
+        }
+        case ShapeKind::Plane: {
+            Direction normal(r.vec());
+            Point origin(r.vec());
+            return make_unique<Plane>(normal, origin);
+        }
+        case ShapeKind::Triangle: {
+            Point v0(r.vec()), v1(r.vec()), v2(r.vec());
+            return make_unique<Triangle>(v0, v1, v2);
+        }
+        case ShapeKind::Mesh: {
+            uint64_t numVertices = r.pod<uint64_t>();
+            r.checkSize(numVertices * 3 * sizeof(double));
+            vector<Point> vertices(numVertices);
+            for (auto& v : vertices) {
+                v = Point(r.vec());
+            }
+            vector<array<int, 3>> faces = r.array<array<int, 3>>();
+            BVH bvh = r.bvh();
+            return make_unique<Mesh>(std::move(vertices), std::move(faces), std::move(bvh));
+        }
+        case ShapeKind::Instance: {
+            int object = r.pod<int32_t>();
+            Matrix4d transform = r.matrix();
+            if (object < 0 || object >= static_cast<int>(objects.size())) {
+                return nullptr;
+            }
+            return make_unique<Instance>(objects[object], transform);
+        }
+        case ShapeKind::Box: {
+            Point center(r.vec());
+            Direction u(r.vec()), v(r.vec());
+            Vector3d half = r.vec();
+            return make_unique<Box>(center, u, v, half);
+        }
+        case ShapeKind::Cone: {
+            Point base(r.vec()), top(r.vec());
+            double baseRadius = r.pod<double>();
+            double topRadius = r.pod<double>();
+            return make_unique<Cone>(base, top, baseRadius, topRadius);
+        }
+        case ShapeKind::Cylinder: {
+            Point base(r.vec()), top(r.vec());
+            double radius = r.pod<double>();
+            return make_unique<Cylinder>(base, top, radius);
+        }
+        case ShapeKind::Disc: {
+            Point center(r.vec());
+            Direction normal(r.vec());
+            double radius = r.pod<double>();
+            return make_unique<Disc>(center, normal, radius);
+        }
+        case ShapeKind::Quadric: {
+            array<double, 10> coefficients = r.pod<array<double, 10>>();
+            Vector3d min = r.vec(), max = r.vec();
+            return make_unique<Quadric>(coefficients, BoundingBox(min, max));
+        }
+        case ShapeKind::Moving: {
+            Motion motion;
+            motion.offset = r.vec();
+            motion.center = r.vec();
+            motion.axis = r.vec();
+            motion.angle = r.pod<double>();
+            shared_ptr<const GeometricShape> shape = readShape(r, objects);
+            if (!shape) {
+                return nullptr;
+            }
+            return make_unique<MovingShape>(std::move(shape), motion);
+        }
+    }
+    return nullptr;
+}
+
+} // namespace
+
+std::string sceneCachePath(const std::string& sceneFile) {
+    return sceneFile + ".cache";
+}
+
+void writeSceneCache(const std::string& cacheFile, const Scene& scene) {
+    // Write to a temporary file first so a crash never leaves a broken cache
+    const string tmpFile = cacheFile + ".tmp";
+    {
+        Writer w(tmpFile);
+        w.pod(CACHE_MAGIC);
+        w.pod(CACHE_VERSION);
+
+        w.pod<uint32_t>(scene.sources.size());
+        for (const auto& source : scene.sources) {
+            FileStamp stamp = stampOf(source);
+            w.str(source);
+            w.pod(stamp.size);
+            w.pod(stamp.mtime);
+        }
+
+        // Settings and camera
+        w.pod<int32_t>(scene.settings.width);
+        w.pod<int32_t>(scene.settings.height);
+        w.pod<int32_t>(scene.settings.samplesPerPixel);
+        w.pod<int32_t>(scene.settings.maxDepth);
+        w.str(scene.settings.output);
+        w.vec(scene.camera.position.coords);
+        w.vec(scene.camera.lookAt.coords);
+        w.vec(scene.camera.up.d);
+        w.pod(scene.camera.fov);
+
+        // Materials (the default one included) and lights
+        w.pod<uint32_t>(scene.materials.size());
+        for (const auto& material : scene.materials) {
+            w.str(material.name);
+            w.pod<uint8_t>(static_cast<uint8_t>(material.type));
+            w.color(material.albedo);
+            w.color(material.emission);
+            w.pod(material.ior);
+        }
+        w.pod<uint32_t>(scene.lights.size());
+        for (const auto& light : scene.lights) {
+            w.vec(light.position.coords);
+            w.color(light.power);
+        }
+
+        // Objects shared by instances, then the shapes
+        map<const GeometricShape*, int> objectIndex;
+        w.pod<uint32_t>(scene.objects.size());
+        for (size_t i = 0; i < scene.objects.size(); ++i) {
+            w.str(scene.objectNames[i]);
+            writeShape(w, scene.objects[i].get(), scene.objectNames[i], objectIndex);
+            objectIndex[scene.objects[i].get()] = static_cast<int>(i);
+        }
+
+        w.pod<uint32_t>(scene.shapes.size());
+        for (size_t i = 0; i < scene.shapes.size(); ++i) {
+            w.str(scene.names[i]);
+            w.pod<int32_t>(scene.shapeMaterials[i]);
+
+            writeShape(w, scene.shapes[i].get(), scene.names[i], objectIndex);
+        }
+
+        // Top level acceleration structure
+        w.bvh(scene.bvh);
+        w.array(scene.boundedShapes);
+        w.array(scene.unboundedShapes);
+        w.finish();
+    }
+
+    if (rename(tmpFile.c_str(), cacheFile.c_str()) != 0) {
+        remove(tmpFile.c_str());
+        throw runtime_error("Cannot write scene cache: " + cacheFile);
+    }
+}
+
+bool readSceneCache(const std::string& cacheFile, Scene& scene) {
+    Reader r(cacheFile);
+    if (!r.ok()) {
+        return false;
+    }
+
+    try {
+        char magic[sizeof(CACHE_MAGIC)];
+        for (char& c : magic) {
+            c = r.pod<char>();
+        }
+        if (memcmp(magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 || r.pod<uint32_t>() != CACHE_VERSION) {
+            return false;
+        }
+
+        // Stale as soon as one source changed
+        Scene result;
+        uint32_t numSources = r.pod<uint32_t>();
+        for (uint32_t i = 0; i < numSources; ++i) {
+            string source = r.str();
+            FileStamp stamp;
+            stamp.size = r.pod<int64_t>();
+            stamp.mtime = r.pod<int64_t>();
+            if (!(stampOf(source) == stamp)) {
+                return false;
+            }
+            result.sources.push_back(source);
+        }
+
+        result.settings.width = r.pod<int32_t>();
+        result.settings.height = r.pod<int32_t>();
+        result.settings.samplesPerPixel = r.pod<int32_t>();
+        result.settings.maxDepth = r.pod<int32_t>();
+        result.settings.output = r.str();
+        result.camera.position = Point(r.vec());
+        result.camera.lookAt = Point(r.vec());
+        result.camera.up = Direction(r.vec());
+        result.camera.fov = r.pod<double>();
+
+        uint32_t numMaterials = r.pod<uint32_t>();
+        for (uint32_t i = 0; i < numMaterials; ++i) {
+            Material material;
+            material.name = r.str();
+            material.type = static_cast<MaterialType>(r.pod<uint8_t>());
+            material.albedo = r.color();
+            material.emission = r.color();
+            material.ior = r.pod<double>();
+            if (i == 0) {
+                result.materials[0] = material; // Default material, already present
+            } else {
+                result.addMaterial(material);
+            }
+        }
+        uint32_t numLights = r.pod<uint32_t>();
+        for (uint32_t i = 0; i < numLights; ++i) {
+            PointLight light;
+            light.position = Point(r.vec());
+            light.power = r.color();
+            result.lights.push_back(light);
+        }
+
+        uint32_t numObjects = r.pod<uint32_t>();
+        for (uint32_t i = 0; i < numObjects; ++i) {
+            string name = r.str();
+            unique_ptr<GeometricShape> object = readShape(r, result.objects);
+            if (!object) {
+                return false;
+            }
+            result.addObject(name, std::move(object));
+        }
+
+        uint32_t numShapes = r.pod<uint32_t>();
+        for (uint32_t i = 0; i < numShapes; ++i) {
+            string name = r.str();
+            int material = r.pod<int32_t>();
+            if (material < 0 || material >= static_cast<int>(result.materials.size())) {
+                return false;
+            }
+            unique_ptr<GeometricShape> shape = readShape(r, result.objects);
+            if (!shape) {
+                return false;
+            }
+            result.addShape(name, std::move(shape), material);
+        }
+
+        result.bvh = r.bvh();
+        result.boundedShapes = r.array<int>();
+        result.unboundedShapes = r.array<int>();
+        auto outOfRange = [](const vector<int>& indices, size_t size) {
+            return any_of(indices.begin(), indices.end(),
+                          [size](int i) { return i < 0 || static_cast<size_t>(i) >= size; });
+        };
+        if (outOfRange(result.boundedShapes, numShapes) || outOfRange(result.unboundedShapes, numShapes) ||
+            outOfRange(result.bvh.primIndices, result.boundedShapes.size())) {
+            return false;
+        }
+        result.buildPrimitives();
+
+        scene = std::move(result);
+        return true;
+    } catch (const exception&) {
+        // Corrupted or truncated cache: just rebuild the scene
+        return false;
+    }
+}
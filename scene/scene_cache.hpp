@@ -0,0 +1,21 @@
+#ifndef SCENE_CACHE_HPP
+#define SCENE_CACHE_HPP
+
+#include "scene.hpp"
+#include <string>
+
+// Binary snapshot of a parsed and built scene (shapes, materials, lights,
+// settings and every BVH), so restarts skip parsing, mesh import and BVH
+// construction. The cache records size and modification time of every source
+// file and is ignored as soon as one of them changes. It is written in native
+// byte order and is meant to be reused only on the machine that wrote it.
+
+// Cache file used for a scene file
+std::string sceneCachePath(const std::string& sceneFile);
+
+// Returns false (leaving scene untouched) if the cache is missing, stale or unreadable
+bool readSceneCache(const std::string& cacheFile, Scene& scene);
+
+void writeSceneCache(const std::string& cacheFile, const Scene& scene);
+
+#endif // SCENE_CACHE_HPP
@@ -0,0 +1,360 @@
+#include "scene_file.hpp"
+#include "scene_cache.hpp"
+#include "../geometry/sphere.hpp"
+#include "../geometry/plane.hpp"
+#include "../geometry/triangle.hpp"
+#include "../geometry/box.hpp"
+#include "../geometry/cylinder.hpp"
+#include "../geometry/disc.hpp"
+#include "../geometry/quadric.hpp"
+#include "../geometry/mesh_loader.hpp"
+#include "../geometry/instance.hpp"
+#include "../geometry/moving_shape.hpp"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+namespace {
+
+// Tokenizer for a single statement, reporting errors with file and line
+class Statement {
+    public:
+        Statement(const string& text, const string& file_, int line_) : tokens(text), file(file_), line(line_) {}
+
+        [[noreturn]] void fail(const string& message) const {
+            throw runtime_error(file + ":" + to_string(line) + ": " + message);
+        }
+
+        bool more() {
+            tokens >> ws;
+            return !tokens.eof();
+        }
+
+        string word() {
+            string value;
+            if (!(tokens >> value)) {
+                fail("falta un argumento");
+            }
+            return value;
+        }
+
+        double number() {
+            double value;
+            if (!(tokens >> value)) {
+                fail("se esperaba un numero");
+            }
+            return value;
+        }
+
+        int integer() {
+            int value;
+            if (!(tokens >> value)) {
+                fail("se esperaba un entero");
+            }
+            return value;
+        }
+
+        Point point() {
+            double x = number(), y = number(), z = number();
+            return Point(x, y, z);
+        }
+
+        Direction direction() {
+            double x = number(), y = number(), z = number();
+            return Direction(x, y, z);
+        }
+
+        PixelRGB color() {
+            double r = number(), g = number(), b = number();
+            return PixelRGB(r, g, b);
+        }
+
+        Vector3d vector() {
+            double x = number(), y = number(), z = number();
+            return Vector3d(x, y, z);
+        }
+
+    private:
+        istringstream tokens;
+        string file;
+        int line;
+};
+
+string directoryOf(const string& path) {
+    size_t slash = path.find_last_of('/');
+    return slash == string::npos ? "" : path.substr(0, slash + 1);
+}
+
+// Material name after a "material" keyword
+int parseMaterialName(Statement& st, const Scene& scene) {
+    string name = st.word();
+    int material = scene.findMaterial(name);
+    if (material < 0) {
+        st.fail("material desconocido '" + name + "'");
+    }
+    return material;
+}
+
+// Arguments of a "move" or "spin" option. False for any other option
+bool parseMotionOption(const string& option, Statement& st, Motion& motion) {
+    if (option == "move") {
+        motion.offset = st.vector();
+    } else if (option == "spin") {
+        motion.center = st.vector();
+        motion.axis = st.vector();
+        motion.angle = st.number() * M_PI / 180.0;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// The shape itself, or the shape moving with motion during the exposure
+unique_ptr<GeometricShape> withMotion(unique_ptr<GeometricShape> shape, const Motion& motion) {
+    if (!motion.moves()) {
+        return shape;
+    }
+    return make_unique<MovingShape>(std::move(shape), motion);
+}
+
+// Optional trailing "material <name>" and motion of a shape statement
+int parseShapeOptions(Statement& st, const Scene& scene, Motion& motion) {
+    int material = 0;
+    while (st.more()) {
+        string option = st.word();
+        if (option == "material") {
+            material = parseMaterialName(st, scene);
+        } else if (!parseMotionOption(option, st, motion)) {
+            st.fail("opcion de forma desconocida '" + option + "'");
+        }
+    }
+    return material;
+}
+
+bool isGeometry(const string& keyword) {
+    return keyword == "sphere" || keyword == "plane" || keyword == "triangle" || keyword == "mesh"
+           || keyword == "box" || keyword == "obox" || keyword == "cylinder" || keyword == "cone"
+           || keyword == "disc" || keyword == "quadric";
+}
+
+// Arguments of a geometry statement (after the name)
+unique_ptr<GeometricShape> parseGeometry(const string& keyword, Statement& st, const string& baseDir, Scene& scene) {
+    if (keyword == "sphere") {
+        Point center = st.point();
+        double radius = st.number();
+        return make_unique<Sphere>(center, radius);
+    } else if (keyword == "plane") {
+        Direction normal = st.direction();
+        Point point = st.point();
+        return make_unique<Plane>(normal.normalized(), point);
+    } else if (keyword == "triangle") {
+        Point v0 = st.point(), v1 = st.point(), v2 = st.point();
+        return make_unique<Triangle>(v0, v1, v2);
+    } else if (keyword == "box") {
+        Point min = st.point(), max = st.point();
+        return make_unique<Box>(min, max);
+    } else if (keyword == "obox") {
+        Point center = st.point();
+        Direction u = st.direction(), v = st.direction();
+        Vector3d half = st.vector();
+        return make_unique<Box>(center, u, v, half);
+    } else if (keyword == "cylinder") {
+        Point base = st.point(), top = st.point();
+        double radius = st.number();
+        return make_unique<Cylinder>(base, top, radius);
+    } else if (keyword == "cone") {
+        Point base = st.point(), top = st.point();
+        double baseRadius = st.number(), topRadius = st.number();
+        return make_unique<Cone>(base, top, baseRadius, topRadius);
+    } else if (keyword == "disc") {
+        Point center = st.point();
+        Direction normal = st.direction();
+        double radius = st.number();
+        return make_unique<Disc>(center, normal, radius);
+    } else if (keyword == "quadric") {
+        array<double, 10> coefficients;
+        for (double& c : coefficients) {
+            c = st.number();
+        }
+        Vector3d min = st.vector(), max = st.vector();
+        return make_unique<Quadric>(coefficients, BoundingBox(min, max));
+    }
+
+    string file = st.word();
+    if (file.empty() || file[0] != '/') {
+        file = baseDir + file;
+    }
+    unique_ptr<Mesh> mesh = loadMesh(file);
+    scene.sources.push_back(file);
+    return mesh;
+}
+
+} // namespace
+
+Scene parseSceneFile(const std::string& filename) {
+    ifstream in(filename);
+    if (!in) {
+        throw runtime_error("Cannot open scene file: " + filename);
+    }
+
+    Scene scene;
+    scene.sources.push_back(filename);
+    const string baseDir = directoryOf(filename);
+
+    string text;
+    int lineNumber = 0;
+    while (getline(in, text)) {
+        ++lineNumber;
+        size_t comment = text.find('#');
+        if (comment != string::npos) {
+            text.erase(comment);
+        }
+
+        Statement st(text, filename, lineNumber);
+        if (!st.more()) {
+            continue;
+        }
+
+        try {
+            string keyword = st.word();
+            if (keyword == "camera") {
+                scene.camera.position = st.point();
+                scene.camera.lookAt = st.point();
+                scene.camera.up = st.direction();
+                scene.camera.fov = st.number();
+            } else if (keyword == "resolution") {
+                scene.settings.width = st.integer();
+                scene.settings.height = st.integer();
+                if (scene.settings.width <= 0 || scene.settings.height <= 0) {
+                    st.fail("la resolucion debe ser positiva");
+                }
+            } else if (keyword == "samples") {
+                scene.settings.samplesPerPixel = st.integer();
+                if (scene.settings.samplesPerPixel < 1) {
+                    st.fail("las muestras por pixel deben ser al menos 1");
+                }
+            } else if (keyword == "depth") {
+                scene.settings.maxDepth = st.integer();
+                if (scene.settings.maxDepth < 0) {
+                    st.fail("la profundidad no puede ser negativa");
+                }
+            } else if (keyword == "output") {
+                scene.settings.output = st.word();
+            } else if (keyword == "material") {
+                Material material;
+                material.name = st.word();
+                string type = st.word();
+                if (type == "diffuse") {
+                    material.type = MaterialType::Diffuse;
+                } else if (type == "specular") {
+                    material.type = MaterialType::Specular;
+                } else if (type == "dielectric") {
+                    material.type = MaterialType::Dielectric;
+                } else {
+                    st.fail("tipo de material desconocido '" + type + "'");
+                }
+                while (st.more()) {
+                    string option = st.word();
+                    if (option == "albedo") {
+                        material.albedo = st.color();
+                    } else if (option == "emission") {
+                        material.emission = st.color();
+                    } else if (option == "ior") {
+                        material.ior = st.number();
+                    } else {
+                        st.fail("opcion de material desconocida '" + option + "'");
+                    }
+                }
+                scene.addMaterial(material);
+            } else if (isGeometry(keyword)) {
+                string name = st.word();
+                unique_ptr<GeometricShape> shape = parseGeometry(keyword, st, baseDir, scene);
+                Motion motion;
+                int material = parseShapeOptions(st, scene, motion);
+                scene.addShape(name, withMotion(std::move(shape), motion), material);
+            } else if (keyword == "object") {
+                string name = st.word();
+                string type = st.word();
+                if (!isGeometry(type)) {
+                    st.fail("tipo de objeto desconocido '" + type + "'");
+                }
+                scene.addObject(name, parseGeometry(type, st, baseDir, scene));
+            } else if (keyword == "instance") {
+                string name = st.word();
+                string objectName = st.word();
+                int object = scene.findObject(objectName);
+                if (object < 0) {
+                    st.fail("objeto desconocido '" + objectName + "'");
+                }
+
+                Matrix4d transform = Matrix4d::Identity();
+                Motion motion;
+                int material = 0;
+                while (st.more()) {
+                    string option = st.word();
+                    if (option == "translate") {
+                        transform = translation(st.vector()) * transform;
+                    } else if (option == "rotate") {
+                        Vector3d axis = st.vector();
+                        transform = rotation(axis, st.number()) * transform;
+                    } else if (option == "scale") {
+                        transform = scaling(st.vector()) * transform;
+                    } else if (option == "material") {
+                        material = parseMaterialName(st, scene);
+                    } else if (!parseMotionOption(option, st, motion)) {
+                        st.fail("opcion de instancia desconocida '" + option + "'");
+                    }
+                }
+                scene.addShape(name, withMotion(make_unique<Instance>(scene.objects[object], transform), motion),
+                               material);
+            } else if (keyword == "light") {
+                string type = st.word();
+                if (type != "point") {
+                    st.fail("tipo de luz desconocido '" + type + "'");
+                }
+                PointLight light;
+                light.position = st.point();
+                light.power = st.color();
+                scene.lights.push_back(light);
+            } else {
+                st.fail("sentencia desconocida '" + keyword + "'");
+            }
+
+            if (st.more()) {
+                st.fail("argumentos de sobra al final de la linea");
+            }
+        } catch (const invalid_argument& e) {
+            // Errors raised by the shape/scene constructors
+            st.fail(e.what());
+        }
+    }
+
+    scene.build();
+    return scene;
+}
+
+Scene loadScene(const std::string& filename, bool useCache) {
+    const string cacheFile = sceneCachePath(filename);
+
+    if (useCache) {
+        Scene cached;
+        if (readSceneCache(cacheFile, cached)) {
+            return cached;
+        }
+    }
+
+    Scene scene = parseSceneFile(filename);
+
+    if (useCache) {
+        try {
+            writeSceneCache(cacheFile, scene);
+        } catch (const exception& e) {
+            // A missing cache only costs time on the next run
+            cerr << "Aviso: no se pudo escribir la cache de la escena: " << e.what() << endl;
+        }
+    }
+    return scene;
+}
@@ -0,0 +1,56 @@
+#ifndef SCENE_FILE_HPP
+#define SCENE_FILE_HPP
+
+#include "scene.hpp"
+#include <string>
+
+// Scene description files are plain text, one statement per line ('#' starts
+// a comment). Statements:
+//
+//   camera <position x y z> <look at x y z> <up x y z> <vertical fov degrees>
+//   resolution <width> <height>
+//   samples <samples per pixel>
+//   depth <max path depth>
+//   output <file.exr>
+//   material <name> <diffuse|specular|dielectric> [albedo r g b] [emission r g b] [ior n]
+//   sphere <name> <center x y z> <radius> [options]
+//   plane <name> <normal x y z> <point x y z> [options]
+//   triangle <name> <v0 x y z> <v1 x y z> <v2 x y z> [options]
+//   mesh <name> <file.obj|file.ply> [options]
+//   box <name> <min x y z> <max x y z> [options]
+//   obox <name> <center x y z> <u x y z> <v x y z> <half sizes x y z> [options]
+//   cylinder <name> <base x y z> <top x y z> <radius> [options]
+//   cone <name> <base x y z> <top x y z> <base radius> <top radius> [options]
+//   disc <name> <center x y z> <normal x y z> <radius> [options]
+//   quadric <name> <A B C D E F G H I J> <min x y z> <max x y z> [options]
+//   object <name> <any geometry statement above> <arguments of that statement>
+//   instance <name> <object> [translate x y z] [rotate <axis x y z> <degrees>]
+//            [scale sx sy sz] [options]
+//   light point <position x y z> <power r g b>
+//
+// The options of a shape or instance are any of
+//
+//   material <name>
+//   move <offset x y z>
+//   spin <point on the axis x y z> <axis x y z> <degrees>
+//
+// move and spin make the shape move during the exposure, from where the
+// statement puts it at shutter open: it spins by the given degrees about the
+// axis (right hand rule) and is displaced by the offset by shutter close.
+// The path tracer then samples the time of every path, which blurs it.
+// An oriented box (obox) has half sizes along u, v and u x v; v is made
+// orthogonal to u. Cylinders and cones are closed by their caps. A quadric is
+// the surface A x^2 + B y^2 + C z^2 + D xy + E xz + F yz + G x + H y + I z + J = 0
+// inside the box [min, max].
+// Relative mesh paths are resolved against the directory of the scene file.
+// An object is geometry loaded once and only rendered through instances,
+// which share it. Instance transforms apply in the order they are written.
+
+// Parses a scene file and builds its acceleration structure
+Scene parseSceneFile(const std::string& filename);
+
+// Same as parseSceneFile, but reuses the binary cache next to the scene file
+// when it is up to date (and refreshes it otherwise)
+Scene loadScene(const std::string& filename, bool useCache = true);
+
+#endif // SCENE_FILE_HPP